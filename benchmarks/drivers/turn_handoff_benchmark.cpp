@@ -0,0 +1,97 @@
+/**
+ * @file turn_handoff_benchmark.cpp
+ * Benchmarks for handing the turn over between the main and player drivers
+ */
+
+#include "drivers/shared_memory_utils/shared_buffer.h"
+#include "state/player_state.h"
+#include "benchmark/benchmark.h"
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <thread>
+
+using namespace std;
+using namespace drivers;
+
+namespace {
+
+/**
+ * Burns CPU for the given duration, standing in for the player's turn
+ */
+void SimulatePlayerTurn(chrono::microseconds duration) {
+	auto end = chrono::steady_clock::now() + duration;
+	while (chrono::steady_clock::now() < end)
+		;
+}
+
+/**
+ * Runs the main driver side of the handoff for every benchmark iteration,
+ * with a player thread on the other side of the buffer
+ *
+ * The spin variant is the handoff the drivers used before waiting on the
+ * buffer, it is kept here as a baseline. The cpu_per_wall counter is the
+ * number of cores the process kept busy, the simulated player turn alone
+ * accounts for a little under 1
+ */
+void BM_TurnHandoff(benchmark::State &state, bool use_spin_loop) {
+	auto player_turn = chrono::microseconds(state.range(0));
+	auto buf = make_unique<SharedBuffer>(false, 0, player_state::State());
+	atomic_bool is_done(false);
+	const SharedBuffer::StopCondition stop_condition = [&is_done]() {
+		return static_cast<bool>(is_done);
+	};
+
+	thread player([&]() {
+		int64_t spin_count = SharedBuffer::default_spin_count;
+		while (!is_done) {
+			if (use_spin_loop) {
+				while (!buf->is_player_running && !is_done)
+					;
+			} else if (!buf->WaitForPlayerRunning(true, stop_condition,
+			                                      spin_count)) {
+				break;
+			}
+			SimulatePlayerTurn(player_turn);
+			buf->SetPlayerRunning(false);
+		}
+	});
+
+	int64_t spin_count = SharedBuffer::default_spin_count;
+	clock_t cpu_start = clock();
+	auto wall_start = chrono::steady_clock::now();
+
+	for (auto _ : state) {
+		buf->SetPlayerRunning(true);
+		if (use_spin_loop) {
+			while (buf->is_player_running)
+				;
+		} else {
+			buf->WaitForPlayerRunning(false, stop_condition, spin_count);
+		}
+	}
+
+	double cpu_seconds = static_cast<double>(clock() - cpu_start) /
+	                     CLOCKS_PER_SEC;
+	chrono::duration<double> wall_seconds =
+	    chrono::steady_clock::now() - wall_start;
+
+	is_done = true;
+	buf->Notify();
+	player.join();
+
+	state.counters["cpu_per_wall"] = cpu_seconds / wall_seconds.count();
+}
+}
+
+BENCHMARK_CAPTURE(BM_TurnHandoff, spin, true)
+    ->Arg(0)
+    ->Arg(100)
+    ->Arg(1000)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_TurnHandoff, blocking, false)
+    ->Arg(0)
+    ->Arg(100)
+    ->Arg(1000)
+    ->UseRealTime();
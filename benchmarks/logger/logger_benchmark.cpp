@@ -0,0 +1,209 @@
+/**
+ * @file logger_benchmark.cpp
+ * Benchmarks for logging a whole game and writing it out
+ */
+
+#include "constants/constants.h"
+#include "logger/logger.h"
+#include "state/helpers/game_builder.h"
+#include "state/state.h"
+#include "benchmark/benchmark.h"
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+using namespace logger;
+
+namespace {
+
+/**
+ * Measures logging a NUM_TURNS turn game and writing out its log, and
+ * reports the size of the log
+ *
+ * Only the logger's calls are timed. Between them the game is played, with
+ * soldiers ordered about every turn so that they keep moving and fighting
+ */
+void BM_LogGame(benchmark::State &state, LogWriteMode write_mode,
+                int64_t turns_per_block, int64_t turns_per_keyframe) {
+	int64_t log_bytes = 0;
+
+	for (auto _ : state) {
+		auto game = BuildGame();
+		Logger game_logger(PLAYER_INSTRUCTION_LIMIT_TURN,
+		                   PLAYER_INSTRUCTION_LIMIT_GAME, write_mode,
+		                   turns_per_block, turns_per_keyframe);
+		ostringstream log_stream;
+		chrono::duration<double> log_time(0);
+
+		auto start = chrono::steady_clock::now();
+		game_logger.StartStream(log_stream);
+		log_time += chrono::steady_clock::now() - start;
+
+		for (int64_t turn = 0; turn < NUM_TURNS; ++turn) {
+			for (int player_id = 0; player_id < 2; ++player_id) {
+				auto player = static_cast<PlayerId>(player_id);
+				auto enemy_id = (player_id + 1) % 2;
+
+				for (int i = turn % 5; i < NUM_SOLDIERS; i += 5) {
+					auto soldier_id = player_id * NUM_SOLDIERS + i;
+					if ((turn + i) % 25 < 8) {
+						game->MoveSoldier(player, soldier_id,
+						                  BASE_TOWER_POSITIONS[enemy_id]);
+					} else {
+						auto target_id = enemy_id * NUM_SOLDIERS +
+						                 (i + turn / 7) % NUM_SOLDIERS;
+						game->AttackActor(player, soldier_id, target_id);
+					}
+				}
+			}
+			game->Update();
+
+			start = chrono::steady_clock::now();
+			game_logger.LogState(game.get());
+			log_time += chrono::steady_clock::now() - start;
+		}
+
+		start = chrono::steady_clock::now();
+		game_logger.LogFinalGameParams();
+		game_logger.WriteGame(log_stream);
+		log_time += chrono::steady_clock::now() - start;
+
+		state.SetIterationTime(log_time.count());
+		log_bytes = log_stream.tellp();
+	}
+
+	state.counters["log_bytes"] = log_bytes;
+}
+
+/**
+ * Measures LogState over a NUM_TURNS turn game, plus freeing the logs, with
+ * the logs allocated on the heap or on an arena as state.range(0) is 0 or 1
+ *
+ * Every soldier is logged every turn whether or not it moves, so the game
+ * is left to play itself
+ */
+void BM_LogState(benchmark::State &state) {
+	bool is_arena_allocated = state.range(0);
+	chrono::duration<double> log_time(0);
+
+	for (auto _ : state) {
+		auto game = BuildGame();
+		auto start = chrono::steady_clock::now();
+		auto game_logger = make_unique<Logger>(
+		    PLAYER_INSTRUCTION_LIMIT_TURN, PLAYER_INSTRUCTION_LIMIT_GAME,
+		    LogWriteMode::WHOLE_GAME, 0, 0, is_arena_allocated);
+		log_time = chrono::steady_clock::now() - start;
+
+		for (int64_t turn = 0; turn < NUM_TURNS; ++turn) {
+			game->Update();
+
+			start = chrono::steady_clock::now();
+			game_logger->LogState(game.get());
+			log_time += chrono::steady_clock::now() - start;
+		}
+
+		start = chrono::steady_clock::now();
+		game_logger.reset();
+		log_time += chrono::steady_clock::now() - start;
+
+		state.SetIterationTime(log_time.count());
+	}
+}
+
+/**
+ * Measures writing out the log of a NUM_TURNS turn game that was logged
+ * whole, with soldier deltas between keyframes every state.range(0) turns,
+ * or with every soldier every turn if 0
+ */
+void BM_WriteGame(benchmark::State &state) {
+	auto turns_per_keyframe = state.range(0);
+	int64_t log_bytes = 0;
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto game = BuildGame();
+		Logger game_logger(PLAYER_INSTRUCTION_LIMIT_TURN,
+		                   PLAYER_INSTRUCTION_LIMIT_GAME,
+		                   LogWriteMode::WHOLE_GAME, 0, turns_per_keyframe);
+		for (int64_t turn = 0; turn < NUM_TURNS; ++turn) {
+			game->Update();
+			game_logger.LogState(game.get());
+		}
+		game_logger.LogFinalGameParams();
+		ostringstream log_stream;
+		state.ResumeTiming();
+
+		game_logger.WriteGame(log_stream);
+
+		state.PauseTiming();
+		log_bytes = log_stream.tellp();
+		state.ResumeTiming();
+	}
+
+	state.counters["log_bytes"] = log_bytes;
+}
+
+/**
+ * Measures logging an error for every soldier of both players, each turn of
+ * a NUM_TURNS turn game, as a bot that keeps sending invalid commands would
+ */
+void BM_LogError(benchmark::State &state) {
+	for (auto _ : state) {
+		Logger game_logger(PLAYER_INSTRUCTION_LIMIT_TURN,
+		                   PLAYER_INSTRUCTION_LIMIT_GAME);
+		for (int64_t turn = 0; turn < NUM_TURNS; ++turn) {
+			for (int player_id = 0; player_id < 2; ++player_id) {
+				for (int i = 0; i < NUM_SOLDIERS; ++i) {
+					game_logger.LogError(static_cast<PlayerId>(player_id),
+					                     ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
+					                     player_id * NUM_SOLDIERS + i, -1);
+				}
+			}
+		}
+		game_logger.LogFinalGameParams();
+	}
+
+	state.SetItemsProcessed(state.iterations() * NUM_TURNS * 2 *
+	                        NUM_SOLDIERS);
+}
+}
+
+BENCHMARK_CAPTURE(BM_LogGame, whole_game, LogWriteMode::WHOLE_GAME, 0, 0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+BENCHMARK_CAPTURE(BM_LogGame, whole_game_deltas, LogWriteMode::WHOLE_GAME, 0,
+                  100)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+BENCHMARK_CAPTURE(BM_LogGame, stream, LogWriteMode::STREAM, 0, 0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+BENCHMARK_CAPTURE(BM_LogGame, stream_on_thread, LogWriteMode::STREAM_ON_THREAD,
+                  0, 0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+BENCHMARK_CAPTURE(BM_LogGame, compressed_10, LogWriteMode::STREAM, 10, 0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+BENCHMARK_CAPTURE(BM_LogGame, compressed_50, LogWriteMode::STREAM, 50, 0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+BENCHMARK_CAPTURE(BM_LogGame, compressed_50_deltas, LogWriteMode::STREAM, 50,
+                  50)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+BENCHMARK_CAPTURE(BM_LogGame, compressed_50_on_thread,
+                  LogWriteMode::STREAM_ON_THREAD, 50, 0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime();
+BENCHMARK(BM_LogState)
+    ->Unit(benchmark::kMillisecond)
+    ->UseManualTime()
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK(BM_WriteGame)->Unit(benchmark::kMillisecond)->Arg(0)->Arg(100);
+BENCHMARK(BM_LogError)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,215 @@
+/**
+ * @file path_planner_benchmark.cpp
+ * Benchmarks for setting up and querying the BFS path planner
+ */
+
+#include "constants/map.h"
+#include "state/map/map.h"
+#include "state/path_planner/path_planner.h"
+#include "benchmark/benchmark.h"
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <memory>
+#include <new>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+
+namespace {
+
+const int64_t ELEMENT_SIZE = 50;
+
+/**
+ * Returns a map_size x map_size map of land, with a wall of water across
+ * every fifth column that has a gap at alternating ends, so that paths wind
+ */
+unique_ptr<Map> BuildMap(int64_t map_size) {
+	vector<vector<MapElement>> grid;
+	for (int i = 0; i < map_size; ++i) {
+		vector<MapElement> row;
+		for (int j = 0; j < map_size; ++j) {
+			bool is_wall = (i % 5 == 4) && (i % 10 == 4 ? j != map_size - 1
+			                                            : j != 0);
+			row.push_back(MapElement(Vector(i * ELEMENT_SIZE, j * ELEMENT_SIZE),
+			                         is_wall ? TerrainType::WATER
+			                                 : TerrainType::LAND));
+		}
+		grid.push_back(row);
+	}
+	return make_unique<Map>(grid, ELEMENT_SIZE);
+}
+
+/**
+ * Bytes currently allocated through operator new. Counted by the
+ * replacements of operator new and delete below, which is why these
+ * benchmarks have a binary of their own
+ */
+atomic<int64_t> heap_bytes(0);
+
+int64_t GetHeapBytes() { return heap_bytes.load(); }
+
+/**
+ * Measures constructing a planner on a map of side state.range(0), and
+ * reports the heap it holds once built
+ */
+void BM_PathPlannerStartup(benchmark::State &state) {
+	auto map_size = state.range(0);
+	auto map = BuildMap(map_size);
+
+	int64_t planner_heap_bytes = 0;
+
+	for (auto _ : state) {
+		auto heap_before = GetHeapBytes();
+		auto path_planner = make_unique<PathPlanner>(map.get());
+		planner_heap_bytes = GetHeapBytes() - heap_before;
+		benchmark::DoNotOptimize(path_planner.get());
+	}
+
+	state.counters["heap_bytes"] = planner_heap_bytes;
+}
+
+/**
+ * Measures a turn's worth of movement on a map of side state.range(0), 40
+ * soldiers walking between 8 destinations, and reports the heap the planner
+ * holds afterwards
+ */
+void BM_PathPlannerQuery(benchmark::State &state) {
+	auto map_size = state.range(0);
+	auto map = BuildMap(map_size);
+	auto heap_before = GetHeapBytes();
+	auto path_planner = make_unique<PathPlanner>(map.get());
+
+	vector<Vector> destinations;
+	for (int i = 0; i < 8; ++i) {
+		// Land cells spread along the diagonal, away from the walls
+		auto offset = (i * 10 + 2) % (map_size - 1);
+		auto offset_x = offset - offset % 5 + 2;
+		destinations.emplace_back(offset_x * ELEMENT_SIZE + ELEMENT_SIZE / 2,
+		                          offset * ELEMENT_SIZE + ELEMENT_SIZE / 2);
+	}
+
+	vector<Vector> positions;
+	for (int i = 0; i < 40; ++i) {
+		positions.push_back(destinations[(i + 3) % destinations.size()]);
+	}
+
+	int64_t turn = 0;
+	for (auto _ : state) {
+		for (size_t i = 0; i < positions.size(); ++i) {
+			auto &destination = destinations[(i + turn / 50) % 8];
+			positions[i] =
+			    path_planner->GetNextPosition(positions[i], destination, 10);
+		}
+		++turn;
+		benchmark::DoNotOptimize(positions.data());
+	}
+
+	state.counters["heap_bytes"] = GetHeapBytes() - heap_before;
+	state.SetItemsProcessed(state.iterations() * positions.size());
+}
+
+/**
+ * Measures building a planner and finding paths towards a cache's worth of
+ * land destinations on a map of side state.range(0), using state.range(1)
+ * threads
+ */
+void BM_PathPlannerPrecompute(benchmark::State &state) {
+	auto map_size = state.range(0);
+	auto num_threads = state.range(1);
+	auto map = BuildMap(map_size);
+
+	vector<Vector> destinations;
+	for (int i = 0; destinations.size() < PATH_PLANNER_CACHE_SIZE &&
+	                i < map_size * map_size;
+	     i += 7) {
+		Vector destination(i / map_size, i % map_size);
+		if (map->GetElementByOffset(destination).GetTerrainType() ==
+		    TerrainType::LAND) {
+			destinations.push_back(destination);
+		}
+	}
+
+	for (auto _ : state) {
+		auto path_planner = make_unique<PathPlanner>(map.get());
+		path_planner->PrecomputePaths(destinations, num_threads);
+		benchmark::DoNotOptimize(path_planner.get());
+	}
+
+	state.SetItemsProcessed(state.iterations() * destinations.size());
+}
+
+/**
+ * Measures building a planner with every path at hand on a map of side
+ * state.range(0), either by mapping a table file written beforehand or,
+ * when the file is removed before each iteration, by finding all paths and
+ * writing the file
+ */
+void BM_PathPlannerTableStartup(benchmark::State &state, bool is_cached) {
+	auto map_size = state.range(0);
+	auto map = BuildMap(map_size);
+	auto path_table_path =
+	    "/tmp/path_planner_benchmark_" + to_string(getpid()) + ".bin";
+
+	PathPlanner(map.get(), path_table_path, 1);
+	for (auto _ : state) {
+		if (!is_cached) {
+			state.PauseTiming();
+			remove(path_table_path.c_str());
+			state.ResumeTiming();
+		}
+		auto path_planner =
+		    make_unique<PathPlanner>(map.get(), path_table_path, 1);
+		benchmark::DoNotOptimize(path_planner.get());
+	}
+
+	remove(path_table_path.c_str());
+}
+}
+
+void *operator new(size_t size) {
+	if (void *ptr = malloc(size)) {
+		heap_bytes += malloc_usable_size(ptr);
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+	heap_bytes -= malloc_usable_size(ptr);
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	heap_bytes -= malloc_usable_size(ptr);
+	free(ptr);
+}
+
+BENCHMARK(BM_PathPlannerStartup)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(10)
+    ->Arg(30)
+    ->Arg(60)
+    ->Arg(100);
+BENCHMARK(BM_PathPlannerQuery)->Arg(10)->Arg(30)->Arg(60)->Arg(100);
+BENCHMARK(BM_PathPlannerPrecompute)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Args({30, 1})
+    ->Args({30, 4})
+    ->Args({100, 1})
+    ->Args({100, 4});
+BENCHMARK_CAPTURE(BM_PathPlannerTableStartup, hit, true)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(30)
+    ->Arg(60);
+BENCHMARK_CAPTURE(BM_PathPlannerTableStartup, miss, false)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(30)
+    ->Arg(60);
@@ -0,0 +1,268 @@
+/**
+ * @file state_syncer_benchmark.cpp
+ * Benchmarks for syncing the main state into the player states every turn
+ */
+
+#include "constants/constants.h"
+#include "logger/interfaces/i_logger.h"
+#include "state/helpers/game_builder.h"
+#include "state/player_state.h"
+#include "state/state.h"
+#include "state/state_syncer/state_syncer.h"
+#include "benchmark/benchmark.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+
+namespace {
+
+/**
+ * Logger that drops everything, so that only the sync itself is measured
+ */
+class NullLogger : public logger::ILogger {
+  public:
+	void StartStream(std::ostream &) override {}
+	void LogState(IState *) override {}
+	void LogInstructionCount(PlayerId, int64_t) override {}
+	void LogTurnTime(PlayerId, int64_t, bool) override {}
+	void LogError(PlayerId, logger::ErrorType, int64_t, int64_t) override {}
+	void LogCommand(PlayerId, logger::CommandType, int64_t, int64_t,
+	                Vector) override {}
+	void LogFinalGameParams() override {}
+	void WriteGame(std::ostream &) override {}
+};
+
+/**
+ * Offset of the base tower of the given player on a map of the given size
+ */
+Vector GetBaseOffset(int64_t map_size, int64_t player_id) {
+	return player_id == 0 ? Vector(map_size / 6 - 1, map_size / 6 - 1)
+	                      : Vector(map_size * 5 / 6, map_size * 5 / 6);
+}
+
+/**
+ * Returns a new game on a map_size x map_size map with a base tower and a
+ * full set of soldiers for each player
+ */
+unique_ptr<State> BuildGameOnMap(int64_t map_size) {
+	GameSettings settings;
+	settings.map_size = map_size;
+
+	// Suicides give back what the tower cost, so towers can be built and
+	// destroyed for as many turns as the benchmark needs
+	settings.money_start = TowerManager::build_costs[0];
+	settings.tower_suicide_rewards = TowerManager::build_costs;
+
+	settings.base_positions.clear();
+	for (int player_id = 0; player_id < 2; ++player_id) {
+		settings.base_positions.push_back(
+		    GetBaseOffset(map_size, player_id) * MAP_ELEMENT_SIZE +
+		    Vector(MAP_ELEMENT_SIZE / 2, MAP_ELEMENT_SIZE / 2));
+	}
+
+	return BuildGame(settings);
+}
+
+/**
+ * Plays one turn where every player either builds a tower next to their
+ * base or destroys the one they built last turn, so that territory changes
+ * hands every turn
+ */
+void PlayTurn(State *state, int64_t map_size, bool is_build_turn) {
+	for (int player_id = 0; player_id < 2; ++player_id) {
+		auto player = static_cast<PlayerId>(player_id);
+		if (is_build_turn) {
+			auto step = 1 - 2 * player_id;
+			state->BuildTower(player, GetBaseOffset(map_size, player_id) +
+			                              Vector(step, step));
+		} else {
+			auto towers = state->GetAllTowers()[player_id];
+			state->SuicideTower(player, towers.back()->GetActorId());
+		}
+	}
+	state->Update();
+}
+
+/**
+ * Rebuilds the player maps the way the syncer did before it tracked dirty
+ * map elements. Every element is copied out of the map, flipped for the
+ * second player, and copied into every player state
+ */
+void FullMapSync(State *state, vector<player_state::State *> &player_states) {
+	auto *map = state->GetMap();
+	auto state_towers = state->GetAllTowers();
+	int64_t map_size = map->GetSize();
+
+	vector<vector<player_state::MapElement>> player_map;
+	for (int i = 0; i < map_size; ++i) {
+		vector<player_state::MapElement> map_element_vector;
+		for (int j = 0; j < map_size; ++j) {
+			player_state::MapElement map_element;
+			state::MapElement state_map_element =
+			    map->GetElementByOffset(Vector(i, j));
+
+			auto ownerships = state_map_element.GetOwnership();
+			map_element.territory = ownerships[0];
+			map_element.enemy_territory = ownerships[1];
+			map_element.build_tower = false;
+
+			map_element_vector.push_back(map_element);
+		}
+		player_map.push_back(map_element_vector);
+	}
+
+	for (size_t player_id = 0; player_id < player_states.size(); ++player_id) {
+		if (player_id == 1) {
+			reverse(player_map.begin(), player_map.end());
+			for (auto &player_map_row : player_map) {
+				reverse(player_map_row.begin(), player_map_row.end());
+				for (auto &player_map_element : player_map_row) {
+					swap(player_map_element.territory,
+					     player_map_element.enemy_territory);
+				}
+			}
+		}
+
+		for (auto &player_map_row : player_map) {
+			for (auto &player_map_element : player_map_row) {
+				player_map_element.valid_territory =
+				    player_map_element.territory &&
+				    !player_map_element.enemy_territory;
+			}
+		}
+		for (auto *tower : state_towers[player_id]) {
+			auto offset = (tower->GetPosition() / MAP_ELEMENT_SIZE).floor();
+			if (player_id == 1) {
+				offset = Vector(map_size - 1, map_size - 1) - offset;
+			}
+			player_map[offset.x][offset.y].valid_territory = false;
+		}
+
+		for (int i = 0; i < map_size; ++i) {
+			copy(player_map[i].begin(), player_map[i].end(),
+			     player_states[player_id]->map[i].begin());
+		}
+	}
+
+	state->ClearDirtyMapOffsets();
+}
+
+/**
+ * Measures the cost of one turn's sync on a map of side state.range(0)
+ *
+ * The full variant is the map rebuild the syncer did before, it is kept here
+ * as a baseline and does not include the soldier and tower copies that the
+ * delta variant also pays for. player_state::State holds a MAP_SIZE map, so
+ * larger maps are only run when MAP_SIZE is raised to match
+ */
+void BM_StateSync(benchmark::State &state, bool use_full_sync) {
+	auto map_size = state.range(0);
+	if (map_size > MAP_SIZE) {
+		state.SkipWithError("Map is larger than player_state::State::map");
+		return;
+	}
+
+	auto game = BuildGameOnMap(map_size);
+	auto *game_state = game.get();
+	NullLogger null_logger;
+	StateSyncer state_syncer(move(game), &null_logger,
+	                         TowerManager::build_costs, MAX_NUM_TOWERS);
+
+	auto player_states_storage = make_unique<player_state::State[]>(2);
+	vector<player_state::State *> player_states = {
+	    &player_states_storage[0], &player_states_storage[1]};
+	state_syncer.UpdatePlayerStates(player_states);
+
+	bool is_build_turn = true;
+	for (auto _ : state) {
+		state.PauseTiming();
+		PlayTurn(game_state, map_size, is_build_turn);
+		is_build_turn = !is_build_turn;
+		state.ResumeTiming();
+
+		if (use_full_sync) {
+			FullMapSync(game_state, player_states);
+		} else {
+			state_syncer.UpdatePlayerStates(player_states);
+		}
+		benchmark::ClobberMemory();
+	}
+}
+
+/**
+ * Measures validating and running one turn of commands on a MAP_SIZE map
+ *
+ * Every turn a fifth of each player's soldiers get orders, alternating
+ * between marching on the enemy base and attacking an enemy soldier, and
+ * every tenth soldier is given both, which is rejected. The state is
+ * updated and synced back between turns, untimed
+ *
+ * The orders are given through the writables, which are scanned, or
+ * through the command buffer
+ */
+void BM_ExecutePlayerCommands(benchmark::State &state,
+                              bool use_command_buffer) {
+	auto game = BuildGameOnMap(MAP_SIZE);
+	auto *game_state = game.get();
+	NullLogger null_logger;
+	StateSyncer state_syncer(move(game), &null_logger,
+	                         TowerManager::build_costs, MAX_NUM_TOWERS);
+
+	auto player_states_storage = make_unique<player_state::State[]>(2);
+	vector<player_state::State *> player_states = {
+	    &player_states_storage[0], &player_states_storage[1]};
+	vector<bool> skip_player_commands_flags(2, false);
+
+	int64_t turn = 0;
+	for (auto _ : state) {
+		state.PauseTiming();
+		game_state->Update();
+		state_syncer.UpdatePlayerStates(player_states);
+		for (auto *player_state : player_states) {
+			for (int i = turn % 5; i < NUM_SOLDIERS; i += 5) {
+				auto &soldier = player_state->soldiers[i];
+				auto destination = player_state->enemy_towers[0].position;
+				auto target_id =
+				    player_state->enemy_soldiers[(i + turn / 7) % NUM_SOLDIERS]
+				        .id;
+				if ((turn + i) % 25 < 8 || i % 10 == 0) {
+					if (use_command_buffer) {
+						player_state::MoveSoldier(*player_state, i,
+						                          destination);
+					} else {
+						soldier.destination = destination;
+					}
+				}
+				if ((turn + i) % 25 >= 8 || i % 10 == 0) {
+					if (use_command_buffer) {
+						player_state::AttackSoldier(*player_state, i,
+						                            target_id);
+					} else {
+						soldier.soldier_target = target_id;
+					}
+				}
+			}
+		}
+		++turn;
+		state.ResumeTiming();
+
+		state_syncer.ExecutePlayerCommands(player_states,
+		                                   skip_player_commands_flags);
+	}
+
+	state.SetItemsProcessed(state.iterations() * 2 * NUM_SOLDIERS / 5);
+}
+}
+
+BENCHMARK_CAPTURE(BM_StateSync, full, true)
+    ->Arg(MAP_SIZE)
+    ->Arg(2 * MAP_SIZE);
+BENCHMARK_CAPTURE(BM_StateSync, delta, false)
+    ->Arg(MAP_SIZE)
+    ->Arg(2 * MAP_SIZE);
+BENCHMARK_CAPTURE(BM_ExecutePlayerCommands, writables, false);
+BENCHMARK_CAPTURE(BM_ExecutePlayerCommands, command_buffer, true);
@@ -0,0 +1,60 @@
+/**
+ * @file state_update_benchmark.cpp
+ * Benchmarks for updating the main state every turn
+ */
+
+#include "constants/constants.h"
+#include "state/helpers/game_builder.h"
+#include "state/state.h"
+#include "benchmark/benchmark.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+
+namespace {
+
+/**
+ * Measures one turn of State::Update with state.range(0) soldiers per
+ * player
+ *
+ * Every turn a fifth of the soldiers get new orders, alternating between
+ * marching on the enemy base and attacking an enemy soldier, so soldiers
+ * keep moving, chasing, fighting, dying and respawning
+ */
+void BM_StateUpdate(benchmark::State &state) {
+	auto num_soldiers = state.range(0);
+	GameSettings settings;
+	settings.num_soldiers = num_soldiers;
+	auto game = BuildGame(settings);
+	int64_t turn = 0;
+
+	for (auto _ : state) {
+		for (int player_id = 0; player_id < 2; ++player_id) {
+			auto player = static_cast<PlayerId>(player_id);
+			auto enemy_id = (player_id + 1) % 2;
+
+			for (int i = turn % 5; i < num_soldiers; i += 5) {
+				auto soldier_id = player_id * num_soldiers + i;
+				if ((turn + i) % 25 < 8) {
+					game->MoveSoldier(player, soldier_id,
+					                  BASE_TOWER_POSITIONS[enemy_id]);
+				} else {
+					auto target_id = enemy_id * num_soldiers +
+					                 (i + turn / 7) % num_soldiers;
+					game->AttackActor(player, soldier_id, target_id);
+				}
+			}
+		}
+
+		game->Update();
+		++turn;
+	}
+
+	state.SetItemsProcessed(state.iterations() * 2 * num_soldiers);
+}
+}
+
+BENCHMARK(BM_StateUpdate)->Arg(20)->Arg(200)->Arg(2000);
@@ -0,0 +1,102 @@
+/**
+ * @file tower_manager_benchmark.cpp
+ * Benchmarks for the territory updates when towers are built and destroyed
+ */
+
+#include "constants/constants.h"
+#include "state/actor/actor_id_allocator.h"
+#include "state/map/map.h"
+#include "state/money_manager/money_manager.h"
+#include "state/tower_manager/tower_manager.h"
+#include "benchmark/benchmark.h"
+#include <limits>
+#include <memory>
+#include <vector>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+
+namespace {
+
+/**
+ * Offset of the i-th tower, spread over the map so that territories overlap
+ */
+Vector GetTowerOffset(int64_t i) {
+	return Vector((i * 7) % MAP_SIZE, (i * 11 + 3) % MAP_SIZE);
+}
+
+/**
+ * Measures the tower manager update that builds, or destroys, one tower on
+ * a MAP_SIZE map that already has state.range(0) other towers on it
+ *
+ * Every iteration builds a tower and destroys it again, only one of the two
+ * updates is timed
+ */
+void BM_TowerTerritory(benchmark::State &state, bool is_build_timed) {
+	auto num_towers = state.range(0);
+
+	vector<vector<MapElement>> grid;
+	for (int i = 0; i < MAP_SIZE; ++i) {
+		vector<MapElement> row;
+		for (int j = 0; j < MAP_SIZE; ++j) {
+			row.push_back(MapElement(
+			    Vector(i * MAP_ELEMENT_SIZE, j * MAP_ELEMENT_SIZE),
+			    TerrainType::LAND));
+		}
+		grid.push_back(row);
+	}
+	auto map = make_unique<Map>(grid, MAP_ELEMENT_SIZE);
+	auto actor_id_allocator = make_unique<ActorIdAllocator>();
+
+	// Enough money to build towers for as long as the benchmark runs
+	auto money = numeric_limits<int64_t>::max() / 2;
+	auto money_manager = make_unique<MoneyManager>(
+	    vector<int64_t>(2, money), money, TOWER_KILL_REWARD_AMOUNTS,
+	    SOLDIER_KILL_REWARD_AMOUNT, TOWER_SUICIDE_REWARD_AMOUNT);
+
+	vector<unique_ptr<Tower>> towers;
+	towers.push_back(make_unique<Tower>(
+	    actor_id_allocator->GetNextActorId(), PlayerId::PLAYER1,
+	    ActorType::TOWER, Tower::max_hp_levels[0], Tower::max_hp_levels[0],
+	    BASE_TOWER_POSITIONS[0], true, 1));
+	TowerManager tower_manager(move(towers), PlayerId::PLAYER1,
+	                           money_manager.get(), map.get(),
+	                           actor_id_allocator.get());
+
+	for (int64_t i = 0; i < num_towers; ++i) {
+		tower_manager.BuildTower(GetTowerOffset(i));
+	}
+	tower_manager.Update();
+	tower_manager.ClearDirtyOffsets();
+
+	int64_t turn = 0;
+	for (auto _ : state) {
+		if (!is_build_timed) {
+			state.PauseTiming();
+		}
+		tower_manager.BuildTower(GetTowerOffset(num_towers + turn % 13));
+		tower_manager.Update();
+		if (!is_build_timed) {
+			state.ResumeTiming();
+		} else {
+			state.PauseTiming();
+		}
+
+		tower_manager.GetTowers().back()->SetHp(0);
+		tower_manager.Update();
+		tower_manager.ClearDirtyOffsets();
+		if (is_build_timed) {
+			state.ResumeTiming();
+		}
+		++turn;
+	}
+}
+}
+
+BENCHMARK_CAPTURE(BM_TowerTerritory, build, true)
+    ->Arg(0)
+    ->Arg(MAX_NUM_TOWERS - 1);
+BENCHMARK_CAPTURE(BM_TowerTerritory, death, false)
+    ->Arg(0)
+    ->Arg(MAX_NUM_TOWERS - 1);
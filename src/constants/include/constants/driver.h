@@ -6,6 +6,8 @@
 #ifndef CONSTANTS_DRIVER_H
 #define CONSTANTS_DRIVER_H
 
+#include "soldier.h"
+#include "tower.h"
 #include <cmath>
 #include <cstdint>
 
@@ -23,4 +25,16 @@ const int64_t NUM_TURNS = 1000;
 // Duration of the game in milliseconds
 const int64_t GAME_DURATION_MS = 50 * 1000;
 
+// Wall clock time a player gets for one turn in milliseconds. A player that
+// runs past it forfeits the turn, and every turn until it catches up
+const int64_t PLAYER_TURN_DURATION_MS = 1000;
+
+// Whether player processes run their turns at the same time, instead of one
+// after the other. Each player still gets PLAYER_TURN_DURATION_MS
+const bool ARE_PLAYER_TURNS_CONCURRENT = true;
+
+// Number of commands a player can issue in one turn. Enough for one command
+// per soldier and tower, and a tower build for every tower that can be built
+const int64_t MAX_NUM_COMMANDS = NUM_SOLDIERS + 2 * MAX_NUM_TOWERS;
+
 #endif
@@ -14,4 +14,8 @@ const int64_t MAP_SIZE = 30;
 // Side length of each tile on the map
 const int64_t MAP_ELEMENT_SIZE = 50;
 
+// Number of destinations the path planner keeps paths towards, before it
+// drops the least recently used
+const int64_t PATH_PLANNER_CACHE_SIZE = 64;
+
 #endif
@@ -0,0 +1,126 @@
+/**
+ * @file in_process_player.h
+ * Declaration for a player whose code runs inside the simulator process
+ */
+
+#ifndef DRIVERS_IN_PROCESS_PLAYER_H
+#define DRIVERS_IN_PROCESS_PLAYER_H
+
+#include "drivers/drivers_export.h"
+#include "player_wrapper/player_code_wrapper.h"
+#include "state/player_state.h"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace drivers {
+
+/**
+ * Runs a player's code directly on the main driver's thread, instead of in
+ * a player process that the main driver hands turns to over shared memory
+ *
+ * The player code is not isolated from the simulator, so this is only for
+ * trusted code. Instructions are still counted by the LLVM pass, on the
+ * calling thread
+ */
+class DRIVERS_EXPORT InProcessPlayer {
+  private:
+	/**
+	 * Handle of the loaded player code library, nullptr if the code was
+	 * passed in
+	 */
+	void *library;
+
+	/**
+	 * An instance of the player code wrapper
+	 */
+	std::unique_ptr<player_wrapper::PlayerCodeWrapper> player_code_wrapper;
+
+	/**
+	 * File the player's debug logs are written to, a turn at a time
+	 */
+	std::ofstream player_debug_logs;
+
+	/**
+	 * Used as delimiter between turns in player's debug logs
+	 */
+	std::string debug_logs_turn_prefix;
+
+	/**
+	 * Message to use in logs when player exceeds debug log limit per turn
+	 */
+	std::string debug_logs_truncate_message;
+
+	/**
+	 * Maximum number of characters allowed in player's debug logs per turn
+	 */
+	int64_t max_debug_logs_turn_length;
+
+  public:
+	/**
+	 * Name of the function player code libraries export to create their
+	 * player code, as extern "C" player_wrapper::IPlayerCode *()
+	 */
+	static const std::string create_player_code_name;
+
+	/**
+	 * Constructor for player code that is already loaded
+	 *
+	 * @param[in]  player_code_wrapper          The player code wrapper
+	 * @param[in]  player_debug_log_file        The player debug log file path
+	 * @param[in]  debug_logs_turn_prefix       Prefix for debug log every turn
+	 * @param[in]  debug_logs_truncate_message  Message in debug logs if player
+	 *                                          exceeded per turn limit
+	 * @param[in]  max_debug_logs_turn_length   Maxiumum length of debug logs
+	 *                                          per turn
+	 */
+	InProcessPlayer(
+	    std::unique_ptr<player_wrapper::PlayerCodeWrapper> player_code_wrapper,
+	    std::string player_debug_log_file, std::string debug_logs_turn_prefix,
+	    std::string debug_logs_truncate_message,
+	    int64_t max_debug_logs_turn_length);
+
+	/**
+	 * Constructor that loads the player code from a shared library
+	 *
+	 * A private copy of the library is loaded, so that players and matches
+	 * using the same library do not share its global variables
+	 *
+	 * @param[in]  library_path                 Path to the player code library
+	 * @param[in]  player_debug_log_file        The player debug log file path
+	 * @param[in]  debug_logs_turn_prefix       Prefix for debug log every turn
+	 * @param[in]  debug_logs_truncate_message  Message in debug logs if player
+	 *                                          exceeded per turn limit
+	 * @param[in]  max_debug_logs_turn_length   Maxiumum length of debug logs
+	 *                                          per turn
+	 *
+	 * @throw      std::runtime_error If the library cannot be loaded or does
+	 *                                not export create_player_code_name
+	 */
+	InProcessPlayer(std::string library_path,
+	                std::string player_debug_log_file,
+	                std::string debug_logs_turn_prefix,
+	                std::string debug_logs_truncate_message,
+	                int64_t max_debug_logs_turn_length);
+
+	/**
+	 * Destroys the player code, then unloads its library
+	 */
+	~InProcessPlayer();
+
+	InProcessPlayer(const InProcessPlayer &) = delete;
+	InProcessPlayer &operator=(const InProcessPlayer &) = delete;
+
+	/**
+	 * Runs the player's code for a turn and writes out its debug logs
+	 *
+	 * @param[inout]  player_state  The player's copy of the state
+	 *
+	 * @return        Number of LLVM IR instructions the player executed
+	 */
+	int64_t RunTurn(player_state::State &player_state);
+};
+}
+
+#endif
@@ -7,6 +7,7 @@
 #define DRIVERS_MAIN_DRIVER_H
 
 #include "drivers/drivers_export.h"
+#include "drivers/in_process_player.h"
 #include "drivers/player_result.h"
 #include "drivers/shared_memory_utils/shared_buffer.h"
 #include "drivers/shared_memory_utils/shared_memory_main.h"
@@ -34,6 +35,18 @@ class DRIVERS_EXPORT MainDriver {
 	 */
 	std::vector<std::unique_ptr<SharedMemoryMain>> shared_memories;
 
+	/**
+	 * Players whose code runs on the main driver's thread, empty if the
+	 * players run in their own processes
+	 */
+	std::vector<std::unique_ptr<InProcessPlayer>> in_process_players;
+
+	/**
+	 * Buffers owned by the main driver, standing in for the shared memories
+	 * when the players run in process
+	 */
+	std::vector<std::unique_ptr<SharedBuffer>> in_process_buffers;
+
 	/**
 	 * Access pointer to the shared memory
 	 */
@@ -41,9 +54,22 @@ class DRIVERS_EXPORT MainDriver {
 
 	/**
 	 * Pointers to player state copies
+	 *
+	 * A stalled player's pointer is swapped for its stand in state until it
+	 * catches up, so that its own copy is left alone while it runs
 	 */
 	std::vector<player_state::State *> player_states;
 
+	/**
+	 * States the state syncer writes to in place of stalled players' copies
+	 */
+	std::vector<player_state::State> stalled_player_states;
+
+	/**
+	 * true for each player that is still running a turn that timed out
+	 */
+	std::vector<bool> is_player_stalled;
+
 	/**
 	 * Instruction count limit.
 	 *
@@ -80,6 +106,32 @@ class DRIVERS_EXPORT MainDriver {
 	 */
 	Timer::Interval game_duration;
 
+	/**
+	 * true if the players being waited on have run past the turn time limit
+	 */
+	std::atomic_bool is_turn_timed_out;
+
+	/**
+	 * Timer for the turn of the players being waited on
+	 */
+	Timer turn_timer;
+
+	/**
+	 * Time limit for a player's turn.
+	 *
+	 * A player that runs past it forfeits the turn, and every turn after it
+	 * until it has finished the one that timed out.
+	 */
+	Timer::Interval player_turn_duration;
+
+	/**
+	 * true if player processes run their turns at the same time, false if
+	 * they take turns one after the other
+	 *
+	 * Either way, each player gets player_turn_duration for its turn
+	 */
+	bool are_player_turns_concurrent;
+
 	/**
 	 * Blocking function that runs the game
 	 *
@@ -102,6 +154,47 @@ class DRIVERS_EXPORT MainDriver {
 	 */
 	std::atomic_bool cancel;
 
+	/**
+	 * Number of iterations to spin for while waiting on a player, before
+	 * going to sleep. Adapted after every wait
+	 */
+	int64_t handoff_spin_count;
+
+	/**
+	 * Lets the players run their turns, and waits for all of them
+	 *
+	 * A player process that runs past the turn time limit is left running,
+	 * and is stalled until it has finished that turn. Players that are run
+	 * together start at the same time, so a turn time is when the player was
+	 * seen done, which can be after it was actually done
+	 *
+	 * Returns early on cancellation, or if the game times out
+	 *
+	 * @param[out]  turn_times_us   Wall clock time spent on each player's
+	 *                              turn, in microseconds
+	 * @param[out]  are_turns_done  true for each player that finished its
+	 *                              turn in time, false if the turn has to be
+	 *                              skipped
+	 */
+	void RunPlayerTurns(std::vector<int64_t> &turn_times_us,
+	                    std::vector<bool> &are_turns_done);
+
+	/**
+	 * Lets a player process start its turn, unless it is stalled
+	 *
+	 * @param[in]  player_id  The player
+	 *
+	 * @return     true if the player was let run, false if the turn has to be
+	 *             skipped
+	 */
+	bool StartPlayerTurn(int64_t player_id);
+
+	/**
+	 * Wakes up the main loop if it's waiting on a player, so that it notices
+	 * timeouts and cancellation
+	 */
+	void NotifyPlayerWaits();
+
   public:
 	/**
 	 * Constructor
@@ -111,9 +204,26 @@ class DRIVERS_EXPORT MainDriver {
 	           int64_t player_instruction_limit_turn,
 	           int64_t player_instruction_limit_game, int64_t max_no_turns,
 	           int64_t player_count, Timer::Interval game_duration,
+	           Timer::Interval player_turn_duration,
+	           bool are_player_turns_concurrent,
 	           std::unique_ptr<logger::ILogger> logger,
 	           std::string log_file_name);
 
+	/**
+	 * Constructor for a game whose players run in process, without shared
+	 * memory or player processes
+	 *
+	 * In process players always take turns one after the other
+	 */
+	MainDriver(
+	    std::unique_ptr<state::IStateSyncer> state_syncer,
+	    std::vector<std::unique_ptr<InProcessPlayer>> in_process_players,
+	    int64_t player_instruction_limit_turn,
+	    int64_t player_instruction_limit_game, int64_t max_no_turns,
+	    int64_t player_count, Timer::Interval game_duration,
+	    Timer::Interval player_turn_duration,
+	    std::unique_ptr<logger::ILogger> logger, std::string log_file_name);
+
 	/**
 	 * Blocking function that starts the game.
 	 *
@@ -23,9 +23,13 @@ namespace drivers {
 class DRIVERS_EXPORT PlayerDriver {
   private:
 	/**
-	 * Number of LLVM IR instructions executed by the player
+	 * Number of LLVM IR instructions executed by player code on this thread
+	 * in the current turn
+	 *
+	 * Kept per thread, so that matches running players in process on
+	 * different threads count apart
 	 */
-	static std::atomic<uint64_t> instruction_count;
+	static thread_local uint64_t instruction_count;
 
 	/**
 	 * An instance of the player code wrapper
@@ -91,6 +95,17 @@ class DRIVERS_EXPORT PlayerDriver {
 	 */
 	int64_t max_debug_logs_turn_length;
 
+	/**
+	 * Number of instructions the player executed in its last turn
+	 */
+	std::atomic<uint64_t> last_turn_instruction_count;
+
+	/**
+	 * Number of iterations to spin for while waiting on the main driver,
+	 * before going to sleep. Adapted after every wait
+	 */
+	int64_t handoff_spin_count;
+
 	/**
 	 * Writes the count to shared memory
 	 */
@@ -128,12 +143,26 @@ class DRIVERS_EXPORT PlayerDriver {
 	/**
 	 * Increment instruction_count by count
 	 *
+	 * Called by the code the LLVM pass inserts into player code
+	 *
 	 * @param  count  The count
 	 */
 	static void IncrementCount(uint64_t count);
 
 	/**
-	 * Gets the instruction_count
+	 * Sets the calling thread's instruction_count to 0
+	 */
+	static void ResetCount();
+
+	/**
+	 * Gets the calling thread's instruction_count
+	 *
+	 * @return     The count
+	 */
+	static uint64_t GetThreadCount();
+
+	/**
+	 * Gets the number of instructions the player executed in its last turn
 	 *
 	 * @return     The count.
 	 */
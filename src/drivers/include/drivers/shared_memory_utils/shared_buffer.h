@@ -9,6 +9,8 @@
 #include "drivers/drivers_export.h"
 #include "state/player_state.h"
 #include <atomic>
+#include <cstdint>
+#include <functional>
 
 namespace drivers {
 
@@ -16,23 +18,76 @@ namespace drivers {
  * Struct for using as buffer in shared memory
  */
 struct DRIVERS_EXPORT SharedBuffer {
+	/**
+	 * Condition that makes a waiter give up waiting on the buffer
+	 */
+	typedef std::function<bool(void)> StopCondition;
+
+	/**
+	 * Spin count waiters should start out with
+	 */
+	static const int64_t default_spin_count;
+
 	SharedBuffer(bool is_player_running, int64_t instruction_counter,
 	             const player_state::State &player_state);
 
 	/**
 	 * True if the player process is executing its turn, false otherwise
+	 *
+	 * Held in a 32 bit word so that waiters in either process can sleep on it
+	 * with a futex instead of spinning
 	 */
-	std::atomic_bool is_player_running;
+	std::atomic<int32_t> is_player_running;
 
 	/**
 	 * Count of the number of instructions executed in the present turn
 	 */
 	std::atomic<int64_t> instruction_counter;
 
+	/**
+	 * Set by the main driver once the game is over. A player that missed
+	 * turns stops waiting for them when this is set
+	 */
+	std::atomic_bool is_game_over;
+
 	/**
 	 * Player's copy of the state with limited information
 	 */
 	player_state::State player_state;
+
+	/**
+	 * Sets is_player_running and wakes up everyone waiting on it
+	 *
+	 * @param[in]  is_player_running  The new value of the flag
+	 */
+	void SetPlayerRunning(bool is_player_running);
+
+	/**
+	 * Wakes up everyone waiting on is_player_running without changing it, so
+	 * that they re-evaluate their stop conditions
+	 */
+	void Notify();
+
+	/**
+	 * Blocks until is_player_running equals value or stop_condition returns
+	 * true
+	 *
+	 * Spins for at most spin_count iterations before going to sleep on the
+	 * flag. spin_count is adapted in place, it grows if the flag flipped while
+	 * spinning and shrinks if the waiter had to sleep. Sleeps are bounded so
+	 * that stop_condition is still polled if nobody calls Notify
+	 *
+	 * @param[in]     value           The value to wait for
+	 * @param[in]     stop_condition  Returns true if waiting should be
+	 *                                abandoned
+	 * @param[inout]  spin_count      Number of iterations to spin for, 0 to
+	 *                                sleep right away
+	 *
+	 * @return     true if is_player_running equals value, false if the wait
+	 *             was abandoned due to stop_condition
+	 */
+	bool WaitForPlayerRunning(bool value, const StopCondition &stop_condition,
+	                          int64_t &spin_count);
 };
 }
 
@@ -6,78 +6,68 @@
 #define DRIVERS_TIMER_H
 
 #include "drivers/drivers_export.h"
-#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <functional>
-#include <thread>
 
 namespace drivers {
 
 /**
  * An asynchronous timer class
+ *
+ * The callbacks of all the timers in the process are called from one shared
+ * thread, which sleeps until the earliest deadline on the monotonic clock.
+ * Timers cost no thread of their own, so a process can run thousands of them
  */
 class DRIVERS_EXPORT Timer {
-  private:
-	/**
-	 * true if this timer is running, false otherwise
-	 */
-	std::atomic_bool is_running;
-
+  public:
 	/**
-	 * Temporary used by the Cancel method
-	 *
-	 * Set to true by Cancel, and reset to false right before Cancel returns
+	 * Interval of time that timer operates for
 	 */
-	std::atomic_bool cancel;
+	typedef std::chrono::milliseconds Interval;
 
 	/**
-	 * Amount of time the timer has been running for
-	 *
-	 * Valid if is_running is true
+	 * Callback that timer can call
 	 */
-	std::chrono::milliseconds cur_duration;
+	typedef std::function<void(void)> Callback;
 
+  private:
 	/**
-	 * Timer wakes up every timer_wake_up_duration ms to check if it has been
-	 * cancelled
+	 * Id of the timer's last deadline with the shared timer thread, 0 if it
+	 * has never been started
 	 */
-	std::chrono::milliseconds timer_wake_up_duration;
+	uint64_t timer_id;
 
   public:
 	/**
-	 * Interval of time that timer operates for
+	 * Constructor for Timer
 	 */
-	typedef std::chrono::milliseconds Interval;
+	Timer();
 
 	/**
-	 * Callback that timer can call
+	 * Cancels the timer if it is running
 	 */
-	typedef std::function<void(void)> Callback;
+	~Timer();
 
-	/**
-	 * Constructor for Timer
-	 */
-	Timer();
+	Timer(const Timer &) = delete;
+	Timer &operator=(const Timer &) = delete;
 
 	/**
-	 * Starts this timer. Works only if is_running is false.
-	 *
-	 * Spawns a separate thread for the timer
+	 * Starts this timer. Works only if the timer is not running
 	 *
 	 * @param[in]  total_timer_duration  The total timer duration
-	 * @param[in]  callback              The callback when timer expires
+	 * @param[in]  callback              The callback when timer expires,
+	 *                                   called on the shared timer thread
 	 *
-	 * @return     false if is_running is true, else true
+	 * @return     false if the timer is running, else true
 	 */
 	bool Start(Interval total_timer_duration, Callback callback);
 
 	/**
 	 * Method to cancel the timer
 	 *
-	 * Cancelled timer won't call callback unless it's very close to expiring
-	 * already.
-	 * Blocks for at most timer_wake_up_duration ms
+	 * A cancelled timer won't call its callback. If the callback is already
+	 * running, blocks until it returns, unless called from the callback
 	 */
 	void Cancel();
 };
@@ -0,0 +1,131 @@
+/**
+ * @file in_process_player.cpp
+ * Contains definitions for a player whose code runs inside the simulator
+ * process
+ */
+
+#include "drivers/in_process_player.h"
+#include "drivers/player_driver.h"
+#include <cstdio>
+#include <dlfcn.h>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+namespace drivers {
+
+namespace {
+
+typedef player_wrapper::IPlayerCode *(*CreatePlayerCode)();
+
+/**
+ * Loads a private copy of a shared library
+ *
+ * dlopen hands out the same copy of a library to everyone who opens the
+ * same file, so the library is copied to a fresh file first. The copy is
+ * removed once loaded
+ *
+ * @return  The library handle
+ *
+ * @throw   std::runtime_error If the library cannot be copied or loaded
+ */
+void *LoadPrivateLibrary(const std::string &library_path) {
+	std::ifstream library_file(library_path, std::ios::binary);
+	if (!library_file) {
+		throw std::runtime_error("Cannot open player code library " +
+		                         library_path);
+	}
+
+	std::string copy_path_template =
+	    std::string(P_tmpdir) + "/player_code_XXXXXX";
+	std::vector<char> copy_path(copy_path_template.begin(),
+	                            copy_path_template.end());
+	copy_path.push_back('\0');
+	int copy_fd = mkstemp(copy_path.data());
+	if (copy_fd == -1) {
+		throw std::runtime_error("Cannot copy player code library " +
+		                         library_path);
+	}
+	close(copy_fd);
+
+	{
+		std::ofstream copy_file(copy_path.data(), std::ios::binary);
+		copy_file << library_file.rdbuf();
+	}
+
+	void *library = dlopen(copy_path.data(), RTLD_NOW | RTLD_LOCAL);
+	std::remove(copy_path.data());
+	if (library == nullptr) {
+		throw std::runtime_error("Cannot load player code library " +
+		                         library_path + ": " + dlerror());
+	}
+
+	return library;
+}
+}
+
+const std::string InProcessPlayer::create_player_code_name =
+    "CreatePlayerCode";
+
+InProcessPlayer::InProcessPlayer(
+    std::unique_ptr<player_wrapper::PlayerCodeWrapper> player_code_wrapper,
+    std::string player_debug_log_file, std::string debug_logs_turn_prefix,
+    std::string debug_logs_truncate_message, int64_t max_debug_logs_turn_length)
+    : library(nullptr), player_code_wrapper(std::move(player_code_wrapper)),
+      player_debug_logs(player_debug_log_file),
+      debug_logs_turn_prefix(debug_logs_turn_prefix),
+      debug_logs_truncate_message(debug_logs_truncate_message),
+      max_debug_logs_turn_length(max_debug_logs_turn_length) {}
+
+InProcessPlayer::InProcessPlayer(std::string library_path,
+                                 std::string player_debug_log_file,
+                                 std::string debug_logs_turn_prefix,
+                                 std::string debug_logs_truncate_message,
+                                 int64_t max_debug_logs_turn_length)
+    : InProcessPlayer(std::unique_ptr<player_wrapper::PlayerCodeWrapper>(),
+                      player_debug_log_file, debug_logs_turn_prefix,
+                      debug_logs_truncate_message,
+                      max_debug_logs_turn_length) {
+	this->library = LoadPrivateLibrary(library_path);
+
+	auto create_player_code = reinterpret_cast<CreatePlayerCode>(
+	    dlsym(this->library, create_player_code_name.c_str()));
+	if (create_player_code == nullptr) {
+		dlclose(this->library);
+		this->library = nullptr;
+		throw std::runtime_error("Player code library " + library_path +
+		                         " does not export " +
+		                         create_player_code_name);
+	}
+
+	this->player_code_wrapper =
+	    std::make_unique<player_wrapper::PlayerCodeWrapper>(
+	        std::unique_ptr<player_wrapper::IPlayerCode>(
+	            create_player_code()));
+}
+
+InProcessPlayer::~InProcessPlayer() {
+	// The player code's destructor lives in the library
+	this->player_code_wrapper.reset();
+	if (this->library != nullptr) {
+		dlclose(this->library);
+	}
+}
+
+int64_t InProcessPlayer::RunTurn(player_state::State &player_state) {
+	PlayerDriver::ResetCount();
+	auto logs = this->player_code_wrapper->Update(player_state);
+	int64_t instruction_count = PlayerDriver::GetThreadCount();
+
+	this->player_debug_logs << this->debug_logs_turn_prefix
+	                        << logs.substr(0, max_debug_logs_turn_length);
+
+	// Truncate debug logs if they're too long and add a truncation message
+	if (static_cast<int64_t>(logs.length()) >
+	    this->max_debug_logs_turn_length) {
+		this->player_debug_logs << this->debug_logs_truncate_message;
+	}
+
+	return instruction_count;
+}
+}
@@ -4,24 +4,53 @@
  */
 
 #include "drivers/main_driver.h"
+#include "state/profiler/profiler.h"
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <thread>
 
 namespace drivers {
 
+#ifdef PROFILE_TURNS
+namespace {
+
+/**
+ * Suffix of the turn profile, which is written next to the game log
+ */
+const std::string profile_file_suffix = ".profile.json";
+
+/**
+ * Phase of waiting on the given player
+ */
+state::ProfilePhase GetWaitPhase(int64_t player_id) {
+	return static_cast<state::ProfilePhase>(
+	    static_cast<int>(state::ProfilePhase::WAIT_FOR_PLAYER1) + player_id);
+}
+}
+#endif
+
 MainDriver::MainDriver(
     std::unique_ptr<state::IStateSyncer> state_syncer,
     std::vector<std::unique_ptr<SharedMemoryMain>> shared_memories,
     int64_t player_instruction_limit_turn,
     int64_t player_instruction_limit_game, int64_t max_no_turns,
     int64_t player_count, Timer::Interval game_duration,
+    Timer::Interval player_turn_duration, bool are_player_turns_concurrent,
     std::unique_ptr<logger::ILogger> logger, std::string log_file_name)
     : state_syncer(std::move(state_syncer)),
       shared_memories(std::move(shared_memories)),
+      stalled_player_states(this->shared_memories.size()),
+      is_player_stalled(this->shared_memories.size(), false),
       player_instruction_limit_turn(player_instruction_limit_turn),
       player_instruction_limit_game(player_instruction_limit_game),
       max_no_turns(max_no_turns), player_count(player_count),
       is_game_timed_out(false), game_timer(), game_duration(game_duration),
-      logger(std::move(logger)), log_file_name(log_file_name), cancel(false) {
+      is_turn_timed_out(false), turn_timer(),
+      player_turn_duration(player_turn_duration),
+      are_player_turns_concurrent(are_player_turns_concurrent),
+      logger(std::move(logger)), log_file_name(log_file_name), cancel(false),
+      handoff_spin_count(SharedBuffer::default_spin_count) {
 	for (auto &shared_memory : this->shared_memories) {
 		// Get pointers to shared memory and store
 		SharedBuffer *shared_buffer = shared_memory->GetBuffer();
@@ -32,25 +61,75 @@ MainDriver::MainDriver(
 	}
 }
 
+MainDriver::MainDriver(
+    std::unique_ptr<state::IStateSyncer> state_syncer,
+    std::vector<std::unique_ptr<InProcessPlayer>> in_process_players,
+    int64_t player_instruction_limit_turn,
+    int64_t player_instruction_limit_game, int64_t max_no_turns,
+    int64_t player_count, Timer::Interval game_duration,
+    Timer::Interval player_turn_duration,
+    std::unique_ptr<logger::ILogger> logger, std::string log_file_name)
+    : state_syncer(std::move(state_syncer)),
+      in_process_players(std::move(in_process_players)),
+      is_player_stalled(player_count, false),
+      player_instruction_limit_turn(player_instruction_limit_turn),
+      player_instruction_limit_game(player_instruction_limit_game),
+      max_no_turns(max_no_turns), player_count(player_count),
+      is_game_timed_out(false), game_timer(), game_duration(game_duration),
+      is_turn_timed_out(false), turn_timer(),
+      player_turn_duration(player_turn_duration),
+      are_player_turns_concurrent(false), logger(std::move(logger)),
+      log_file_name(log_file_name), cancel(false),
+      handoff_spin_count(SharedBuffer::default_spin_count) {
+	for (int i = 0; i < this->player_count; ++i) {
+		this->in_process_buffers.push_back(std::make_unique<SharedBuffer>(
+		    false, 0, player_state::State()));
+		SharedBuffer *shared_buffer = this->in_process_buffers.back().get();
+		shared_buffers.push_back(shared_buffer);
+
+		this->player_states.push_back(&shared_buffer->player_state);
+	}
+}
+
 const std::vector<PlayerResult> MainDriver::Start() {
+#ifdef PROFILE_TURNS
+	// Other games may be running on other threads, so only this thread's
+	// phases are recorded
+	state::Profiler profiler;
+	state::Profiler::SetActive(&profiler);
+#endif
+
 	// Initialize contents of shared memory
 	for (int cur_player_id = 0; cur_player_id < this->player_count;
 	     ++cur_player_id) {
-		this->shared_buffers[cur_player_id]->is_player_running = false;
+		this->shared_buffers[cur_player_id]->SetPlayerRunning(false);
 		this->shared_buffers[cur_player_id]->instruction_counter = 0;
 	}
 
-	// Initialize player states with contents of main state
-	this->state_syncer->UpdatePlayerStates(this->player_states);
-
 	// Start a timer. Game is invalid if it does not complete within the timer
 	// limit
 	this->is_game_timed_out = false;
-	this->game_timer.Start(this->game_duration,
-	                       [this]() { this->is_game_timed_out = true; });
+	this->game_timer.Start(this->game_duration, [this]() {
+		this->is_game_timed_out = true;
+		this->NotifyPlayerWaits();
+	});
 
 	// Run the game and return results
-	return this->Run();
+	auto player_results = this->Run();
+
+	// Players that missed turns are still waiting for them
+	for (auto shared_buffer : this->shared_buffers) {
+		shared_buffer->is_game_over = true;
+	}
+	this->NotifyPlayerWaits();
+
+#ifdef PROFILE_TURNS
+	state::Profiler::SetActive(nullptr);
+	std::ofstream profile_file(this->log_file_name + profile_file_suffix);
+	profiler.WriteJson(profile_file);
+#endif
+
+	return player_results;
 }
 
 const std::vector<PlayerResult> MainDriver::Run() {
@@ -59,51 +138,74 @@ const std::vector<PlayerResult> MainDriver::Run() {
 	std::vector<PlayerResult> player_results(
 	    this->player_count, PlayerResult{0, PlayerResult::Status::UNDEFINED});
 	std::vector<int64_t> player_scores(this->player_count, 0);
+	std::vector<int64_t> instruction_counts(this->player_count, 0);
+	std::vector<int64_t> turn_times_us(this->player_count, 0);
+	std::vector<bool> are_turns_done(this->player_count, false);
 	bool instruction_count_exceeded = false;
 
 	std::ofstream log_file(log_file_name, std::ios::out | std::ios::binary);
+	logger->StartStream(log_file);
+
+	// Initialize player states with contents of main state. This logs the
+	// first state, so the stream must have been started
+	this->state_syncer->UpdatePlayerStates(this->player_states);
 
 	// Main loop that runs every turn
 	for (int i = 0; i < this->max_no_turns; ++i) {
-		// Loop over each player
+		PROFILE_SCOPE(state::ProfilePhase::TURN);
+
+		// Let the players do their updates
+		this->RunPlayerTurns(turn_times_us, are_turns_done);
+
+		// If game has been cancelled, return immediately
+		if (this->cancel) {
+			logger->LogFinalGameParams();
+			logger->WriteGame(log_file);
+			this->game_timer.Cancel();
+			this->cancel = false;
+			return player_results;
+		}
+
+		// Check the players' instruction counts once they are all done
 		for (int cur_player_id = 0; cur_player_id < this->player_count;
 		     ++cur_player_id) {
-			// Let player do his updates
-			this->shared_buffers[cur_player_id]->is_player_running = true;
-
-			// Wait for updates, the timer or cancellation
-			while (this->shared_buffers[cur_player_id]->is_player_running &&
-			       !this->is_game_timed_out && !this->cancel)
-				;
-
-			// If game has been cancelled, return immediately
-			if (this->cancel) {
-				logger->LogFinalGameParams();
-				logger->WriteGame(log_file);
-				this->game_timer.Cancel();
-				this->cancel = false;
-				return player_results;
+			bool is_turn_done = are_turns_done[cur_player_id];
+
+			// A player that ran out of time forfeits the turn. A player process
+			// may still be running, so its instruction count isn't checked
+			if (!is_turn_done && this->in_process_players.empty()) {
+				skip_player_turn[cur_player_id] = true;
+				instruction_counts[cur_player_id] = 0;
+				continue;
 			}
 
 			// Check for instruction counter to see if player has exceeded some
 			// limit
-			if (this->shared_buffers[cur_player_id]->instruction_counter >
+			instruction_counts[cur_player_id] =
+			    this->shared_buffers[cur_player_id]->instruction_counter;
+			if (instruction_counts[cur_player_id] >
 			    this->player_instruction_limit_game) {
 				player_results[cur_player_id].status =
 				    PlayerResult::Status::EXCEEDED_INSTRUCTION_LIMIT;
 				instruction_count_exceeded = true;
-			} else if (this->shared_buffers[cur_player_id]
-			               ->instruction_counter >
+			} else if (instruction_counts[cur_player_id] >
 			           this->player_instruction_limit_turn) {
 				skip_player_turn[cur_player_id] = true;
 			} else {
-				skip_player_turn[cur_player_id] = false;
+				skip_player_turn[cur_player_id] = !is_turn_done;
 			}
+		}
 
-			// Write the turn's instruction counts
-			logger->LogInstructionCount(
-			    static_cast<state::PlayerId>(cur_player_id),
-			    this->shared_buffers[cur_player_id]->instruction_counter);
+		// Write the turn's instruction counts and turn times. The logger may
+		// still be logging the last turn's state while the players run, so
+		// this waits until they are all done
+		for (int cur_player_id = 0; cur_player_id < this->player_count;
+		     ++cur_player_id) {
+			auto player_id = static_cast<state::PlayerId>(cur_player_id);
+			logger->LogTurnTime(player_id, turn_times_us[cur_player_id],
+			                    !are_turns_done[cur_player_id]);
+			logger->LogInstructionCount(player_id,
+			                            instruction_counts[cur_player_id]);
 		}
 
 		// If the game instruction count has been exceeded by some player, game
@@ -145,9 +247,123 @@ const std::vector<PlayerResult> MainDriver::Run() {
 	return player_results;
 }
 
+void MainDriver::RunPlayerTurns(std::vector<int64_t> &turn_times_us,
+                                std::vector<bool> &are_turns_done) {
+	typedef std::chrono::steady_clock Clock;
+	std::fill(turn_times_us.begin(), turn_times_us.end(), 0);
+	std::fill(are_turns_done.begin(), are_turns_done.end(), false);
+
+	if (!this->in_process_players.empty()) {
+		for (int64_t player_id = 0;
+		     player_id < this->player_count && !this->cancel; ++player_id) {
+			PROFILE_START(wait_timer, GetWaitPhase(player_id));
+			auto shared_buffer = this->shared_buffers[player_id];
+
+			// Run the player's code right here. It can't be interrupted, so
+			// timeouts and cancellation are noticed once it returns
+			auto turn_start = Clock::now();
+			shared_buffer->instruction_counter =
+			    this->in_process_players[player_id]->RunTurn(
+			        shared_buffer->player_state);
+			auto turn_time = Clock::now() - turn_start;
+			turn_times_us[player_id] =
+			    std::chrono::duration_cast<std::chrono::microseconds>(turn_time)
+			        .count();
+			are_turns_done[player_id] = turn_time <= this->player_turn_duration;
+			PROFILE_STOP(wait_timer);
+		}
+		return;
+	}
+
+	// Waiting on a player is abandoned on timeouts or cancellation
+	const SharedBuffer::StopCondition is_turn_interrupted = [this]() {
+		return this->is_turn_timed_out || this->is_game_timed_out ||
+		       this->cancel;
+	};
+
+	// Player processes run one at a time, or all at once against one turn
+	// timer
+	int64_t batch_size =
+	    this->are_player_turns_concurrent ? this->player_count : 1;
+
+	for (int64_t first_id = 0; first_id < this->player_count;
+	     first_id += batch_size) {
+		if (this->cancel || this->is_game_timed_out) {
+			return;
+		}
+		int64_t end_id = std::min(first_id + batch_size, this->player_count);
+
+		this->is_turn_timed_out = false;
+		this->turn_timer.Start(this->player_turn_duration, [this]() {
+			this->is_turn_timed_out = true;
+			this->NotifyPlayerWaits();
+		});
+		auto turn_start = Clock::now();
+
+		// Until they are waited on, are_turns_done marks the players that
+		// have been let run
+		for (int64_t player_id = first_id; player_id < end_id; ++player_id) {
+			are_turns_done[player_id] = this->StartPlayerTurn(player_id);
+		}
+
+		// Wait for updates, the timers or cancellation
+		for (int64_t player_id = first_id; player_id < end_id; ++player_id) {
+			if (!are_turns_done[player_id]) {
+				continue;
+			}
+
+			PROFILE_START(wait_timer, GetWaitPhase(player_id));
+			are_turns_done[player_id] =
+			    this->shared_buffers[player_id]->WaitForPlayerRunning(
+			        false, is_turn_interrupted, this->handoff_spin_count);
+			turn_times_us[player_id] =
+			    std::chrono::duration_cast<std::chrono::microseconds>(
+			        Clock::now() - turn_start)
+			        .count();
+			PROFILE_STOP(wait_timer);
+
+			// Leave a player that ran out of time running. The state syncer
+			// writes to a stand in until the player is done with its own copy
+			if (!are_turns_done[player_id] && this->is_turn_timed_out) {
+				this->is_player_stalled[player_id] = true;
+				this->player_states[player_id] =
+				    &this->stalled_player_states[player_id];
+			}
+		}
+
+		this->turn_timer.Cancel();
+	}
+}
+
+bool MainDriver::StartPlayerTurn(int64_t player_id) {
+	auto shared_buffer = this->shared_buffers[player_id];
+
+	if (this->is_player_stalled[player_id]) {
+		if (shared_buffer->is_player_running) {
+			return false;
+		}
+
+		// The player has finished its late turn, but its commands are stale.
+		// It gets its state copy back at the end of this turn
+		this->is_player_stalled[player_id] = false;
+		this->player_states[player_id] = &shared_buffer->player_state;
+		return false;
+	}
+
+	shared_buffer->SetPlayerRunning(true);
+	return true;
+}
+
+void MainDriver::NotifyPlayerWaits() {
+	for (auto shared_buffer : this->shared_buffers) {
+		shared_buffer->Notify();
+	}
+}
+
 void MainDriver::Cancel() {
 	this->cancel = true;
+	this->NotifyPlayerWaits();
 	while (this->cancel)
-		;
+		std::this_thread::yield();
 }
 }
@@ -8,7 +8,11 @@
 
 namespace drivers {
 
-std::atomic<uint64_t> PlayerDriver::instruction_count(0);
+// Initial exec, as the drivers library is never loaded with dlopen, makes
+// this a single access off the thread pointer for every basic block the
+// player code runs
+thread_local uint64_t PlayerDriver::instruction_count
+    __attribute__((tls_model("initial-exec"))) = 0;
 
 PlayerDriver::PlayerDriver(
     std::unique_ptr<player_wrapper::PlayerCodeWrapper> player_code_wrapper,
@@ -23,15 +27,22 @@ PlayerDriver::PlayerDriver(
       player_debug_log_file(player_debug_log_file),
       debug_logs_turn_prefix(debug_logs_turn_prefix),
       debug_logs_truncate_message(debug_logs_truncate_message),
-      max_debug_logs_turn_length(max_debug_logs_turn_length) {}
+      max_debug_logs_turn_length(max_debug_logs_turn_length),
+      last_turn_instruction_count(0),
+      handoff_spin_count(SharedBuffer::default_spin_count) {}
 
 void PlayerDriver::IncrementCount(uint64_t count) {
 	instruction_count += count;
 }
 
-uint64_t PlayerDriver::GetCount() { return instruction_count; }
+void PlayerDriver::ResetCount() { instruction_count = 0; }
+
+uint64_t PlayerDriver::GetThreadCount() { return instruction_count; }
+
+uint64_t PlayerDriver::GetCount() { return last_turn_instruction_count; }
 
 void PlayerDriver::WriteCountToShm() {
+	this->last_turn_instruction_count = instruction_count;
 	this->shared_buffer->instruction_counter = instruction_count;
 }
 
@@ -39,30 +50,34 @@ void PlayerDriver::Start() {
 	// Start a timer. Game is invalid if it does not complete within the timer
 	// limit
 	this->is_game_timed_out = false;
-	this->game_timer.Start(this->game_duration,
-	                       [this]() { this->is_game_timed_out = true; });
+	this->game_timer.Start(this->game_duration, [this]() {
+		this->is_game_timed_out = true;
+		this->shared_buffer->Notify();
+	});
 
 	// Run the game and return results
 	return this->Run();
 }
 
 void PlayerDriver::Run() {
+	// A player that missed turns is still waiting for them when the game
+	// ends
+	const SharedBuffer::StopCondition is_game_stopped = [this]() {
+		return this->is_game_timed_out || this->shared_buffer->is_game_over;
+	};
+
 	// Loop to run the player's code every turn
 	for (int i = 0; i < this->max_no_turns; ++i) {
 
 		// Wait for the main driver to synchronize states or until the game has
-		// timed out
-		while (!this->shared_buffer->is_player_running &&
-		       !this->is_game_timed_out)
-			;
-
-		// If overall game time limit was exceeded, stop the player's code
-		if (this->is_game_timed_out)
+		// timed out or ended
+		if (!this->shared_buffer->WaitForPlayerRunning(
+		        true, is_game_stopped, this->handoff_spin_count))
 			break;
 
 		// Run player's code and get number of instructions they used and their
 		// debug logs
-		instruction_count = 0;
+		ResetCount();
 		auto logs = this->player_code_wrapper->Update(
 		    this->shared_buffer->player_state);
 		this->player_debug_logs << this->debug_logs_turn_prefix
@@ -76,7 +91,7 @@ void PlayerDriver::Run() {
 		this->WriteCountToShm();
 
 		// Let the main driver synchronize states now
-		this->shared_buffer->is_player_running = false;
+		this->shared_buffer->SetPlayerRunning(false);
 	}
 
 	// Open debug log file and store player's debug logs in it
@@ -4,11 +4,121 @@
  */
 
 #include "drivers/shared_memory_utils/shared_buffer.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
 
 namespace drivers {
 
+namespace {
+
+/**
+ * Upper bound on the adaptive spin count
+ */
+const int64_t max_spin_count = 1 << 16;
+
+/**
+ * Longest a waiter sleeps before re-checking its stop condition. Must be under
+ * a second
+ */
+const std::chrono::milliseconds max_sleep_duration(10);
+
+/**
+ * Hints the CPU that we are in a spin loop
+ */
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#else
+	std::this_thread::yield();
+#endif
+}
+
+/**
+ * Sleeps while word equals expected, for at most max_sleep_duration
+ *
+ * The futex is not private as the word lives in memory shared between the
+ * main and player processes
+ */
+void SleepWhileEqual(std::atomic<int32_t> *word, int32_t expected) {
+#ifdef __linux__
+	timespec timeout;
+	timeout.tv_sec = 0;
+	timeout.tv_nsec = std::chrono::nanoseconds(max_sleep_duration).count();
+	syscall(SYS_futex, reinterpret_cast<int32_t *>(word), FUTEX_WAIT,
+	        expected, &timeout, nullptr, 0);
+#else
+	if (*word == expected) {
+		std::this_thread::yield();
+	}
+#endif
+}
+
+/**
+ * Wakes up everyone sleeping on word
+ */
+void WakeAll(std::atomic<int32_t> *word) {
+#ifdef __linux__
+	syscall(SYS_futex, reinterpret_cast<int32_t *>(word), FUTEX_WAKE, INT_MAX,
+	        nullptr, nullptr, 0);
+#endif
+}
+}
+
+const int64_t SharedBuffer::default_spin_count = 1 << 10;
+
 SharedBuffer::SharedBuffer(bool is_player_running, int64_t instruction_counter,
                            const player_state::State &player_state)
     : is_player_running(is_player_running),
-      instruction_counter(instruction_counter), player_state(player_state) {}
+      instruction_counter(instruction_counter), is_game_over(false),
+      player_state(player_state) {}
+
+void SharedBuffer::SetPlayerRunning(bool is_player_running) {
+	this->is_player_running = is_player_running;
+	WakeAll(&this->is_player_running);
+}
+
+void SharedBuffer::Notify() { WakeAll(&this->is_player_running); }
+
+bool SharedBuffer::WaitForPlayerRunning(bool value,
+                                        const StopCondition &stop_condition,
+                                        int64_t &spin_count) {
+	const int32_t expected = value;
+
+	// Spin for a while first, the other side usually hands over quickly
+	for (int64_t i = 0; i < spin_count; ++i) {
+		if (this->is_player_running == expected) {
+			spin_count = std::min(spin_count * 2, max_spin_count);
+			return true;
+		}
+		if (stop_condition()) {
+			return false;
+		}
+		CpuRelax();
+	}
+
+	// Spinning didn't pay off this time, so spin less next time. Never drop
+	// to 0 as that would disable spinning for good
+	spin_count = (spin_count + 1) / 2;
+
+	// Sleep on the flag until it changes or we're asked to stop
+	while (true) {
+		const int32_t current = this->is_player_running;
+		if (current == expected) {
+			return true;
+		}
+		if (stop_condition()) {
+			return false;
+		}
+		SleepWhileEqual(&this->is_player_running, current);
+	}
+}
 }
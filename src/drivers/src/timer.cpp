@@ -1,39 +1,229 @@
+/**
+ * @file timer.cpp
+ * Contains definitions for the timer, and the thread shared by all timers
+ */
+
 #include "drivers/timer.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 namespace drivers {
 
-Timer::Timer()
-    : is_running(false), cancel(false), cur_duration(0),
-      timer_wake_up_duration(10) {}
+namespace {
 
-bool Timer::Start(Interval total_timer_duration, Callback callback) {
-	if (this->is_running) {
-		return false;
+/**
+ * Number of cancelled deadlines allowed to wait in the heap beyond the number
+ * of pending ones, before the heap is rebuilt without them
+ */
+const size_t cancelled_deadline_slack = 64;
+
+/**
+ * Calls the callbacks of all timers, on one thread that sleeps until the
+ * earliest deadline
+ *
+ * Deadlines are kept in a binary heap. Cancelling only forgets the
+ * deadline's id, so the heap entry is dropped when it comes up, or when
+ * cancelled entries outnumber pending ones
+ */
+class TimerThread {
+  private:
+	typedef std::chrono::steady_clock Clock;
+
+	/**
+	 * A deadline and the callback to call on it
+	 */
+	struct Deadline {
+		Clock::time_point time;
+		uint64_t timer_id;
+		Timer::Callback callback;
+	};
+
+	/**
+	 * Orders the heap by earliest deadline first
+	 */
+	static bool IsLater(const Deadline &a, const Deadline &b) {
+		return a.time > b.time;
 	}
 
-	this->is_running = true;
-	this->cur_duration = Interval(0);
+	/**
+	 * Heap of deadlines, cancelled ones included
+	 */
+	std::vector<Deadline> deadlines;
+
+	/**
+	 * Ids of the deadlines that have been neither reached nor cancelled
+	 */
+	std::unordered_set<uint64_t> pending_ids;
+
+	/**
+	 * Id to give the next deadline
+	 */
+	uint64_t next_timer_id;
+
+	/**
+	 * Id of the deadline whose callback is running, 0 if none
+	 */
+	uint64_t running_timer_id;
+
+	bool is_stopping;
 
-	std::thread(
-	    [this](Interval total_timer_duration, Callback callback) {
-		    while (this->cur_duration < total_timer_duration && !this->cancel) {
-			    std::this_thread::sleep_for(this->timer_wake_up_duration);
-			    this->cur_duration += this->timer_wake_up_duration;
-		    }
-		    this->is_running = false;
-		    if (!this->cancel)
-			    callback();
-		},
-	    total_timer_duration, std::ref(callback))
-	    .detach();
+	/**
+	 * Guards all of the above
+	 */
+	std::mutex mutex;
 
+	/**
+	 * Wakes the thread when an earlier deadline is added or it should stop
+	 */
+	std::condition_variable deadlines_changed;
+
+	/**
+	 * Wakes cancellers waiting on a running callback
+	 */
+	std::condition_variable callback_done;
+
+	std::thread thread;
+
+	void Run() {
+		std::unique_lock<std::mutex> lock(this->mutex);
+		while (!this->is_stopping) {
+			if (this->deadlines.empty()) {
+				this->deadlines_changed.wait(lock);
+				continue;
+			}
+
+			auto time = this->deadlines.front().time;
+			if (Clock::now() < time) {
+				this->deadlines_changed.wait_until(lock, time);
+				continue;
+			}
+
+			std::pop_heap(this->deadlines.begin(), this->deadlines.end(),
+			              IsLater);
+			auto deadline = std::move(this->deadlines.back());
+			this->deadlines.pop_back();
+			if (this->pending_ids.erase(deadline.timer_id) == 0) {
+				continue;
+			}
+
+			// Run the callback unlocked, it may start or cancel timers
+			this->running_timer_id = deadline.timer_id;
+			lock.unlock();
+			deadline.callback();
+			lock.lock();
+			this->running_timer_id = 0;
+			this->callback_done.notify_all();
+		}
+	}
+
+  public:
+	TimerThread()
+	    : deadlines(), pending_ids(), next_timer_id(1), running_timer_id(0),
+	      is_stopping(false), thread(&TimerThread::Run, this) {}
+
+	~TimerThread() {
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->is_stopping = true;
+		}
+		this->deadlines_changed.notify_one();
+		this->thread.join();
+	}
+
+	/**
+	 * Adds a deadline
+	 *
+	 * @return     Id of the deadline
+	 */
+	uint64_t Schedule(Timer::Interval duration, Timer::Callback callback) {
+		auto time = Clock::now() + duration;
+		bool is_earliest;
+		uint64_t timer_id;
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			timer_id = this->next_timer_id++;
+			this->deadlines.push_back(
+			    Deadline{time, timer_id, std::move(callback)});
+			std::push_heap(this->deadlines.begin(), this->deadlines.end(),
+			               IsLater);
+			this->pending_ids.insert(timer_id);
+			is_earliest = this->deadlines.front().timer_id == timer_id;
+		}
+
+		if (is_earliest) {
+			this->deadlines_changed.notify_one();
+		}
+		return timer_id;
+	}
+
+	/**
+	 * Returns true if a deadline has been neither reached nor cancelled
+	 */
+	bool IsPending(uint64_t timer_id) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return this->pending_ids.count(timer_id) > 0;
+	}
+
+	/**
+	 * Cancels a deadline, waiting for its callback if it is running
+	 */
+	void Cancel(uint64_t timer_id) {
+		std::unique_lock<std::mutex> lock(this->mutex);
+		if (this->pending_ids.erase(timer_id) > 0 &&
+		    this->deadlines.size() >
+		        2 * this->pending_ids.size() + cancelled_deadline_slack) {
+			auto &pending_ids = this->pending_ids;
+			this->deadlines.erase(
+			    std::remove_if(this->deadlines.begin(), this->deadlines.end(),
+			                   [&pending_ids](const Deadline &deadline) {
+				                   return pending_ids.count(
+				                              deadline.timer_id) == 0;
+			                   }),
+			    this->deadlines.end());
+			std::make_heap(this->deadlines.begin(), this->deadlines.end(),
+			               IsLater);
+		}
+
+		if (std::this_thread::get_id() == this->thread.get_id()) {
+			return;
+		}
+		this->callback_done.wait(lock, [this, timer_id] {
+			return this->running_timer_id != timer_id;
+		});
+	}
+};
+
+/**
+ * Returns the thread shared by all timers, started on first use
+ */
+TimerThread &GetTimerThread() {
+	static TimerThread timer_thread;
+	return timer_thread;
+}
+}
+
+Timer::Timer() : timer_id(0) {}
+
+Timer::~Timer() { Cancel(); }
+
+bool Timer::Start(Interval total_timer_duration, Callback callback) {
+	auto &timer_thread = GetTimerThread();
+	if (timer_thread.IsPending(this->timer_id)) {
+		return false;
+	}
+
+	this->timer_id =
+	    timer_thread.Schedule(total_timer_duration, std::move(callback));
 	return true;
 }
 
 void Timer::Cancel() {
-	this->cancel = true;
-	while (this->is_running)
-		;
-	this->cancel = false;
+	if (this->timer_id != 0) {
+		GetTimerThread().Cancel(this->timer_id);
+	}
 }
 }
@@ -0,0 +1,155 @@
+/**
+ * @file async_logger.h
+ * Declarations for a logger that logs states on a thread of its own
+ */
+
+#ifndef LOGGER_ASYNC_LOGGER_H
+#define LOGGER_ASYNC_LOGGER_H
+
+#include "logger/interfaces/i_logger.h"
+#include "logger/logger_export.h"
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace logger {
+
+/**
+ * Wraps a logger so that states are logged on a thread of its own, and a
+ * turn's state is logged while the players run the next turn
+ *
+ * LogState returns once the state has been handed over. The state must not
+ * change until the next call on the logger, which first waits for the state
+ * to have been logged. Every call reaches the wrapped logger in the order it
+ * was made, so the logs are the same as the wrapped logger's alone
+ *
+ * An exception thrown by the wrapped logger while logging a state is rethrown
+ * from the next call that waits for that state
+ */
+class LOGGER_EXPORT AsyncLogger : public ILogger {
+  private:
+	/**
+	 * The wrapped logger
+	 */
+	std::unique_ptr<ILogger> logger;
+
+	/**
+	 * State waiting to be logged, nullptr if none
+	 */
+	state::IState *pending_state;
+
+	bool is_stopping;
+
+	/**
+	 * Exception thrown while logging the last state, nullptr if none
+	 */
+	std::exception_ptr log_state_error;
+
+	/**
+	 * Guards pending_state, is_stopping and log_state_error
+	 */
+	std::mutex mutex;
+
+	/**
+	 * Wakes the thread when a state is handed over or it should stop
+	 */
+	std::condition_variable state_pending;
+
+	/**
+	 * Wakes callers waiting for the pending state to be logged
+	 */
+	std::condition_variable state_logged;
+
+	std::thread worker;
+
+	/**
+	 * Logs states as they are handed over, until stopped
+	 */
+	void RunWorker();
+
+	/**
+	 * Blocks until the pending state, if any, has been logged
+	 *
+	 * @param[in]  lock  Lock held on mutex
+	 *
+	 * @throw      Whatever the wrapped logger threw logging the state
+	 */
+	void WaitForPendingState(std::unique_lock<std::mutex> &lock);
+
+	/**
+	 * Blocks until the pending state, if any, has been logged
+	 *
+	 * @throw      Whatever the wrapped logger threw logging the state
+	 */
+	void WaitForPendingState();
+
+  public:
+	/**
+	 * Constructor, starts the thread
+	 *
+	 * @param[in]  logger  The logger to wrap
+	 */
+	explicit AsyncLogger(std::unique_ptr<ILogger> logger);
+
+	/**
+	 * Waits for the pending state and stops the thread. An exception thrown
+	 * logging the pending state is dropped
+	 */
+	~AsyncLogger() override;
+
+	AsyncLogger(const AsyncLogger &) = delete;
+	AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+	/**
+	 * @see ILogger#StartStream
+	 */
+	void StartStream(std::ostream &write_stream) override;
+
+	/**
+	 * Hands the state over to the thread to be logged
+	 *
+	 * @throw      Whatever the wrapped logger threw logging the previous state
+	 *
+	 * @see ILogger#LogState
+	 */
+	void LogState(state::IState *state) override;
+
+	/**
+	 * @see ILogger#LogInstructionCount
+	 */
+	void LogInstructionCount(state::PlayerId player_id, int64_t count) override;
+
+	/**
+	 * @see ILogger#LogTurnTime
+	 */
+	void LogTurnTime(state::PlayerId player_id, int64_t turn_time_us,
+	                 bool is_turn_timed_out) override;
+
+	/**
+	 * @see ILogger#LogError
+	 */
+	void LogError(state::PlayerId player_id, ErrorType error_type,
+	              int64_t actor_id, int64_t arg) override;
+
+	/**
+	 * @see ILogger#LogCommand
+	 */
+	void LogCommand(state::PlayerId player_id, CommandType command_type,
+	                int64_t actor_id, int64_t target_id,
+	                physics::Vector position) override;
+
+	/**
+	 * @see ILogger#LogFinalGameParams
+	 */
+	void LogFinalGameParams() override;
+
+	/**
+	 * @see ILogger#WriteGame
+	 */
+	void WriteGame(std::ostream &write_stream) override;
+};
+}
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * file command_type.h
+ * Defines a type to represent the commands run on the main state
+ */
+
+#ifndef LOGGER_COMMAND_TYPE_H
+#define LOGGER_COMMAND_TYPE_H
+
+namespace logger {
+
+/**
+ * Enum representing the commands a player's turn can run on the main state,
+ * one for each command of IState
+ *
+ * ALERT! - The values match proto::COMMAND_TYPE, change both together
+ */
+enum class CommandType {
+	/**
+     * Moving a soldier to a position
+     */
+	MOVE_SOLDIER,
+
+	/**
+     * A soldier attacking an enemy soldier or tower
+     */
+	ATTACK_ACTOR,
+
+	/**
+     * Building a tower at a map offset
+     */
+	BUILD_TOWER,
+
+	/**
+     * Upgrading a tower
+     */
+	UPGRADE_TOWER,
+
+	/**
+     * Destroying one's own tower
+     */
+	SUICIDE_TOWER
+};
+}
+
+#endif
@@ -0,0 +1,251 @@
+/**
+ * @file compressed_log.h
+ * Declares the writer and reader of compressed, seekable game logs
+ */
+
+#ifndef LOGGER_COMPRESSED_LOG_H
+#define LOGGER_COMPRESSED_LOG_H
+
+#include "game.pb.h"
+#include "logger/logger_export.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace logger {
+
+/**
+ * Layout of a compressed game log
+ *
+ * The log is made of the same frames a streaming Logger writes, grouped into
+ * blocks that are each compressed with zlib on their own. The first block
+ * holds the frame of fields that stay the same through the game, each block
+ * after it holds the frames of turns_per_block turns, and the last block
+ * holds the final frame. An index of the blocks follows them, then a footer
+ * that locates the index, so a reader can start at any block
+ *
+ * Decompressing every block in order gives the log a streaming Logger would
+ * have written, which parses as a proto::Game
+ */
+namespace compressed_log {
+
+/**
+ * Header at the start of the file
+ */
+struct Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t turns_per_block;
+};
+
+/**
+ * Index entry for one block
+ */
+struct BlockEntry {
+	/**
+	 * Position of the compressed block from the start of the file
+	 */
+	uint64_t offset;
+
+	uint64_t compressed_size;
+
+	uint64_t uncompressed_size;
+
+	/**
+	 * Turns in the block, counted from 0 for the first logged turn
+	 */
+	uint64_t first_turn;
+
+	uint64_t num_turns;
+};
+
+/**
+ * Footer at the end of the file
+ */
+struct Footer {
+	uint64_t index_offset;
+	uint64_t num_blocks;
+	char magic[8];
+};
+
+/**
+ * Version of the file layout, bump when it changes
+ */
+const uint32_t version = 1;
+}
+
+/**
+ * Groups the frames of a streamed log into blocks, and writes them
+ * compressed along with an index
+ */
+class LOGGER_EXPORT CompressedLogWriter {
+  private:
+	/**
+	 * Stream the log is written to
+	 */
+	std::ostream *write_stream;
+
+	/**
+	 * Number of turns that go into each block
+	 */
+	int64_t turns_per_block;
+
+	/**
+	 * Bytes written so far
+	 */
+	uint64_t offset;
+
+	/**
+	 * Frames of the block being filled
+	 */
+	std::string block;
+
+	/**
+	 * Turns in the block being filled
+	 */
+	int64_t block_turns;
+
+	/**
+	 * Turns written so far, including those in the block being filled
+	 */
+	int64_t num_turns;
+
+	/**
+	 * Entries of the blocks written so far
+	 */
+	std::vector<compressed_log::BlockEntry> index;
+
+	/**
+	 * Scratch space for compressing a block
+	 */
+	std::string compressed_block;
+
+	/**
+	 * Compresses and writes the block being filled, then empties it
+	 *
+	 * @throw      std::runtime_error If the block could not be compressed
+	 */
+	void WriteBlock();
+
+	/**
+	 * Writes raw bytes to the stream
+	 */
+	void WriteBytes(const void *data, size_t size);
+
+  public:
+	/**
+	 * Constructor for CompressedLogWriter, writes the file header
+	 *
+	 * @param[in]  write_stream     Stream to write the log to
+	 * @param[in]  turns_per_block  Number of turns to compress together
+	 *
+	 * @throw      std::out_of_range If turns_per_block is not positive
+	 */
+	CompressedLogWriter(std::ostream &write_stream, int64_t turns_per_block);
+
+	/**
+	 * Writes the frame of fields that stay the same through the game, which
+	 * must come before any turn
+	 *
+	 * @param[in]  frame  Serialized frame
+	 *
+	 * @throw      std::runtime_error If the block could not be compressed
+	 */
+	void WriteStaticFrame(const std::string &frame);
+
+	/**
+	 * Adds the frame of the next turn, writing out the block once full
+	 *
+	 * @param[in]  frame  Serialized frame
+	 *
+	 * @throw      std::runtime_error If the block could not be compressed
+	 */
+	void WriteTurnFrame(const std::string &frame);
+
+	/**
+	 * Writes out the last turns, the final frame, the index and the footer
+	 *
+	 * @param[in]  frame  Serialized final frame
+	 *
+	 * @throw      std::runtime_error If a block could not be compressed
+	 */
+	void Finish(const std::string &frame);
+};
+
+/**
+ * Reads a compressed game log, a block at a time
+ */
+class LOGGER_EXPORT CompressedLogReader {
+  private:
+	/**
+	 * Stream the log is read from
+	 */
+	std::istream *read_stream;
+
+	/**
+	 * Index of the blocks in the log
+	 */
+	std::vector<compressed_log::BlockEntry> index;
+
+	/**
+	 * Number of turns in the log
+	 */
+	int64_t num_turns;
+
+  public:
+	CompressedLogReader();
+
+	/**
+	 * Reads the index of a compressed log
+	 *
+	 * @param[in]  read_stream  Stream holding the log, must stay open while
+	 *                          the log is read
+	 *
+	 * @return     True if the stream holds a compressed log of this version
+	 *             whose blocks all lie within it
+	 */
+	bool Open(std::istream &read_stream);
+
+	/**
+	 * Returns the number of turns in the log
+	 */
+	int64_t GetNumTurns();
+
+	/**
+	 * Decompresses the block holding a turn, without reading other blocks
+	 *
+	 * @param[in]   turn        Turn to read, counted from 0
+	 * @param[out]  game        Game holding the states of the block's turns
+	 * @param[out]  first_turn  Turn of game's first state
+	 *
+	 * @return      True if the block was read and parsed
+	 *
+	 * @throw       std::out_of_range If the log has no such turn
+	 */
+	bool ReadTurns(int64_t turn, proto::Game &game, int64_t &first_turn);
+
+	/**
+	 * Decompresses the whole log
+	 *
+	 * @param[out]  game  The logged game
+	 *
+	 * @return      True if every block was read and parsed
+	 */
+	bool ReadGame(proto::Game &game);
+
+	/**
+	 * Decompresses one block
+	 *
+	 * @param[in]   block   Position of the block in the index
+	 * @param[out]  frames  Frames in the block
+	 *
+	 * @return      True if the block was read. False if its index entry
+	 *              claims more data than the block could hold
+	 */
+	bool ReadBlock(int64_t block, std::string &frames);
+};
+}
+
+#endif
@@ -6,6 +6,11 @@
 #ifndef LOGGER_ERROR_TYPE_H
 #define LOGGER_ERROR_TYPE_H
 
+#include "physics/vector.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -44,7 +49,8 @@ enum class ErrorType {
 	NO_ATTACK_BASE_TOWER,
 
 	/**
-     * Trying to move a soldier to an invalid position
+     * Trying to move a soldier to an invalid position. The error's arg holds
+     * the position, see PackErrorPosition
      */
 	INVALID_POSITION,
 
@@ -96,7 +102,17 @@ enum class ErrorType {
 	/**
      * Trying to attack soldier that is currently invulnerable
      */
-	NO_ATTACK_IMMUNE_SOLDIER
+	NO_ATTACK_IMMUNE_SOLDIER,
+
+	/**
+     * Issuing a command for an actor that doesn't exist, or of no known type
+     */
+	INVALID_COMMAND,
+
+	/**
+     * Issuing commands after the command buffer was full
+     */
+	NO_MORE_COMMANDS
 };
 
 /**
@@ -110,7 +126,53 @@ const std::vector<std::string> ErrorTypeName = {
     "NO_ATTACK_DEAD_SOLDIER",    "INVALID_TERRITORY",
     "INSUFFICIENT_FUNDS",        "NO_MORE_UPGRADES",
     "NO_SUICIDE_BASE_TOWER",     "NO_MORE_TOWERS",
-    "NO_ATTACK_RAZED_TOWER",     "NO_ATTACK_IMMUNE_SOLDIER"};
+    "NO_ATTACK_RAZED_TOWER",     "NO_ATTACK_IMMUNE_SOLDIER",
+    "INVALID_COMMAND",           "NO_MORE_COMMANDS"};
+
+/**
+ * Packs a position into the arg of an error, as the bits of its coordinates
+ * as floats, x in the high half. Positions in errors may be off the map or
+ * not even finite, so they are kept as they are rather than rounded
+ *
+ * @param[in]  position  position to pack
+ *
+ * @return     the error's arg
+ */
+inline int64_t PackErrorPosition(physics::Vector position) {
+	auto to_bits = [](double coordinate) {
+		// Doubles beyond the range of a float become infinite
+		float value = static_cast<float>(
+		    std::abs(coordinate) > std::numeric_limits<float>::max()
+		        ? std::copysign(std::numeric_limits<double>::infinity(),
+		                        coordinate)
+		        : coordinate);
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return static_cast<uint64_t>(bits);
+	};
+
+	return static_cast<int64_t>((to_bits(position.x) << 32) |
+	                            to_bits(position.y));
+}
+
+/**
+ * Unpacks a position packed by PackErrorPosition
+ *
+ * @param[in]  arg   the error's arg
+ *
+ * @return     the position
+ */
+inline physics::Vector UnpackErrorPosition(int64_t arg) {
+	auto to_coordinate = [](uint32_t bits) {
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return static_cast<double>(value);
+	};
+
+	auto bits = static_cast<uint64_t>(arg);
+	return physics::Vector(to_coordinate(static_cast<uint32_t>(bits >> 32)),
+	                       to_coordinate(static_cast<uint32_t>(bits)));
+}
 }
 
 #endif
@@ -6,9 +6,12 @@
 #ifndef LOGGER_I_LOGGER_H
 #define LOGGER_I_LOGGER_H
 
+#include "logger/command_type.h"
 #include "logger/error_type.h"
 #include "logger/logger_export.h"
+#include "physics/vector.h"
 #include "state/interfaces/i_state.h"
+#include <cstdint>
 #include <ostream>
 #include <string>
 
@@ -21,6 +24,15 @@ class LOGGER_EXPORT ILogger {
   public:
 	virtual ~ILogger(){};
 
+	/**
+	 * Gives the logger the stream the game will be written to, so that it
+	 * can write the logs as the game goes. Should be called once, before the
+	 * first state is logged, and WriteGame called later with the same stream
+	 *
+	 * @param[in]   write_stream   Stream to write the logs to
+	 */
+	virtual void StartStream(std::ostream &write_stream) = 0;
+
 	/**
 	 * Takes a pointer to the main state, and logs all information
 	 *
@@ -38,16 +50,48 @@ class LOGGER_EXPORT ILogger {
 	virtual void LogInstructionCount(state::PlayerId player_id,
 	                                 int64_t count) = 0;
 
+	/**
+	 * Takes a player and how long the main driver waited on its turn, and
+	 * logs it in the current turn's game frame
+	 *
+	 * @param[in]   player_id          Player identifier
+	 * @param[in]   turn_time_us       Wall clock time waited on the player,
+	 *                                 in microseconds
+	 * @param[in]   is_turn_timed_out  true if the player's turn was skipped
+	 *                                 for running past the turn time limit
+	 */
+	virtual void LogTurnTime(state::PlayerId player_id, int64_t turn_time_us,
+	                         bool is_turn_timed_out) = 0;
+
 	/**
 	 * Takes a player and the error, and logs it into the state. Every distinct
-	 * string is assigned an error code and stored in the error_map
+	 * error is assigned an error code, and its message is stored in the
+	 * error_map when the game ends
 	 *
 	 * @param[in]   player_id    The player identifier
 	 * @param[in]   error_type   The error type
-	 * @param[in]   message      The error string
+	 * @param[in]   actor_id     The actor that made the error, -1 if none
+	 * @param[in]   arg          The actor or value the error concerns, such
+	 *                           as the target of an attack, -1 if none
 	 */
 	virtual void LogError(state::PlayerId player_id, ErrorType error_type,
-	                      std::string message) = 0;
+	                      int64_t actor_id, int64_t arg) = 0;
+
+	/**
+	 * Logs a command run on the main state, so that the game can be replayed
+	 * from the commands. The commands of a turn are logged with the state
+	 * that follows them, in the order they were run
+	 *
+	 * @param[in]   player_id     The player identifier
+	 * @param[in]   command_type  The command type
+	 * @param[in]   actor_id      The soldier or tower commanded, -1 if none
+	 * @param[in]   target_id     The actor attacked, -1 if none
+	 * @param[in]   position      The soldier's destination, or the map offset
+	 *                            to build a tower on
+	 */
+	virtual void LogCommand(state::PlayerId player_id,
+	                        CommandType command_type, int64_t actor_id,
+	                        int64_t target_id, physics::Vector position) = 0;
 
 	/**
 	 * Logs final game parameters, should be called once, right before logging
@@ -7,13 +7,21 @@
 #define LOGGER_LOGGER_H
 
 #include "game.pb.h"
+#include "google/protobuf/arena.h"
+#include "logger/command_type.h"
+#include "logger/compressed_log.h"
 #include "logger/error_type.h"
 #include "logger/interfaces/i_logger.h"
 #include "logger/logger_export.h"
+#include "state/actor/tower.h"
 #include "state/interfaces/i_state.h"
+#include <condition_variable>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -28,12 +36,125 @@ struct TowerLogEntry {
 	int64_t level;
 };
 
+/**
+ * An error as logged, before its message is formatted
+ */
+struct ErrorKey {
+	ErrorType error_type;
+	int64_t actor_id;
+	int64_t arg;
+
+	bool operator==(const ErrorKey &other) const {
+		return error_type == other.error_type && actor_id == other.actor_id &&
+		       arg == other.arg;
+	}
+};
+
+/**
+ * Hash for ErrorKey, so that errors are told apart without building strings
+ */
+struct ErrorKeyHash {
+	size_t operator()(const ErrorKey &key) const {
+		const uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+		uint64_t hash = static_cast<uint64_t>(key.error_type);
+		hash = hash * multiplier + static_cast<uint64_t>(key.actor_id);
+		hash = hash * multiplier + static_cast<uint64_t>(key.arg);
+		return hash ^ (hash >> 32);
+	}
+};
+
+/**
+ * A command as logged, until the turn's state is
+ */
+struct CommandEntry {
+	state::PlayerId player_id;
+	CommandType command_type;
+	int64_t actor_id;
+	int64_t target_id;
+	physics::Vector position;
+};
+
+/**
+ * Entry for one soldier in the logger, as last logged
+ */
+struct SoldierLogEntry {
+	int64_t hp;
+	int x;
+	int y;
+	proto::SOLDIER_STATE state;
+	int attack_target_x;
+	int attack_target_y;
+};
+
+/**
+ * When the logger writes the game to its stream
+ */
+enum class LogWriteMode {
+	/**
+	 * Keep the whole game in memory and write it in WriteGame
+	 */
+	WHOLE_GAME,
+
+	/**
+	 * Write each turn's state to the stream as soon as it is logged
+	 */
+	STREAM,
+
+	/**
+	 * Like STREAM, but the writes are done on a separate thread so that the
+	 * turn does not wait on them
+	 */
+	STREAM_ON_THREAD
+};
+
 /**
  * Logger class that takes the current game state and logs information
- * Writes log to file system after game is complete
+ * Writes log to file system after game is complete, or as the game goes when
+ * streaming
+ *
+ * A streamed log is a sequence of frames. The first is a Game holding only
+ * the fields that stay the same through the game, each turn's state follows
+ * as a Game states entry, that is, a tag and a length delimited GameState,
+ * and the last frame is a Game holding only the error_map. Since protobuf
+ * merges concatenated messages, the whole log parses as the same Game that a
+ * WHOLE_GAME logger writes
+ *
+ * A streamed log can also be written compressed, as laid out in
+ * compressed_log
+ *
+ * Soldiers can be delta logged, like towers are, with keyframes holding
+ * every soldier and tower at intervals so that replays can start from them
  */
 class LOGGER_EXPORT Logger : public ILogger {
   private:
+	/**
+	 * Kinds of frame in a streamed log
+	 */
+	enum class FrameType {
+		/**
+		 * Fields that stay the same through the game
+		 */
+		STATIC,
+
+		/**
+		 * One turn's state
+		 */
+		TURN,
+
+		/**
+		 * Fields known at the end of the game
+		 */
+		FINAL
+	};
+
+	/**
+	 * A serialized frame and its kind
+	 */
+	struct Frame {
+		FrameType type;
+		std::string bytes;
+	};
+
 	/**
 	 * Number of turns since the start of the game
 	 */
@@ -47,9 +168,23 @@ class LOGGER_EXPORT Logger : public ILogger {
 	std::vector<std::vector<TowerLogEntry>> tower_logs;
 
 	/**
-	 * Protobuf object holding complete game logs
+	 * A log of every soldier, in the order of all players' soldiers
+	 * Maintains the soldiers as last logged, so that only the fields that
+	 * changed need to be logged when soldiers are delta logged
+	 */
+	std::vector<SoldierLogEntry> soldier_logs;
+
+	/**
+	 * Arena the protobuf objects are allocated on, nullptr if they are
+	 * allocated on the heap one by one
+	 */
+	std::unique_ptr<google::protobuf::Arena> arena;
+
+	/**
+	 * Protobuf object holding complete game logs. Owned by arena, or by the
+	 * logger when there is no arena
 	 */
-	std::unique_ptr<proto::Game> logs;
+	proto::Game *logs;
 
 	/**
 	 * Stores the instruction counts until they are written into the log along
@@ -58,9 +193,22 @@ class LOGGER_EXPORT Logger : public ILogger {
 	std::vector<int64_t> instruction_counts;
 
 	/**
-	 * Map holding mapping of error strings to error codes
+	 * Stores the turn times and timeouts until they are written into the log,
+	 * every turn
+	 */
+	std::vector<int64_t> turn_times_us;
+	std::vector<bool> turns_timed_out;
+
+	/**
+	 * Map holding mapping of errors to error codes
+	 */
+	std::unordered_map<ErrorKey, int64_t, ErrorKeyHash> error_map;
+
+	/**
+	 * Errors in the order of their codes, formatted into messages when the
+	 * game ends
 	 */
-	std::unordered_map<std::string, int64_t> error_map;
+	std::vector<ErrorKey> error_keys;
 
 	/**
 	 * Holds an incrementing value to assign each error a unique code
@@ -72,6 +220,11 @@ class LOGGER_EXPORT Logger : public ILogger {
 	 */
 	std::vector<std::vector<int64_t>> errors;
 
+	/**
+	 * Commands run since the last state was logged
+	 */
+	std::vector<CommandEntry> commands;
+
 	/**
 	 * Number of instructions exceeding which the turn is forfeit
 	 */
@@ -82,12 +235,133 @@ class LOGGER_EXPORT Logger : public ILogger {
 	 */
 	int64_t player_instruction_limit_game;
 
+	/**
+	 * When the game is written to the stream
+	 */
+	LogWriteMode write_mode;
+
+	/**
+	 * Stream that frames are written to, nullptr until streaming starts
+	 */
+	std::ostream *write_stream;
+
+	/**
+	 * Holds the state being logged this turn when streaming, so that logs
+	 * keeps only the fields that stay the same through the game. Cleared
+	 * after each turn, which keeps its allocations for the next. Owned like
+	 * logs
+	 */
+	proto::Game *state_frame;
+
+	/**
+	 * Number of turns to compress together when streaming, 0 to write the
+	 * frames as they are
+	 */
+	int64_t turns_per_block;
+
+	/**
+	 * Number of turns from one keyframe to the next, between which soldiers
+	 * are delta logged. 0 to log every soldier every turn
+	 */
+	int64_t turns_per_keyframe;
+
+	/**
+	 * Writes the frames compressed, when compressing
+	 */
+	std::unique_ptr<CompressedLogWriter> compressed_log_writer;
+
+	/**
+	 * Thread that writes frames, when writing on a thread
+	 */
+	std::thread writer;
+
+	/**
+	 * Serialized frames waiting for the writer thread
+	 */
+	std::vector<Frame> pending_frames;
+
+	/**
+	 * Set to have the writer thread return once pending frames are written
+	 */
+	bool is_writer_stopping;
+
+	/**
+	 * Guards pending_frames and is_writer_stopping
+	 */
+	std::mutex writer_mutex;
+
+	/**
+	 * Signals the writer thread that frames are pending or it should stop
+	 */
+	std::condition_variable writer_cv;
+
+	/**
+	 * Logs every property of a tower
+	 *
+	 * @param[in]  game_state  State of the turn being logged
+	 * @param[in]  tower       The tower
+	 */
+	void LogTower(proto::GameState *game_state, state::Tower *tower);
+
+	/**
+	 * Writes a frame to the stream, or hands it to the writer thread
+	 *
+	 * @param[in]  type   Kind of frame
+	 * @param[in]  bytes  Serialized frame
+	 */
+	void WriteFrame(FrameType type, std::string bytes);
+
+	/**
+	 * Writes a frame to the stream, compressing it if need be
+	 *
+	 * @param[in]  frame  The frame
+	 */
+	void OutputFrame(const Frame &frame);
+
+	/**
+	 * Writes frames handed to the writer thread until it is stopped
+	 */
+	void RunWriter();
+
+	/**
+	 * Stops the writer thread, if it is running
+	 *
+	 * @param[in]  is_drained  Whether frames still pending are written first
+	 *                         or dropped
+	 */
+	void StopWriter(bool is_drained);
+
   public:
 	/**
 	 * Constructor for the Logger class
+	 *
+	 * @param[in]  player_instruction_limit_turn  Turn instruction limit
+	 * @param[in]  player_instruction_limit_game  Game instruction limit
+	 * @param[in]  write_mode                     When the game is written
+	 * @param[in]  turns_per_block                Number of turns to compress
+	 *                                            together when streaming, 0
+	 *                                            to not compress
+	 * @param[in]  turns_per_keyframe             Number of turns from one
+	 *                                            keyframe to the next, 0 to
+	 *                                            log every soldier each turn
+	 * @param[in]  is_arena_allocated             Whether to allocate the logs
+	 *                                            on an arena, which makes
+	 *                                            allocating and freeing them
+	 *                                            cheap
 	 */
 	Logger(int64_t player_instruction_limit_turn,
-	       int64_t player_instruction_limit_game);
+	       int64_t player_instruction_limit_game,
+	       LogWriteMode write_mode = LogWriteMode::WHOLE_GAME,
+	       int64_t turns_per_block = 0, int64_t turns_per_keyframe = 0,
+	       bool is_arena_allocated = false);
+
+	~Logger();
+
+	/**
+	 * @see ILogger#StartStream
+	 * Does nothing when writing the whole game at the end
+	 */
+	void StartStream(std::ostream &write_stream) override;
 
 	/**
 	 * @see ILogger#LogState
@@ -99,20 +373,36 @@ class LOGGER_EXPORT Logger : public ILogger {
 	 */
 	void LogInstructionCount(state::PlayerId player_id, int64_t count) override;
 
+	/**
+	 * @see ILogger#LogTurnTime
+	 */
+	void LogTurnTime(state::PlayerId player_id, int64_t turn_time_us,
+	                 bool is_turn_timed_out) override;
+
 	/**
 	 * @see ILogger#LogError
 	 */
 	void LogError(state::PlayerId player_id, ErrorType error_type,
-	              std::string message) override;
+	              int64_t actor_id, int64_t arg) override;
+
+	/**
+	 * @see ILogger#LogCommand
+	 */
+	void LogCommand(state::PlayerId player_id, CommandType command_type,
+	                int64_t actor_id, int64_t target_id,
+	                physics::Vector position) override;
 
 	/**
 	 * @see ILogger#LogFinalGameParams
+	 * Formats the message of every error logged, as
+	 * "ERROR_TYPE: <message_string>"
 	 */
 	void LogFinalGameParams() override;
 
 	/**
 	 * @see ILogger#WriteGame
-	 * Defaults to std::cout when no stream passed
+	 * Defaults to std::cout when no stream passed. When streaming, writes the
+	 * final frame and waits for all frames to be written
 	 */
 	void WriteGame(std::ostream &write_stream = std::cout) override;
 };
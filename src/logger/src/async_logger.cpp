@@ -0,0 +1,117 @@
+/**
+ * @file async_logger.cpp
+ * Defines the logger that logs states on a thread of its own
+ */
+
+#include "logger/async_logger.h"
+
+namespace logger {
+
+AsyncLogger::AsyncLogger(std::unique_ptr<ILogger> logger)
+    : logger(std::move(logger)), pending_state(nullptr), is_stopping(false),
+      worker(&AsyncLogger::RunWorker, this) {}
+
+AsyncLogger::~AsyncLogger() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->is_stopping = true;
+	}
+	this->state_pending.notify_one();
+	this->worker.join();
+}
+
+void AsyncLogger::RunWorker() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	while (true) {
+		this->state_pending.wait(lock, [this] {
+			return this->is_stopping || this->pending_state != nullptr;
+		});
+		if (this->pending_state == nullptr) {
+			return;
+		}
+
+		// Log unlocked, the caller only takes the lock to hand over the next
+		// call
+		auto *state = this->pending_state;
+		lock.unlock();
+		std::exception_ptr error;
+		try {
+			this->logger->LogState(state);
+		} catch (...) {
+			// Handed back to the caller, as nothing catches it on this thread
+			error = std::current_exception();
+		}
+		lock.lock();
+
+		this->log_state_error = error;
+		this->pending_state = nullptr;
+		this->state_logged.notify_all();
+	}
+}
+
+void AsyncLogger::WaitForPendingState(std::unique_lock<std::mutex> &lock) {
+	this->state_logged.wait(
+	    lock, [this] { return this->pending_state == nullptr; });
+
+	if (this->log_state_error != nullptr) {
+		auto error = this->log_state_error;
+		this->log_state_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void AsyncLogger::WaitForPendingState() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	WaitForPendingState(lock);
+}
+
+void AsyncLogger::StartStream(std::ostream &write_stream) {
+	WaitForPendingState();
+	this->logger->StartStream(write_stream);
+}
+
+void AsyncLogger::LogState(state::IState *state) {
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		WaitForPendingState(lock);
+		this->pending_state = state;
+	}
+	this->state_pending.notify_one();
+}
+
+void AsyncLogger::LogInstructionCount(state::PlayerId player_id,
+                                      int64_t count) {
+	WaitForPendingState();
+	this->logger->LogInstructionCount(player_id, count);
+}
+
+void AsyncLogger::LogTurnTime(state::PlayerId player_id, int64_t turn_time_us,
+                              bool is_turn_timed_out) {
+	WaitForPendingState();
+	this->logger->LogTurnTime(player_id, turn_time_us, is_turn_timed_out);
+}
+
+void AsyncLogger::LogError(state::PlayerId player_id, ErrorType error_type,
+                           int64_t actor_id, int64_t arg) {
+	WaitForPendingState();
+	this->logger->LogError(player_id, error_type, actor_id, arg);
+}
+
+void AsyncLogger::LogCommand(state::PlayerId player_id,
+                             CommandType command_type, int64_t actor_id,
+                             int64_t target_id, physics::Vector position) {
+	WaitForPendingState();
+	this->logger->LogCommand(player_id, command_type, actor_id, target_id,
+	                         position);
+}
+
+void AsyncLogger::LogFinalGameParams() {
+	WaitForPendingState();
+	this->logger->LogFinalGameParams();
+}
+
+void AsyncLogger::WriteGame(std::ostream &write_stream) {
+	WaitForPendingState();
+	this->logger->WriteGame(write_stream);
+}
+}
@@ -0,0 +1,227 @@
+/**
+ * @file compressed_log.cpp
+ * Defines the writer and reader of compressed, seekable game logs
+ */
+
+#include "logger/compressed_log.h"
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace logger {
+
+using namespace compressed_log;
+
+namespace {
+
+const char header_magic[8] = {'C', 'C', 'L', 'O', 'G', 'Z', '\0', '\0'};
+
+const char footer_magic[8] = {'C', 'C', 'L', 'O', 'G', 'I', 'D', 'X'};
+
+/**
+ * Deflate never shrinks data by more than this ratio, so a block entry
+ * claiming more is corrupt
+ */
+const uint64_t max_compression_ratio = 1032;
+
+/**
+ * Reads exactly size bytes at a position of a stream
+ */
+bool ReadAt(std::istream &stream, uint64_t offset, void *data, size_t size) {
+	stream.clear();
+	stream.seekg(offset);
+	stream.read(static_cast<char *>(data), size);
+	return static_cast<size_t>(stream.gcount()) == size;
+}
+}
+
+CompressedLogWriter::CompressedLogWriter(std::ostream &write_stream,
+                                         int64_t turns_per_block)
+    : write_stream(&write_stream), turns_per_block(turns_per_block),
+      offset(0), block(), block_turns(0), num_turns(0), index(),
+      compressed_block() {
+	if (turns_per_block <= 0) {
+		throw std::out_of_range("turns_per_block must be positive");
+	}
+
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, header_magic, sizeof(header.magic));
+	header.version = compressed_log::version;
+	header.turns_per_block = turns_per_block;
+	WriteBytes(&header, sizeof(header));
+}
+
+void CompressedLogWriter::WriteBytes(const void *data, size_t size) {
+	this->write_stream->write(static_cast<const char *>(data), size);
+	this->offset += size;
+}
+
+void CompressedLogWriter::WriteBlock() {
+	auto max_size = compressBound(this->block.size());
+	this->compressed_block.resize(max_size);
+	if (compress2(reinterpret_cast<Bytef *>(&this->compressed_block[0]),
+	              &max_size,
+	              reinterpret_cast<const Bytef *>(this->block.data()),
+	              this->block.size(), Z_BEST_SPEED) != Z_OK) {
+		throw std::runtime_error("Could not compress log block");
+	}
+
+	BlockEntry entry;
+	entry.offset = this->offset;
+	entry.compressed_size = max_size;
+	entry.uncompressed_size = this->block.size();
+	entry.first_turn = this->num_turns - this->block_turns;
+	entry.num_turns = this->block_turns;
+	this->index.push_back(entry);
+
+	WriteBytes(this->compressed_block.data(), max_size);
+	this->block.clear();
+	this->block_turns = 0;
+}
+
+void CompressedLogWriter::WriteStaticFrame(const std::string &frame) {
+	this->block = frame;
+	WriteBlock();
+}
+
+void CompressedLogWriter::WriteTurnFrame(const std::string &frame) {
+	this->block += frame;
+	this->block_turns++;
+	this->num_turns++;
+
+	if (this->block_turns == this->turns_per_block) {
+		WriteBlock();
+		this->write_stream->flush();
+	}
+}
+
+void CompressedLogWriter::Finish(const std::string &frame) {
+	if (this->block_turns > 0) {
+		WriteBlock();
+	}
+	this->block = frame;
+	WriteBlock();
+
+	Footer footer;
+	std::memset(&footer, 0, sizeof(footer));
+	footer.index_offset = this->offset;
+	footer.num_blocks = this->index.size();
+	std::memcpy(footer.magic, footer_magic, sizeof(footer.magic));
+
+	WriteBytes(this->index.data(), this->index.size() * sizeof(BlockEntry));
+	WriteBytes(&footer, sizeof(footer));
+	this->write_stream->flush();
+}
+
+CompressedLogReader::CompressedLogReader()
+    : read_stream(nullptr), index(), num_turns(0) {}
+
+bool CompressedLogReader::Open(std::istream &read_stream) {
+	this->read_stream = &read_stream;
+	this->index.clear();
+	this->num_turns = 0;
+
+	Header header;
+	if (!ReadAt(read_stream, 0, &header, sizeof(header)) ||
+	    std::memcmp(header.magic, header_magic, sizeof(header.magic)) != 0 ||
+	    header.version != compressed_log::version) {
+		return false;
+	}
+
+	read_stream.clear();
+	read_stream.seekg(0, std::ios::end);
+	uint64_t file_size = read_stream.tellg();
+
+	Footer footer;
+	if (file_size < sizeof(Header) + sizeof(Footer) ||
+	    !ReadAt(read_stream, file_size - sizeof(Footer), &footer,
+	            sizeof(footer)) ||
+	    std::memcmp(footer.magic, footer_magic, sizeof(footer.magic)) != 0 ||
+	    footer.index_offset + footer.num_blocks * sizeof(BlockEntry) !=
+	        file_size - sizeof(Footer)) {
+		return false;
+	}
+
+	this->index.resize(footer.num_blocks);
+	if (!ReadAt(read_stream, footer.index_offset, this->index.data(),
+	            footer.num_blocks * sizeof(BlockEntry))) {
+		this->index.clear();
+		return false;
+	}
+
+	for (auto &entry : this->index) {
+		// Every block lies between the header and the index
+		if (entry.offset < sizeof(Header) ||
+		    entry.offset > footer.index_offset ||
+		    entry.compressed_size > footer.index_offset - entry.offset) {
+			this->index.clear();
+			this->num_turns = 0;
+			return false;
+		}
+		this->num_turns += entry.num_turns;
+	}
+
+	return true;
+}
+
+int64_t CompressedLogReader::GetNumTurns() { return this->num_turns; }
+
+bool CompressedLogReader::ReadBlock(int64_t block, std::string &frames) {
+	auto &entry = this->index[block];
+
+	std::string compressed_block(entry.compressed_size, '\0');
+	if (!ReadAt(*this->read_stream, entry.offset, &compressed_block[0],
+	            entry.compressed_size)) {
+		return false;
+	}
+
+	// Checked before allocating, so that a corrupt entry cannot ask for
+	// more memory than its block can hold
+	if (entry.uncompressed_size >
+	    entry.compressed_size * max_compression_ratio) {
+		return false;
+	}
+
+	frames.resize(entry.uncompressed_size);
+	uLongf size = entry.uncompressed_size;
+	return uncompress(reinterpret_cast<Bytef *>(&frames[0]), &size,
+	                  reinterpret_cast<const Bytef *>(compressed_block.data()),
+	                  entry.compressed_size) == Z_OK &&
+	       size == entry.uncompressed_size;
+}
+
+bool CompressedLogReader::ReadTurns(int64_t turn, proto::Game &game,
+                                    int64_t &first_turn) {
+	if (turn < 0 || turn >= this->num_turns) {
+		throw std::out_of_range("Log has no such turn");
+	}
+
+	// Turn blocks are in order, so the last one starting at or before the
+	// turn holds it
+	int64_t block = 0;
+	for (size_t i = 0; i < this->index.size(); ++i) {
+		if (this->index[i].num_turns > 0 &&
+		    this->index[i].first_turn <= static_cast<uint64_t>(turn)) {
+			block = i;
+		}
+	}
+
+	std::string frames;
+	first_turn = this->index[block].first_turn;
+	return ReadBlock(block, frames) && game.ParseFromString(frames);
+}
+
+bool CompressedLogReader::ReadGame(proto::Game &game) {
+	std::string frames;
+	for (size_t i = 0; i < this->index.size(); ++i) {
+		std::string block_frames;
+		if (!ReadBlock(i, block_frames)) {
+			return false;
+		}
+		frames += block_frames;
+	}
+
+	return game.ParseFromString(frames);
+}
+}
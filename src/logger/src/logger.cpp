@@ -12,24 +12,239 @@ using namespace state;
 
 namespace logger {
 
+namespace {
+
+/**
+ * Sizes of the first and largest blocks the arena allocates, in bytes
+ */
+const size_t arena_start_block_size = 64 * 1024;
+
+const size_t arena_max_block_size = 1024 * 1024;
+
+/**
+ * Returns the message for an error
+ */
+std::string FormatError(ErrorType error_type, int64_t actor_id, int64_t arg) {
+	switch (error_type) {
+	case ErrorType::NO_MULTIPLE_SOLDIER_TASKS:
+		return "Soldier with id " + std::to_string(actor_id) +
+		       " can perform only one task each turn";
+	case ErrorType::NO_MULTIPLE_TOWER_TASKS:
+		return "Tower with id " + std::to_string(actor_id) +
+		       " can perform only one task each turn";
+	case ErrorType::NO_ALTER_ACTOR_ID:
+		return "Do not alter id of actors";
+	case ErrorType::NO_ACTION_BY_DEAD_SOLDIER:
+		return "Soldier with id " + std::to_string(actor_id) +
+		       " must be alive in order to act";
+	case ErrorType::NO_ATTACK_BASE_TOWER:
+		return "Cannot attack Base Tower of enemy";
+	case ErrorType::INVALID_POSITION: {
+		auto position = UnpackErrorPosition(arg);
+		return "Soldier with id " + std::to_string(actor_id) +
+		       " cannot move to position (" + std::to_string(position.x) +
+		       "," + std::to_string(position.y) + ") outside the map";
+	}
+	case ErrorType::NO_ATTACK_SELF_TOWER:
+		return "Attack enemy's tower only";
+	case ErrorType::NO_ATTACK_SELF_SOLDIER:
+		return "Attack enemy's soldier only";
+	case ErrorType::NO_ATTACK_DEAD_SOLDIER:
+		return "Enemy soldier with id " + std::to_string(arg) +
+		       " must be alive to attack it";
+	case ErrorType::INVALID_TERRITORY:
+		return "Tower can be built only on valid territory.";
+	case ErrorType::INSUFFICIENT_FUNDS:
+		if (actor_id == -1) {
+			return "Insufficient funds to build tower";
+		}
+		return "Insufficient funds to upgrade tower with id " +
+		       std::to_string(actor_id);
+	case ErrorType::NO_MORE_UPGRADES:
+		return "Max level reached, upgrade not allowed for tower with id " +
+		       std::to_string(actor_id);
+	case ErrorType::NO_SUICIDE_BASE_TOWER:
+		return "Cannot destroy base tower";
+	case ErrorType::NO_MORE_TOWERS:
+		return "No more towers can be built. Max limit reached.";
+	case ErrorType::NO_ATTACK_RAZED_TOWER:
+		return "Can't attack tower with id " + std::to_string(arg) +
+		       " as it has been destroyed by the opponent";
+	case ErrorType::NO_ATTACK_IMMUNE_SOLDIER:
+		return "Cannot damage invulnerable soldier with id " +
+		       std::to_string(arg);
+	case ErrorType::INVALID_COMMAND:
+		return "Command at index " + std::to_string(arg) +
+		       " is of an unknown type or for an actor you don't have";
+	case ErrorType::NO_MORE_COMMANDS:
+		return "Command buffer full, later commands were dropped";
+	}
+
+	return "";
+}
+}
+
 Logger::Logger(int64_t player_instruction_limit_turn,
-               int64_t player_instruction_limit_game)
-    : turn_count(0), tower_logs(), logs(std::make_unique<proto::Game>()),
+               int64_t player_instruction_limit_game, LogWriteMode write_mode,
+               int64_t turns_per_block, int64_t turns_per_keyframe,
+               bool is_arena_allocated)
+    : turn_count(0), tower_logs(), soldier_logs(), arena(nullptr),
+      logs(nullptr),
       instruction_counts(std::vector<int64_t>((int)PlayerId::PLAYER_COUNT, 0)),
-      error_map(std::unordered_map<std::string, int64_t>()),
-      current_error_code(0),
+      turn_times_us(std::vector<int64_t>((int)PlayerId::PLAYER_COUNT, 0)),
+      turns_timed_out(std::vector<bool>((int)PlayerId::PLAYER_COUNT, false)),
+      error_map(), error_keys(), current_error_code(0),
       errors(std::vector<std::vector<int64_t>>(
           (int)state::PlayerId::PLAYER_COUNT, std::vector<int64_t>())),
+      commands(),
       player_instruction_limit_turn(player_instruction_limit_turn),
-      player_instruction_limit_game(player_instruction_limit_game) {}
+      player_instruction_limit_game(player_instruction_limit_game),
+      write_mode(write_mode), write_stream(nullptr),
+      state_frame(nullptr),
+      turns_per_block(turns_per_block), turns_per_keyframe(turns_per_keyframe),
+      compressed_log_writer(nullptr),
+      writer(),
+      pending_frames(), is_writer_stopping(false) {
+	if (is_arena_allocated) {
+		// A game's logs run to megabytes, so let blocks grow past the small
+		// default cap rather than allocating thousands of them
+		google::protobuf::ArenaOptions arena_options;
+		arena_options.start_block_size = arena_start_block_size;
+		arena_options.max_block_size = arena_max_block_size;
+		this->arena = std::make_unique<google::protobuf::Arena>(arena_options);
+	}
+
+	// Allocated on the heap when there is no arena
+	this->logs =
+	    google::protobuf::Arena::CreateMessage<proto::Game>(this->arena.get());
+	this->state_frame =
+	    google::protobuf::Arena::CreateMessage<proto::Game>(this->arena.get());
+}
+
+Logger::~Logger() {
+	// The stream may be gone by now, so frames not yet written are dropped
+	StopWriter(false);
+
+	// Messages on an arena are freed all at once along with it
+	if (this->arena == nullptr) {
+		delete this->logs;
+		delete this->state_frame;
+	}
+}
+
+void Logger::StartStream(std::ostream &write_stream) {
+	if (this->write_mode == LogWriteMode::WHOLE_GAME) {
+		return;
+	}
+
+	this->write_stream = &write_stream;
+	if (this->turns_per_block > 0) {
+		this->compressed_log_writer = std::make_unique<CompressedLogWriter>(
+		    write_stream, this->turns_per_block);
+	}
+	if (this->write_mode == LogWriteMode::STREAM_ON_THREAD) {
+		this->is_writer_stopping = false;
+		this->writer = std::thread(&Logger::RunWriter, this);
+	}
+}
+
+void Logger::WriteFrame(FrameType type, std::string bytes) {
+	Frame frame{type, std::move(bytes)};
+	if (this->write_mode == LogWriteMode::STREAM_ON_THREAD) {
+		{
+			std::lock_guard<std::mutex> lock(this->writer_mutex);
+			this->pending_frames.push_back(std::move(frame));
+		}
+		this->writer_cv.notify_one();
+		return;
+	}
+
+	OutputFrame(frame);
+	this->write_stream->flush();
+}
+
+void Logger::OutputFrame(const Frame &frame) {
+	if (this->compressed_log_writer == nullptr) {
+		this->write_stream->write(frame.bytes.data(), frame.bytes.size());
+		return;
+	}
+
+	switch (frame.type) {
+	case FrameType::STATIC:
+		this->compressed_log_writer->WriteStaticFrame(frame.bytes);
+		break;
+	case FrameType::TURN:
+		this->compressed_log_writer->WriteTurnFrame(frame.bytes);
+		break;
+	case FrameType::FINAL:
+		this->compressed_log_writer->Finish(frame.bytes);
+		break;
+	}
+}
+
+void Logger::RunWriter() {
+	std::vector<Frame> frames;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(this->writer_mutex);
+			this->writer_cv.wait(lock, [this] {
+				return this->is_writer_stopping ||
+				       !this->pending_frames.empty();
+			});
+			if (this->pending_frames.empty()) {
+				return;
+			}
+			frames.swap(this->pending_frames);
+		}
+
+		// Write outside the lock so that the turn loop never waits on I/O
+		// or compression
+		for (auto &frame : frames) {
+			OutputFrame(frame);
+		}
+		this->write_stream->flush();
+		frames.clear();
+	}
+}
+
+void Logger::StopWriter(bool is_drained) {
+	if (!this->writer.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->writer_mutex);
+		if (!is_drained) {
+			this->pending_frames.clear();
+		}
+		this->is_writer_stopping = true;
+	}
+	this->writer_cv.notify_one();
+	this->writer.join();
+}
 
 void Logger::LogState(IState *state) {
 	turn_count++;
-	auto *game_state = logs->add_states();
 
-	auto soldiers = state->GetAllSoldiers();
-	auto towers = state->GetAllTowers();
-	auto money = state->GetMoney();
+	// When streaming, the state is kept apart from the fields in logs that
+	// stay the same through the game, and written once the turn is logged
+	bool is_streaming = this->write_stream != nullptr;
+	auto *game_state =
+	    is_streaming ? state_frame->add_states() : logs->add_states();
+
+	auto &soldiers = state->GetAllSoldiers();
+	auto &towers = state->GetAllTowers();
+	auto &money = state->GetMoney();
+
+	// Keyframes start the game, every turns_per_keyframe turns after it,
+	// and each compressed block, so that a replay can start from any of them
+	auto turn_index = turn_count - 1;
+	bool is_keyframe =
+	    turn_index == 0 ||
+	    (turns_per_keyframe > 0 && turn_index % turns_per_keyframe == 0) ||
+	    (compressed_log_writer != nullptr &&
+	     turn_index % turns_per_block == 0);
+	game_state->set_is_keyframe(is_keyframe);
 
 	if (turn_count == 1) {
 		// Stuff that should only be done on the first turn
@@ -62,15 +277,7 @@ void Logger::LogState(IState *state) {
 		for (auto player_towers : towers) {
 			std::vector<TowerLogEntry> player_tower_log_entry;
 			for (auto tower : player_towers) {
-				proto::Tower *t_tower = game_state->add_towers();
-				t_tower->set_id((int)tower->GetActorId());
-				t_tower->set_player_id((int)tower->GetPlayerId());
-				t_tower->set_hp(tower->GetHp());
-				t_tower->set_x((int)tower->GetPosition().x);
-				t_tower->set_y((int)tower->GetPosition().y);
-				t_tower->set_is_base(tower->GetIsBase());
-				t_tower->set_tower_level(tower->GetTowerLevel());
-				t_tower->set_is_dead(false);
+				LogTower(game_state, tower);
 
 				player_tower_log_entry.push_back({(int)tower->GetActorId(),
 				                                  tower->GetHp(),
@@ -106,16 +313,24 @@ void Logger::LogState(IState *state) {
 					    curr_log.level != (int)curr_tower->GetTowerLevel()) {
 
 						// An existing tower's stats have changed. Log it
-						auto *t_tower = game_state->add_towers();
-						t_tower->set_id((int)curr_tower->GetActorId());
-						t_tower->set_player_id(i);
-						t_tower->set_hp(curr_tower->GetHp());
-						t_tower->set_tower_level(curr_tower->GetTowerLevel());
+						if (is_keyframe) {
+							LogTower(game_state, curr_tower);
+						} else {
+							auto *t_tower = game_state->add_towers();
+							t_tower->set_id((int)curr_tower->GetActorId());
+							t_tower->set_player_id(i);
+							t_tower->set_hp(curr_tower->GetHp());
+							t_tower->set_tower_level(
+							    curr_tower->GetTowerLevel());
+						}
 
 						// Update the tower log as well
 						tower_logs[i][log_ptr].hp = curr_tower->GetHp();
 						tower_logs[i][log_ptr].level =
 						    (int)curr_tower->GetTowerLevel();
+					} else if (is_keyframe) {
+						// Keyframes log unchanged towers too
+						LogTower(game_state, curr_tower);
 					}
 
 					log_ptr++;
@@ -161,15 +376,7 @@ void Logger::LogState(IState *state) {
 				auto *curr_tower = towers[i][tower_ptr];
 
 				// A newly built tower. Log it.
-				auto *t_tower = game_state->add_towers();
-				t_tower->set_id((int)curr_tower->GetActorId());
-				t_tower->set_player_id((int)curr_tower->GetPlayerId());
-				t_tower->set_hp(curr_tower->GetHp());
-				t_tower->set_x((int)curr_tower->GetPosition().x);
-				t_tower->set_y((int)curr_tower->GetPosition().y);
-				t_tower->set_is_base(curr_tower->GetIsBase());
-				t_tower->set_tower_level(curr_tower->GetTowerLevel());
-				t_tower->set_is_dead(false);
+				LogTower(game_state, curr_tower);
 
 				// Add to the tower log as well
 				tower_logs[i].push_back({(int)curr_tower->GetActorId(),
@@ -182,36 +389,94 @@ void Logger::LogState(IState *state) {
 
 	// Stuff that's done on all turns
 
-	// Log all the soldiers
-	for (auto player_soldiers : soldiers) {
-		for (auto soldier : player_soldiers) {
-			auto *t_soldier = game_state->add_soldiers();
-			t_soldier->set_hp(soldier->GetHp());
-			t_soldier->set_x((int)soldier->GetPosition().x);
-			t_soldier->set_y((int)soldier->GetPosition().y);
+	// Log the soldiers. Every soldier on keyframes, or when soldiers aren't
+	// delta logged, otherwise only the fields that changed
+	bool is_soldier_delta = turns_per_keyframe > 0 && !is_keyframe;
+	game_state->set_is_soldier_delta(is_soldier_delta);
+	int soldier_index = 0;
+	for (auto &player_soldiers : soldiers) {
+		for (auto *soldier : player_soldiers) {
+			SoldierLogEntry entry = {
+			    soldier->GetHp(), (int)soldier->GetPosition().x,
+			    (int)soldier->GetPosition().y, proto::IDLE, -1, -1};
 			switch (soldier->GetState()) {
 			case SoldierStateName::ATTACK:
-				t_soldier->set_state(proto::ATTACK);
+				entry.state = proto::ATTACK;
 				break;
 			case SoldierStateName::PURSUIT:
 			case SoldierStateName::MOVE:
-				t_soldier->set_state(proto::MOVE);
+				entry.state = proto::MOVE;
 				break;
 			case SoldierStateName::IDLE:
-				t_soldier->set_state(proto::IDLE);
+				entry.state = proto::IDLE;
 				break;
 			case SoldierStateName::DEAD:
-				t_soldier->set_state(proto::DEAD);
+				entry.state = proto::DEAD;
 				break;
 			}
 			if (soldier->IsAttackTargetSet()) {
 				auto target_pos = soldier->GetAttackTarget()->GetPosition();
-				t_soldier->set_attack_target_x(target_pos.x);
-				t_soldier->set_attack_target_y(target_pos.y);
-			} else {
-				t_soldier->set_attack_target_x(-1);
-				t_soldier->set_attack_target_y(-1);
+				entry.attack_target_x = target_pos.x;
+				entry.attack_target_y = target_pos.y;
+			}
+
+			if (!is_soldier_delta) {
+				auto *t_soldier = game_state->add_soldiers();
+				t_soldier->set_hp(entry.hp);
+				t_soldier->set_x(entry.x);
+				t_soldier->set_y(entry.y);
+				t_soldier->set_state(entry.state);
+				t_soldier->set_attack_target_x(entry.attack_target_x);
+				t_soldier->set_attack_target_y(entry.attack_target_y);
+
+				if (soldier_index == soldier_logs.size()) {
+					soldier_logs.push_back(entry);
+				} else {
+					soldier_logs[soldier_index] = entry;
+				}
+				soldier_index++;
+				continue;
+			}
+
+			// Compare against the soldier as last logged
+			auto &curr_log = soldier_logs[soldier_index];
+			int changed_fields = proto::NO_SOLDIER_CHANGE;
+			if (curr_log.hp != entry.hp) {
+				changed_fields |= proto::HP_CHANGED;
+			}
+			if (curr_log.x != entry.x || curr_log.y != entry.y) {
+				changed_fields |= proto::POSITION_CHANGED;
+			}
+			if (curr_log.state != entry.state) {
+				changed_fields |= proto::STATE_CHANGED;
+			}
+			if (curr_log.attack_target_x != entry.attack_target_x ||
+			    curr_log.attack_target_y != entry.attack_target_y) {
+				changed_fields |= proto::ATTACK_TARGET_CHANGED;
 			}
+
+			if (changed_fields != proto::NO_SOLDIER_CHANGE) {
+				// The soldier changed. Log only what did
+				auto *t_soldier = game_state->add_soldiers();
+				t_soldier->set_index(soldier_index);
+				t_soldier->set_changed_fields(changed_fields);
+				if (changed_fields & proto::HP_CHANGED) {
+					t_soldier->set_hp(entry.hp);
+				}
+				if (changed_fields & proto::POSITION_CHANGED) {
+					t_soldier->set_x(entry.x);
+					t_soldier->set_y(entry.y);
+				}
+				if (changed_fields & proto::STATE_CHANGED) {
+					t_soldier->set_state(entry.state);
+				}
+				if (changed_fields & proto::ATTACK_TARGET_CHANGED) {
+					t_soldier->set_attack_target_x(entry.attack_target_x);
+					t_soldier->set_attack_target_y(entry.attack_target_y);
+				}
+				curr_log = entry;
+			}
+			soldier_index++;
 		}
 	}
 
@@ -226,6 +491,14 @@ void Logger::LogState(IState *state) {
 		inst_count = 0;
 	}
 
+	// Log turn times and timeouts, and reset them
+	for (int player_id = 0; player_id < turn_times_us.size(); ++player_id) {
+		game_state->add_turn_times_us(turn_times_us[player_id]);
+		game_state->add_turns_timed_out(turns_timed_out[player_id]);
+		turn_times_us[player_id] = 0;
+		turns_timed_out[player_id] = false;
+	}
+
 	// Log the errors, clear the error vectors
 	for (auto &player_errors : errors) {
 		auto player_error_struct = game_state->add_player_errors();
@@ -234,40 +507,101 @@ void Logger::LogState(IState *state) {
 		}
 		player_errors.clear();
 	}
+
+	// Log the commands that led to this state, and the state's hash
+	for (auto &command : commands) {
+		auto *t_command = game_state->add_commands();
+		t_command->set_player_id((int)command.player_id);
+		t_command->set_type(
+		    static_cast<proto::COMMAND_TYPE>(command.command_type));
+		t_command->set_actor_id(command.actor_id);
+		t_command->set_target_id(command.target_id);
+		t_command->set_x(command.position.x);
+		t_command->set_y(command.position.y);
+	}
+	commands.clear();
+	game_state->set_state_hash(state->GetHash());
+
+	if (is_streaming) {
+		if (turn_count == 1) {
+			WriteFrame(FrameType::STATIC, logs->SerializeAsString());
+		}
+		WriteFrame(FrameType::TURN, state_frame->SerializeAsString());
+		state_frame->Clear();
+	}
+}
+
+void Logger::LogTower(proto::GameState *game_state, Tower *tower) {
+	auto *t_tower = game_state->add_towers();
+	t_tower->set_id((int)tower->GetActorId());
+	t_tower->set_player_id((int)tower->GetPlayerId());
+	t_tower->set_hp(tower->GetHp());
+	t_tower->set_x((int)tower->GetPosition().x);
+	t_tower->set_y((int)tower->GetPosition().y);
+	t_tower->set_is_base(tower->GetIsBase());
+	t_tower->set_tower_level(tower->GetTowerLevel());
+	t_tower->set_is_dead(false);
 }
 
 void Logger::LogInstructionCount(PlayerId player_id, int64_t count) {
 	this->instruction_counts[(int)player_id] = count;
 }
 
-void Logger::LogError(state::PlayerId player_id, ErrorType error_type,
-                      std::string message) {
-	int64_t error_code;
+void Logger::LogTurnTime(PlayerId player_id, int64_t turn_time_us,
+                         bool is_turn_timed_out) {
+	this->turn_times_us[(int)player_id] = turn_time_us;
+	this->turns_timed_out[(int)player_id] = is_turn_timed_out;
+}
 
-	// Encode the message as "ERROR_TYPE: <message_string>"
-	std::string full_message = ErrorTypeName[(int)error_type] + ": " + message;
+void Logger::LogError(state::PlayerId player_id, ErrorType error_type,
+                      int64_t actor_id, int64_t arg) {
+	ErrorKey error_key{error_type, actor_id, arg};
 
-	// If the message doesn't exist in the map, add an entry in the map and
+	// If the error doesn't exist in the map, add an entry in the map and
 	// increment the counter
-	if (error_map.find(full_message) == error_map.end()) {
-		error_code = current_error_code++;
-		error_map[full_message] = error_code;
-	} else {
-		error_code = error_map[full_message];
+	auto inserted = error_map.emplace(error_key, current_error_code);
+	if (inserted.second) {
+		current_error_code++;
+		error_keys.push_back(error_key);
 	}
 
-	errors[(int)player_id].push_back(error_code);
+	errors[(int)player_id].push_back(inserted.first->second);
+}
+
+void Logger::LogCommand(state::PlayerId player_id, CommandType command_type,
+                        int64_t actor_id, int64_t target_id,
+                        physics::Vector position) {
+	commands.push_back(
+	    CommandEntry{player_id, command_type, actor_id, target_id, position});
 }
 
 void Logger::LogFinalGameParams() {
-	// Write the error mapping to logs
-	// Flip the mapping, int error_code -> string message
-	for (auto element : error_map) {
-		(*logs->mutable_error_map())[element.second] = element.first;
+	// Write the error mapping to logs, int error_code -> string message
+	// Encode the message as "ERROR_TYPE: <message_string>"
+	auto &logged_error_map = *logs->mutable_error_map();
+	for (int64_t error_code = 0; error_code < error_keys.size(); ++error_code) {
+		auto &error_key = error_keys[error_code];
+		logged_error_map[error_code] =
+		    ErrorTypeName[(int)error_key.error_type] + ": " +
+		    FormatError(error_key.error_type, error_key.actor_id,
+		                error_key.arg);
 	}
 }
 
 void Logger::WriteGame(std::ostream &write_stream) {
-	logs->SerializeToOstream(&write_stream);
+	if (this->write_stream == nullptr) {
+		logs->SerializeToOstream(&write_stream);
+		return;
+	}
+
+	// The other fields of logs went out in the first frame
+	proto::Game final_frame;
+	*final_frame.mutable_error_map() = logs->error_map();
+	WriteFrame(FrameType::FINAL, final_frame.SerializeAsString());
+
+	StopWriter(true);
+	this->write_stream->flush();
+	this->write_stream = nullptr;
+	this->compressed_log_writer.reset();
 }
 }
@@ -1,11 +1,15 @@
 #include "boost/process.hpp"
 #include "constants/constants.h"
+#include "drivers/in_process_player.h"
 #include "drivers/main_driver.h"
 #include "drivers/shared_memory_utils/shared_memory_main.h"
 #include "drivers/timer.h"
+#include "logger/async_logger.h"
+#include "logger/compressed_log.h"
 #include "logger/logger.h"
 #include "physics/vector.h"
 #include "state/actor/actor.h"
+#include "state/actor/actor_id_allocator.h"
 #include "state/actor/soldier.h"
 #include "state/map/interfaces/i_map.h"
 #include "state/map/map.h"
@@ -14,9 +18,18 @@
 #include "state/state.h"
 #include "state/state_syncer/state_syncer.h"
 #include "state/utilities.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <random>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <thread>
 
@@ -29,26 +42,79 @@ namespace bp = boost::process;
 
 int num_players = (int)PlayerId::PLAYER_COUNT;
 
-auto Soldier::total_turns_to_respawn = SOLDIER_TOTAL_TURNS_TO_RESPAWN;
-auto Soldier::respawn_positions = BASE_TOWER_POSITIONS;
-auto Soldier::total_num_turns_invulnerable = SOLDIER_NUM_TURNS_INVULNERABLE;
+const std::string GAME_LOG_FILE_NAME = "game.log";
 
-auto Tower::max_hp_levels = TOWER_HPS;
+const std::string MATCH_SERVER_MODE = "match_server";
 
-auto TowerManager::build_costs = TOWER_BUILD_COSTS;
-auto TowerManager::tower_ranges = TOWER_RANGES;
+const std::string IN_PROCESS_MODE = "in_process";
 
-const std::string GAME_LOG_FILE_NAME = "game.log";
+const std::string REPLAY_MODE = "replay";
+
+const std::string PLAYER_LIBRARY_SUFFIX = ".so";
+
+const std::string PLAYER_DEBUG_LOG_SUFFIX = ".dlog";
+
+const std::string DEBUG_LOGS_TURN_PREFIX =
+    ">>>>>>>>>>>>>>>>>>>START OF TURN LOG<<<<<<<<<<<<<<<<<<<<\n";
+
+const std::string DEBUG_LOGS_TRUNCATE_MESSAGE =
+    "(logs truncated due to excessive size)\n";
+
+const int64_t MAX_DEBUG_LOGS_TURN_LENGTH = 10000;
+
+/**
+ * Everything needed to run one match
+ */
+struct MatchSpec {
+	/**
+	 * Paths to the player executables, in player order. If they are all
+	 * player code libraries instead, the players are run in process
+	 */
+	std::vector<std::string> player_binaries;
 
-std::vector<std::string> shm_names(num_players);
+	/**
+	 * Tag identifying the match, echoed back with its results. The game
+	 * itself is deterministic and doesn't consume it
+	 */
+	std::string seed;
+
+	/**
+	 * Path to write the game log to
+	 */
+	std::string output_path;
+
+	/**
+	 * Paths the players write debug logs to. Players pick their own path if
+	 * empty
+	 */
+	std::vector<std::string> player_debug_logs;
+};
+
+/**
+ * Sets the static members of state classes to the game's constants
+ *
+ * The members are already defined in the state library, defining them again
+ * here would have them constructed and destroyed twice
+ */
+void SetGameConstants() {
+	Soldier::total_turns_to_respawn = SOLDIER_TOTAL_TURNS_TO_RESPAWN;
+	Soldier::respawn_positions = BASE_TOWER_POSITIONS;
+	Soldier::total_num_turns_invulnerable = SOLDIER_NUM_TURNS_INVULNERABLE;
+
+	Tower::max_hp_levels = TOWER_HPS;
+
+	TowerManager::build_costs = TOWER_BUILD_COSTS;
+	TowerManager::tower_ranges = TOWER_RANGES;
+}
 
 std::string GenerateRandomString(const std::string::size_type length) {
-	static std::string chars = "0123456789"
-	                           "abcdefghijklmnopqrstuvwxyz"
-	                           "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	static const std::string chars = "0123456789"
+	                                 "abcdefghijklmnopqrstuvwxyz"
+	                                 "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
-	static std::mt19937 gen{std::random_device{}()};
-	static std::uniform_int_distribution<std::string::size_type> dis(
+	// Matches may be set up from several threads at once
+	thread_local std::mt19937 gen{std::random_device{}()};
+	thread_local std::uniform_int_distribution<std::string::size_type> dis(
 	    0, chars.length() - 1);
 
 	std::string s(length, '*');
@@ -84,30 +150,33 @@ std::unique_ptr<MoneyManager> BuildMoneyManager() {
 
 std::unique_ptr<Soldier> BuildSoldier(PlayerId player_id,
                                       IPathPlanner *path_planner,
-                                      MoneyManager *money_manager) {
+                                      MoneyManager *money_manager,
+                                      ActorIdAllocator *actor_id_allocator) {
 	return std::make_unique<Soldier>(
-	    Actor::GetNextActorId(), player_id, ActorType::SOLDIER, SOLDIER_MAX_HP,
-	    SOLDIER_MAX_HP, BASE_TOWER_POSITIONS[(int)player_id], SOLDIER_SPEED,
-	    SOLDIER_ATTACK_RANGE, SOLDIER_ATTACK_DAMAGE, path_planner,
-	    money_manager);
+	    actor_id_allocator->GetNextActorId(), player_id, ActorType::SOLDIER,
+	    SOLDIER_MAX_HP, SOLDIER_MAX_HP, BASE_TOWER_POSITIONS[(int)player_id],
+	    SOLDIER_SPEED, SOLDIER_ATTACK_RANGE, SOLDIER_ATTACK_DAMAGE,
+	    path_planner, money_manager);
 }
 
 std::unique_ptr<TowerManager>
-BuildTowerManager(PlayerId player_id, MoneyManager *money_manager, IMap *map) {
+BuildTowerManager(PlayerId player_id, MoneyManager *money_manager, IMap *map,
+                  ActorIdAllocator *actor_id_allocator) {
 	auto tower = std::make_unique<Tower>(
-	    Actor::GetNextActorId(), player_id, ActorType::TOWER, TOWER_HPS[0],
-	    TOWER_HPS[0], BASE_TOWER_POSITIONS[(int)player_id], true, 1);
+	    actor_id_allocator->GetNextActorId(), player_id, ActorType::TOWER,
+	    TOWER_HPS[0], TOWER_HPS[0], BASE_TOWER_POSITIONS[(int)player_id], true,
+	    1);
 
 	std::vector<std::unique_ptr<Tower>> towers;
 	towers.push_back(std::move(tower));
 
 	return std::make_unique<TowerManager>(std::move(towers), player_id,
-	                                      money_manager, map);
+	                                      money_manager, map,
+	                                      actor_id_allocator);
 }
 
 std::unique_ptr<State> BuildState() {
-	Actor::SetActorIdIncrement();
-
+	auto actor_id_allocator = std::make_unique<ActorIdAllocator>();
 	auto map = BuildMap();
 	auto path_planner = std::make_unique<SimplePathPlanner>(map.get());
 	auto money_manager = BuildMoneyManager();
@@ -119,30 +188,40 @@ std::unique_ptr<State> BuildState() {
 		for (int i = 0; i < NUM_SOLDIERS; ++i) {
 			soldiers[player_id].push_back(
 			    BuildSoldier(static_cast<PlayerId>(player_id),
-			                 path_planner.get(), money_manager.get()));
+			                 path_planner.get(), money_manager.get(),
+			                 actor_id_allocator.get()));
 		}
 	}
 
 	for (int player_id = 0; player_id < num_players; ++player_id) {
 		tower_managers[player_id] = BuildTowerManager(
-		    static_cast<PlayerId>(player_id), money_manager.get(), map.get());
+		    static_cast<PlayerId>(player_id), money_manager.get(), map.get(),
+		    actor_id_allocator.get());
 	}
 
 	return std::make_unique<State>(
 	    std::move(soldiers), std::move(map), std::move(money_manager),
-	    std::move(tower_managers), std::move(path_planner));
+	    std::move(tower_managers), std::move(path_planner),
+	    std::move(actor_id_allocator));
 }
 
-std::unique_ptr<drivers::MainDriver> BuildMainDriver() {
-	auto logger = std::make_unique<Logger>(PLAYER_INSTRUCTION_LIMIT_TURN,
-	                                       PLAYER_INSTRUCTION_LIMIT_GAME);
+std::unique_ptr<ILogger> BuildLogger() {
+	// Each turn's state is logged while the players run the next turn
+	return std::make_unique<AsyncLogger>(std::make_unique<Logger>(
+	    PLAYER_INSTRUCTION_LIMIT_TURN, PLAYER_INSTRUCTION_LIMIT_GAME,
+	    LogWriteMode::STREAM_ON_THREAD));
+}
+
+std::unique_ptr<drivers::MainDriver>
+BuildMainDriver(const std::vector<std::string> &shm_names,
+                const std::string &game_log_file_name) {
+	auto logger = BuildLogger();
 
 	auto state_syncer = std::make_unique<StateSyncer>(
 	    BuildState(), logger.get(), TOWER_BUILD_COSTS, MAX_NUM_TOWERS);
 	std::vector<std::unique_ptr<SharedMemoryMain>> shm_mains;
 
 	for (int i = 0; i < num_players; ++i) {
-		shm_names[i] = GenerateRandomString(64) + std::to_string(i);
 		shm_mains.push_back(std::make_unique<SharedMemoryMain>(
 		    shm_names[i], false, 0, player_state::State()));
 	}
@@ -150,36 +229,94 @@ std::unique_ptr<drivers::MainDriver> BuildMainDriver() {
 	return std::make_unique<MainDriver>(
 	    std::move(state_syncer), std::move(shm_mains),
 	    PLAYER_INSTRUCTION_LIMIT_TURN, PLAYER_INSTRUCTION_LIMIT_GAME, NUM_TURNS,
-	    num_players, Timer::Interval(GAME_DURATION_MS), std::move(logger),
-	    GAME_LOG_FILE_NAME);
+	    num_players, Timer::Interval(GAME_DURATION_MS),
+	    Timer::Interval(PLAYER_TURN_DURATION_MS), ARE_PLAYER_TURNS_CONCURRENT,
+	    std::move(logger), game_log_file_name);
 }
 
-int main(int argc, char *argv[]) {
-	std::string prefix_key;
-	if (argc < 2) {
-		prefix_key = "codecharacter";
-		std::cerr
-		    << "WARNING: main needs a key to prefix scores with for security,"
-		       "running with default key value now...";
-	} else {
-		prefix_key = std::string(argv[1]);
+bool IsPlayerLibrary(const std::string &player_binary) {
+	return player_binary.size() > PLAYER_LIBRARY_SUFFIX.size() &&
+	       player_binary.compare(
+	           player_binary.size() - PLAYER_LIBRARY_SUFFIX.size(),
+	           PLAYER_LIBRARY_SUFFIX.size(), PLAYER_LIBRARY_SUFFIX) == 0;
+}
+
+/**
+ * Runs a match to completion with the player code libraries loaded into this
+ * process, on the calling thread
+ *
+ * The player code is not isolated from the simulator, so this is only for
+ * trusted code
+ */
+std::vector<PlayerResult> RunInProcessMatch(const MatchSpec &match_spec) {
+	std::vector<std::unique_ptr<InProcessPlayer>> players;
+	for (int i = 0; i < num_players; ++i) {
+		auto player_debug_log_file =
+		    match_spec.player_debug_logs.empty()
+		        ? match_spec.player_binaries[i] + PLAYER_DEBUG_LOG_SUFFIX
+		        : match_spec.player_debug_logs[i];
+
+		try {
+			players.push_back(std::make_unique<InProcessPlayer>(
+			    match_spec.player_binaries[i], player_debug_log_file,
+			    DEBUG_LOGS_TURN_PREFIX, DEBUG_LOGS_TRUNCATE_MESSAGE,
+			    MAX_DEBUG_LOGS_TURN_LENGTH));
+		} catch (const std::runtime_error &error) {
+			std::cerr << error.what() << std::endl;
+			std::vector<PlayerResult> results(
+			    num_players,
+			    PlayerResult{0, PlayerResult::Status::UNDEFINED});
+			results[i].status = PlayerResult::Status::RUNTIME_ERROR;
+			return results;
+		}
 	}
 
-	std::cout << "Starting main...\n";
-	auto driver = BuildMainDriver();
+	auto logger = BuildLogger();
+	auto state_syncer = std::make_unique<StateSyncer>(
+	    BuildState(), logger.get(), TOWER_BUILD_COSTS, MAX_NUM_TOWERS);
+
+	MainDriver driver(std::move(state_syncer), std::move(players),
+	                  PLAYER_INSTRUCTION_LIMIT_TURN,
+	                  PLAYER_INSTRUCTION_LIMIT_GAME, NUM_TURNS, num_players,
+	                  Timer::Interval(GAME_DURATION_MS),
+	                  Timer::Interval(PLAYER_TURN_DURATION_MS),
+	                  std::move(logger), match_spec.output_path);
+
+	return driver.Start();
+}
+
+/**
+ * Runs a match to completion, launching its player processes, or in process
+ * if the players are all given as player code libraries
+ */
+std::vector<PlayerResult> RunMatch(const MatchSpec &match_spec) {
+	if (std::all_of(match_spec.player_binaries.begin(),
+	                match_spec.player_binaries.end(), IsPlayerLibrary)) {
+		return RunInProcessMatch(match_spec);
+	}
+
+	std::vector<std::string> shm_names(num_players);
+	for (int i = 0; i < num_players; ++i) {
+		shm_names[i] = GenerateRandomString(64) + std::to_string(i);
+	}
+
+	auto driver = BuildMainDriver(shm_names, match_spec.output_path);
 
 	// Launching player child processes
 	std::vector<bp::child> player_processes;
 	std::vector<std::error_code> player_process_errors(num_players);
 	for (int i = 0; i < num_players; ++i) {
-		player_processes.emplace_back("./player_" + std::to_string(i + 1),
-		                              shm_names[i], player_process_errors[i]);
+		if (match_spec.player_debug_logs.empty()) {
+			player_processes.emplace_back(match_spec.player_binaries[i],
+			                              shm_names[i],
+			                              player_process_errors[i]);
+		} else {
+			player_processes.emplace_back(
+			    match_spec.player_binaries[i], shm_names[i],
+			    match_spec.player_debug_logs[i], player_process_errors[i]);
+		}
 	}
 
-	// Starting main driver
-	std::vector<PlayerResult> results;
-	std::thread main_runner([&driver, &results] { results = driver->Start(); });
-
 	// Monitor child processes
 	// If one fails, terminate the rest
 	std::vector<std::atomic_bool> players_failed(num_players);
@@ -213,24 +350,278 @@ int main(int argc, char *argv[]) {
 		});
 	}
 
-	for (auto &monitor : player_monitors) {
-		monitor.join();
+	// If any child process failed, stop the main driver
+	std::thread monitor_runner([&driver, &player_monitors, &any_player_failed] {
+		for (auto &monitor : player_monitors) {
+			monitor.join();
+		}
+		if (any_player_failed) {
+			driver->Cancel();
+		}
+	});
+
+	// Starting main driver
+	auto results = driver->Start();
+
+	monitor_runner.join();
+	for (int player_id = 0; player_id < num_players; ++player_id) {
+		if (players_failed[player_id]) {
+			results[player_id].status = PlayerResult::Status::RUNTIME_ERROR;
+		}
 	}
 
-	// If any child process failed, stop the main driver
-	// Otherwise, simply wait for the main driver to wrap up
-	if (any_player_failed) {
-		driver->Cancel();
-		main_runner.join();
-		for (int player_id = 0; player_id < num_players; ++player_id) {
-			if (players_failed[player_id]) {
-				results[player_id].status = PlayerResult::Status::RUNTIME_ERROR;
+	return results;
+}
+
+/**
+ * Parses a match spec line of the form
+ * "<player_1_binary> <player_2_binary> <seed> <output_path>"
+ *
+ * Player debug logs are written next to the game log
+ *
+ * @param[in]   line        The line to parse
+ * @param[out]  match_spec  The parsed match spec
+ *
+ * @return      true if the line was a valid match spec, false otherwise
+ */
+bool ParseMatchSpec(const std::string &line, MatchSpec &match_spec) {
+	std::istringstream line_stream(line);
+
+	match_spec.player_binaries.resize(num_players);
+	for (auto &player_binary : match_spec.player_binaries) {
+		line_stream >> player_binary;
+	}
+	line_stream >> match_spec.seed >> match_spec.output_path;
+
+	std::string trailing;
+	if (!line_stream || line_stream >> trailing) {
+		return false;
+	}
+
+	match_spec.player_debug_logs.clear();
+	for (int i = 0; i < num_players; ++i) {
+		match_spec.player_debug_logs.push_back(
+		    match_spec.output_path + "_player_" + std::to_string(i + 1) +
+		    PLAYER_DEBUG_LOG_SUFFIX);
+	}
+
+	return true;
+}
+
+/**
+ * Runs match specs read from stdin, one per line, on a pool of num_workers
+ * threads
+ *
+ * Each match gets its own state, logger and shared memory. Results are
+ * written to stdout as each match completes, as
+ * "<prefix_key> <seed> <output_path> <score_1> <status_1> <score_2> <status_2>"
+ */
+void RunMatchServer(const std::string &prefix_key, int num_workers) {
+	std::queue<MatchSpec> pending_matches;
+	bool is_input_done = false;
+	std::mutex pending_matches_mutex;
+	std::condition_variable pending_matches_cv;
+	std::mutex output_mutex;
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < num_workers; ++i) {
+		workers.emplace_back([&] {
+			while (true) {
+				MatchSpec match_spec;
+				{
+					std::unique_lock<std::mutex> lock(pending_matches_mutex);
+					pending_matches_cv.wait(lock, [&] {
+						return is_input_done || !pending_matches.empty();
+					});
+					if (pending_matches.empty()) {
+						return;
+					}
+					match_spec = std::move(pending_matches.front());
+					pending_matches.pop();
+				}
+
+				auto results = RunMatch(match_spec);
+
+				std::lock_guard<std::mutex> lock(output_mutex);
+				std::cout << prefix_key << " " << match_spec.seed << " "
+				          << match_spec.output_path;
+				for (const auto &result : results) {
+					std::cout << " " << result.score << " " << result.status;
+				}
+				std::cout << std::endl;
 			}
+		});
+	}
+
+	std::string line;
+	while (std::getline(std::cin, line)) {
+		MatchSpec match_spec;
+		if (line.empty()) {
+			continue;
 		}
+		if (!ParseMatchSpec(line, match_spec)) {
+			std::lock_guard<std::mutex> lock(output_mutex);
+			std::cerr << "Invalid match spec: " << line << std::endl;
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(pending_matches_mutex);
+		pending_matches.push(std::move(match_spec));
+		pending_matches_cv.notify_one();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pending_matches_mutex);
+		is_input_done = true;
+	}
+	pending_matches_cv.notify_all();
+
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+/**
+ * Replays a game from the commands in its log, checking the state against
+ * the logged state hash every turn
+ *
+ * @param[in]  game_log_file_name  The game log, compressed or not
+ *
+ * @return     true if every turn's state matched the log, false if the log
+ *             could not be read or the replay diverged from it
+ */
+bool ReplayGame(const std::string &game_log_file_name) {
+	std::ifstream log_file(game_log_file_name,
+	                       std::ios::in | std::ios::binary);
+	proto::Game game;
+	CompressedLogReader compressed_log_reader;
+	bool is_read = false;
+	if (compressed_log_reader.Open(log_file)) {
+		is_read = compressed_log_reader.ReadGame(game);
 	} else {
-		main_runner.join();
+		log_file.clear();
+		log_file.seekg(0);
+		is_read = game.ParseFromIstream(&log_file);
+	}
+	if (!is_read) {
+		std::cerr << "Cannot read game log " << game_log_file_name
+		          << std::endl;
+		return false;
+	}
+
+	auto state = BuildState();
+	for (int turn = 0; turn < game.states_size(); ++turn) {
+		auto &game_state = game.states(turn);
+
+		// The first state is logged before any turn is played
+		if (turn > 0) {
+			for (auto &command : game_state.commands()) {
+				auto player_id = static_cast<PlayerId>(command.player_id());
+				auto position = Vector(command.x(), command.y());
+				switch (command.type()) {
+				case proto::MOVE_SOLDIER:
+					state->MoveSoldier(player_id, command.actor_id(),
+					                   position);
+					break;
+				case proto::ATTACK_ACTOR:
+					state->AttackActor(player_id, command.actor_id(),
+					                   command.target_id());
+					break;
+				case proto::BUILD_TOWER:
+					state->BuildTower(player_id, position);
+					break;
+				case proto::UPGRADE_TOWER:
+					state->UpgradeTower(player_id, command.actor_id());
+					break;
+				case proto::SUICIDE_TOWER:
+					state->SuicideTower(player_id, command.actor_id());
+					break;
+				default:
+					break;
+				}
+			}
+			state->Update();
+		}
+
+		auto state_hash = state->GetHash();
+		if (state_hash != game_state.state_hash()) {
+			std::cout << "Replay diverged at turn " << turn << ", state hash "
+			          << state_hash << " instead of "
+			          << game_state.state_hash() << std::endl;
+			return false;
+		}
 	}
 
+	std::cout << "Replay matched all " << game.states_size() << " turns"
+	          << std::endl;
+	return true;
+}
+
+// Arg 1: prefix_key
+// Arg 2: match_server, to run matches read from stdin, in_process, to run a
+//        match with the player code loaded into this process, or replay, to
+//        replay a game log and check it (optional)
+// Arg 3: number of matches to run at once, in match_server mode, the player
+//        code libraries, in in_process mode, or the game log, in replay mode
+//        (optional)
+int main(int argc, char *argv[]) {
+	std::string prefix_key;
+	if (argc < 2) {
+		prefix_key = "codecharacter";
+		std::cerr
+		    << "WARNING: main needs a key to prefix scores with for security,"
+		       "running with default key value now...";
+	} else {
+		prefix_key = std::string(argv[1]);
+	}
+
+	SetGameConstants();
+
+	if (argc >= 3 && std::string(argv[2]) == MATCH_SERVER_MODE) {
+		int num_workers = std::thread::hardware_concurrency();
+		if (argc >= 4) {
+			num_workers = std::atoi(argv[3]);
+		}
+		if (num_workers <= 0) {
+			num_workers = 1;
+		}
+
+		std::cerr << "Starting match server with " << num_workers
+		          << " workers...\n";
+		RunMatchServer(prefix_key, num_workers);
+		return 0;
+	}
+
+	if (argc >= 3 && std::string(argv[2]) == REPLAY_MODE) {
+		std::string game_log_file_name = GAME_LOG_FILE_NAME;
+		if (argc >= 4) {
+			game_log_file_name = std::string(argv[3]);
+		}
+		return ReplayGame(game_log_file_name) ? 0 : EXIT_FAILURE;
+	}
+
+	std::cout << "Starting main...\n";
+	MatchSpec match_spec;
+	if (argc >= 3 && std::string(argv[2]) == IN_PROCESS_MODE) {
+		for (int i = 0; i < num_players; ++i) {
+			if (argc >= 3 + num_players) {
+				match_spec.player_binaries.push_back(argv[3 + i]);
+			} else {
+				match_spec.player_binaries.push_back(
+				    "../lib/libplayer_" + std::to_string(i + 1) + "_code" +
+				    PLAYER_LIBRARY_SUFFIX);
+			}
+		}
+	} else {
+		for (int i = 0; i < num_players; ++i) {
+			match_spec.player_binaries.push_back("./player_" +
+			                                     std::to_string(i + 1));
+		}
+	}
+	match_spec.output_path = GAME_LOG_FILE_NAME;
+
+	auto results = RunMatch(match_spec);
+
 	// Write results to stdout
 	std::cout << prefix_key << " " << results[0].score << " "
 	          << results[0].status << " " << results[1].score << " "
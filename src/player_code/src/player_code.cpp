@@ -29,11 +29,12 @@ State PlayerCode::Update(State state) {
 		    (cur_patrol_index + 1) % base_patrol_positions.size();
 	}
 
-	// Make the first half of the soldiers patrol
+	// Make the first half of the soldiers patrol. Commands are given by
+	// index into state.soldiers and state.towers
 	for (int i = 0; i < NUM_SOLDIERS / 2; ++i) {
 		auto &soldier = state.soldiers[i];
 		if (soldier.hp != 0) // Ensure we don't give orders to dead soldiers
-			soldier.destination = base_patrol_positions[cur_patrol_index];
+			MoveSoldier(state, i, base_patrol_positions[cur_patrol_index]);
 	}
 
 	// Log the current patrol destination
@@ -51,7 +52,7 @@ State PlayerCode::Update(State state) {
 		for (auto enemy_soldier : state.enemy_soldiers) {
 			if (enemy_soldier.hp != 0) { // Ensure your prospective target has
 				                         // not already been slain
-				soldier.soldier_target = enemy_soldier.id;
+				AttackSoldier(state, i, enemy_soldier.id);
 				break;
 			}
 		}
@@ -65,7 +66,7 @@ State PlayerCode::Update(State state) {
 	auto &base_tower = state.towers[0];
 	auto upgrade_cost = TOWER_BUILD_COSTS[base_tower.level - 1];
 	if (base_tower.level < MAX_TOWER_LEVEL && state.money >= upgrade_cost) {
-		base_tower.upgrade_tower = true;
+		UpgradeTower(state, 0);
 		state.money -= upgrade_cost;
 	}
 
@@ -83,7 +84,7 @@ State PlayerCode::Update(State state) {
 		auto &map_elt = state.map[build_pos.x][build_pos.y];
 
 		if (map_elt.valid_territory)
-			state.map[build_pos.x][build_pos.y].build_tower = true;
+			BuildTower(state, build_pos);
 	}
 
     // Return the modified state
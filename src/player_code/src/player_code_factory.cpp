@@ -0,0 +1,8 @@
+#include "player_code/player_code.h"
+
+/**
+ * Creates the player code, for the simulator to run the player in process
+ */
+extern "C" PLAYER_CODE_EXPORT player_wrapper::IPlayerCode *CreatePlayerCode() {
+	return new player_code::PlayerCode();
+}
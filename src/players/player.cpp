@@ -33,6 +33,8 @@ BuildPlayerDriver(std::string shm_name, std::string player_debug_log_file) {
 	    max_debug_logs_turn_length);
 }
 
+// Arg 1: shm_name
+// Arg 2: player_debug_log_file (optional)
 int main(int argc, char *argv[]) {
 	if (argc < 2) {
 		std::cerr << argv[0] << " Requires SHM player name as arg";
@@ -40,9 +42,16 @@ int main(int argc, char *argv[]) {
 	}
 	std::string shm_name(argv[1]);
 
+	// Several matches may run the same player binary at once, so the debug
+	// log path can be passed in
+	std::string player_debug_log_file =
+	    std::string(argv[0]) + player_debug_log_ext;
+	if (argc >= 3) {
+		player_debug_log_file = std::string(argv[2]);
+	}
+
 	std::cout << "Running " << argv[0] << " ..." << std::endl;
-	auto driver = BuildPlayerDriver(
-	    shm_name, std::string(argv[0]) + player_debug_log_ext);
+	auto driver = BuildPlayerDriver(shm_name, player_debug_log_file);
 
 	driver->Start();
 	std::cout << argv[0] << " Done!" << std::endl;
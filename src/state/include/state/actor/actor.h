@@ -24,12 +24,6 @@ class STATE_EXPORT Actor : public IUpdatable {
 	 */
 	ActorId id;
 
-	/**
-	 * Static counter that's used to assign a unique
-	 * incrementing id to all actors
-	 */
-	static ActorId actor_id_increment;
-
 	/**
 	 * ID of the player that the actor belongs to
 	 */
@@ -63,23 +57,6 @@ class STATE_EXPORT Actor : public IUpdatable {
 
 	virtual ~Actor();
 
-	/**
-	 * Gets the next actor id to assign to new actors
-	 *
-	 * @return     The new actor id to assign
-	 */
-	static ActorId GetNextActorId();
-
-	/**
-	 * Sets the auto incrementing actor id,
-	 * Resets it to 0 when no parameter is passed
-	 *
-	 * @param[in]   actor_id ActorId to set
-	 *
-	 * @throw       std::out_of_range If actor_id is negative
-	 */
-	static void SetActorIdIncrement(ActorId actor_id = 0);
-
 	/**
 	 * Get actor id
 	 *
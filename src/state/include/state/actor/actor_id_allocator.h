@@ -0,0 +1,55 @@
+/**
+ * @file actor_id_allocator.h
+ * Declares the ActorIdAllocator class which hands out actor ids for a game
+ */
+
+#ifndef STATE_ACTOR_ACTOR_ID_ALLOCATOR_H
+#define STATE_ACTOR_ACTOR_ID_ALLOCATOR_H
+
+#include "state/state_export.h"
+#include "state/utilities.h"
+
+namespace state {
+
+/**
+ * Assigns unique, incrementing ids to the actors of one game
+ *
+ * Each game owns its own allocator, so any number of games can run in the
+ * same process
+ */
+class STATE_EXPORT ActorIdAllocator {
+  private:
+	/**
+	 * Id to assign to the next actor
+	 */
+	ActorId next_actor_id;
+
+  public:
+	/**
+	 * Constructor for ActorIdAllocator
+	 *
+	 * @param[in]   next_actor_id   First id to hand out
+	 *
+	 * @throw       std::out_of_range If next_actor_id is negative
+	 */
+	ActorIdAllocator(ActorId next_actor_id = 0);
+
+	/**
+	 * Gets the next actor id to assign to new actors
+	 *
+	 * @return     The new actor id to assign
+	 */
+	ActorId GetNextActorId();
+
+	/**
+	 * Sets the id to hand out next
+	 *
+	 * @param[in]   next_actor_id   ActorId to set
+	 *
+	 * @throw       std::out_of_range If next_actor_id is negative
+	 */
+	void SetNextActorId(ActorId next_actor_id);
+};
+}
+
+#endif
@@ -73,10 +73,16 @@ class STATE_EXPORT Soldier : public Actor {
 	 */
 	int64_t damage_incurred;
 
-	/*
-	 * State class that controls logic for soldier's current state
+	/**
+	 * Soldier's current state, which decides what it does every update
+	 */
+	SoldierStateName state;
+
+	/**
+	 * If the soldier is in the DEAD state, contains number of remaining turns
+	 * before it respawns
 	 */
-	std::unique_ptr<SoldierState> state;
+	int64_t remaining_turns_to_respawn;
 
 	/**
 	 * Pointer to PathPlanner instance
@@ -99,6 +105,23 @@ class STATE_EXPORT Soldier : public Actor {
 	 */
 	int64_t num_turns_invulnerable;
 
+	/**
+	 * Runs the code of the current state
+	 *
+	 * @param[out] new_state  State to switch to, if a transition occurs
+	 *
+	 * @return     true if the soldier must switch to new_state, false if the
+	 *             state code was executed instead
+	 */
+	bool UpdateState(SoldierStateName &new_state);
+
+	/**
+	 * Leaves the current state and enters new_state
+	 *
+	 * @param[in]  new_state  State to switch to
+	 */
+	void TransitionTo(SoldierStateName new_state);
+
   public:
 	/**
 	 * Soldier Constructor
@@ -25,23 +25,24 @@ class STATE_EXPORT IState : public IUpdatable {
 	/**
 	 * Get all soldiers, indexed by PlayerId
 	 *
-	 * @return      Vector of all soldiers in state
+	 * @return      Vector of all soldiers in state, valid until the next
+	 *              Update
 	 */
-	virtual const std::vector<std::vector<Soldier *>> GetAllSoldiers() = 0;
+	virtual const std::vector<std::vector<Soldier *>> &GetAllSoldiers() = 0;
 
 	/**
 	 * Get all towers, indexed by PlayerId
 	 *
-	 * @return      Vector of all towers in state
+	 * @return      Vector of all towers in state, valid until the next Update
 	 */
-	virtual const std::vector<std::vector<Tower *>> GetAllTowers() = 0;
+	virtual const std::vector<std::vector<Tower *>> &GetAllTowers() = 0;
 
 	/**
 	 * Get money for both players
 	 *
 	 * @return      Vector of integers with players' money
 	 */
-	virtual std::vector<int64_t> GetMoney() = 0;
+	virtual const std::vector<int64_t> &GetMoney() = 0;
 
 	/**
 	 * Get the map
@@ -50,6 +51,46 @@ class STATE_EXPORT IState : public IUpdatable {
 	 */
 	virtual IMap *GetMap() = 0;
 
+	/**
+	 * Get the offsets of map elements whose ownership changed since the last
+	 * call to ClearDirtyMapOffsets
+	 *
+	 * @return      List of offsets, may contain duplicates
+	 */
+	virtual const std::vector<physics::Vector> &GetDirtyMapOffsets() = 0;
+
+	/**
+	 * Forget about map ownership changes made so far
+	 */
+	virtual void ClearDirtyMapOffsets() = 0;
+
+	/**
+	 * Get the soldiers of a player within a distance of a position, dead
+	 * soldiers included
+	 *
+	 * @param[in]  player_id  player whose soldiers are searched
+	 * @param[in]  position   centre of the search
+	 * @param[in]  range      largest distance from position to accept
+	 * @param[out] soldiers   cleared, then filled with the soldiers found
+	 */
+	virtual void GetSoldiersInRange(PlayerId player_id,
+	                                physics::Vector position, double range,
+	                                std::vector<Soldier *> &soldiers) = 0;
+
+	/**
+	 * Get the soldiers of a player closest to a position, dead soldiers
+	 * included
+	 *
+	 * @param[in]  player_id  player whose soldiers are searched
+	 * @param[in]  position   centre of the search, on the map
+	 * @param[in]  count      number of soldiers to find
+	 * @param[out] soldiers   cleared, then filled with up to count
+	 *                        soldiers, nearest first
+	 */
+	virtual void GetNearestSoldiers(PlayerId player_id,
+	                                physics::Vector position, int64_t count,
+	                                std::vector<Soldier *> &soldiers) = 0;
+
 	/**
 	 * Get game scores of players, indexed by player ID
 	 *
@@ -57,6 +98,17 @@ class STATE_EXPORT IState : public IUpdatable {
 	 */
 	virtual std::vector<int64_t> GetScores() = 0;
 
+	/**
+	 * Get a hash of everything in the state that turns depend on: the
+	 * soldiers, towers, money and map ownership
+	 *
+	 * Two games that played out the same have the same hash every turn, so
+	 * a replay can check that it matches the game it replays
+	 *
+	 * @return      64 bit hash of the state
+	 */
+	virtual uint64_t GetHash() = 0;
+
 	/**
 	 * Handles soldier movement
 	 *
@@ -58,6 +58,16 @@ class STATE_EXPORT MapElement {
 	 */
 	std::vector<bool> GetOwnership();
 
+	/**
+	 * Gets the ownership status of this element for one player, without
+	 * copying the ownership of every player
+	 *
+	 * @param[in]  player_id  ID of player whose ownership is to be checked
+	 *
+	 * @return     true if the player owns this element, false otherwise
+	 */
+	bool GetOwnership(PlayerId player_id);
+
 	/**
 	 * Sets the ownership status of this element
 	 *
@@ -0,0 +1,135 @@
+/**
+ * @file spatial_grid.h
+ * Declaration for an index of soldiers by the map element they stand on
+ */
+
+#ifndef STATE_MAP_SPATIAL_GRID_H
+#define STATE_MAP_SPATIAL_GRID_H
+
+#include "physics/vector.h"
+#include "state/actor/soldier.h"
+#include "state/state_export.h"
+#include <cstdint>
+#include <vector>
+
+namespace state {
+
+/**
+ * Uniform grid of cells, one per map element, each holding the soldiers
+ * standing on that element. Lets proximity queries look at the cells around
+ * a position instead of at every soldier in the game
+ */
+class STATE_EXPORT SpatialGrid {
+  private:
+	/**
+	 * Number of cells along each side of the grid
+	 */
+	int64_t map_size;
+
+	/**
+	 * Size of one cell (width/height), same as that of a map element
+	 */
+	int64_t element_size;
+
+	/**
+	 * Soldiers in each cell, indexed by x * map_size + y
+	 */
+	std::vector<std::vector<Soldier *>> cells;
+
+	/**
+	 * Cell each soldier was last filed under, indexed by ActorId. -1 if the
+	 * soldier is not in the grid
+	 */
+	std::vector<int64_t> soldier_cells;
+
+	/**
+	 * Position of each soldier within its cell, indexed by ActorId
+	 */
+	std::vector<int64_t> soldier_slots;
+
+	/**
+	 * Gets the index of the cell containing a position. Positions off the
+	 * map are clamped to the nearest cell
+	 *
+	 * @param[in]  position  The x, y co-ordinates
+	 *
+	 * @return     Index into cells
+	 */
+	int64_t GetCellIndex(physics::Vector position);
+
+	/**
+	 * Files a soldier under a cell
+	 *
+	 * @param[in]  soldier     Soldier to add
+	 * @param[in]  cell_index  Cell to add the soldier to
+	 */
+	void AddToCell(Soldier *soldier, int64_t cell_index);
+
+	/**
+	 * Removes a soldier from the cell it is filed under. Order within the
+	 * cell is not kept
+	 *
+	 * @param[in]  soldier  Soldier to remove
+	 */
+	void RemoveFromCell(Soldier *soldier);
+
+  public:
+	SpatialGrid();
+
+	SpatialGrid(int64_t map_size, int64_t element_size);
+
+	/**
+	 * Adds a soldier to the cell of its current position
+	 *
+	 * @param[in]  soldier  Soldier to add
+	 *
+	 * @throw      std::out_of_range If the soldier is already in the grid
+	 */
+	void Insert(Soldier *soldier);
+
+	/**
+	 * Removes a soldier from the grid
+	 *
+	 * @param[in]  soldier  Soldier to remove
+	 *
+	 * @throw      std::out_of_range If the soldier is not in the grid
+	 */
+	void Remove(Soldier *soldier);
+
+	/**
+	 * Moves a soldier to the cell of its current position, if it has left
+	 * the cell it was filed under. Call after the soldier moves
+	 *
+	 * @param[in]  soldier  Soldier that may have moved
+	 *
+	 * @throw      std::out_of_range If the soldier is not in the grid
+	 */
+	void UpdateSoldier(Soldier *soldier);
+
+	/**
+	 * Finds the soldiers within a distance of a position, dead soldiers
+	 * included
+	 *
+	 * @param[in]  position  Centre of the search
+	 * @param[in]  range     Largest distance from position to accept
+	 * @param[out] soldiers  Cleared, then filled with the soldiers found, in
+	 *                       no particular order
+	 */
+	void GetSoldiersInRange(physics::Vector position, double range,
+	                        std::vector<Soldier *> &soldiers);
+
+	/**
+	 * Finds the soldiers closest to a position, dead soldiers included.
+	 * Ties in distance are broken by the lower ActorId
+	 *
+	 * @param[in]  position  Centre of the search, on the map
+	 * @param[in]  count     Number of soldiers to find
+	 * @param[out] soldiers  Cleared, then filled with up to count soldiers,
+	 *                       nearest first
+	 */
+	void GetNearestSoldiers(physics::Vector position, int64_t count,
+	                        std::vector<Soldier *> &soldiers);
+};
+}
+
+#endif
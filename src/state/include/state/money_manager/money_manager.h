@@ -101,6 +101,13 @@ class STATE_EXPORT MoneyManager {
 	 */
 	int64_t GetBalance(PlayerId player_id);
 
+	/**
+	 * Get the current balance of every player, indexed by PlayerId
+	 *
+	 * @return     The balances
+	 */
+	const std::vector<int64_t> &GetBalances();
+
 	/**
 	 * Gets the maximum balance.
 	 *
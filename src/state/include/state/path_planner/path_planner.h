@@ -6,44 +6,45 @@
 #ifndef STATE_PATH_PLANNER_PATH_PLANNER_H
 #define STATE_PATH_PLANNER_PATH_PLANNER_H
 
+#include "constants/map.h"
 #include "physics/vector.h"
 #include "state/interfaces/i_path_planner.h"
 #include "state/map/map.h"
+#include "state/path_planner/path_table.h"
 #include "state/state_export.h"
 #include <cstdint>
 #include <list>
-#include <queue>
+#include <string>
 #include <vector>
 
 namespace state {
 
-/**
- * 2D matrix
- */
-template <typename T> using matrix = std::vector<std::vector<T>>;
-
-/**
- * Initializes matrix with elements of the given value and returns it
- * Takes a single size as the parameter
- *
- * @param[in]  init_value  The initialize value
- * @param[in]  size        The size of the matrix
- *
- * @tparam     T           Data type matrix holds
- *
- * @return     The initialized 2D matrix
- */
-template <typename T> matrix<T> init_matrix(T init_value, int64_t size) {
-	std::vector<T> row(size, init_value);
-	matrix<T> a(size, row);
-	return a;
-}
-
 /**
  * PathPlanner class
+ *
+ * Map elements are numbered x * map_size + y. Paths towards a destination
+ * are found with a breadth first search the first time they are asked for,
+ * and kept for the most recently used destinations. Alternatively, paths
+ * between all elements can be loaded from a PathTable file up front
  */
 class STATE_EXPORT PathPlanner : public IPathPlanner {
   private:
+	/**
+	 * Paths from every element towards one destination
+	 */
+	struct PathTree {
+		/**
+		 * Element the paths lead to
+		 */
+		int64_t destination;
+
+		/**
+		 * Next element to take from each element. Elements that cannot reach
+		 * the destination point to element 0
+		 */
+		std::vector<uint16_t> next_nodes;
+	};
+
 	/**
 	 * Reference to the map object
 	 */
@@ -55,37 +56,162 @@ class STATE_EXPORT PathPlanner : public IPathPlanner {
 	int64_t map_size;
 
 	/**
-	 * Adjacency list with node neighbours, obtained from map
+	 * Land neighbours of each element, obtained from map. The neighbours of
+	 * element i are neighbors[neighbor_starts[i]] up to but not including
+	 * neighbors[neighbor_starts[i + 1]]
+	 */
+	std::vector<int64_t> neighbor_starts;
+
+	std::vector<uint16_t> neighbors;
+
+	/**
+	 * Offset of each element, saves dividing out element numbers
+	 */
+	std::vector<physics::Vector> offsets;
+
+	/**
+	 * Next element towards each destination from each element, one row per
+	 * destination, when all paths are at hand. nullptr if paths are found
+	 * as they are needed
+	 */
+	const uint16_t *all_paths;
+
+	/**
+	 * File all_paths is mapped from, if any
 	 */
-	matrix<std::list<physics::Vector>> adjacency_list;
+	PathTable path_table;
 
 	/**
-	 * Final computed paths from all nodes to all nodes
+	 * Holds all_paths when they could not be written to a file
 	 */
-	matrix<matrix<physics::Vector>> paths;
+	std::vector<uint16_t> all_paths_copy;
 
 	/**
-	 * Add a connection between the two vertices
+	 * Cached paths, most recently used first
 	 */
-	void AddEdge(physics::Vector a, physics::Vector b);
+	std::list<PathTree> path_trees;
 
 	/**
-	 * Returns a list of adjacent elements to an element on the map
-	 * Helper function used to build the adjacency list from the map
+	 * Entry of path_trees for each destination element, path_trees.end() if
+	 * paths to it are not cached
 	 */
-	std::list<physics::Vector> FindNeighbors(physics::Vector elem, Map *map);
+	std::vector<std::list<PathTree>::iterator> cached_path_trees;
 
 	/**
-	 * Given a node, find the shortest path to it from all other nodes
+	 * Largest number of destinations to keep paths towards
+	 */
+	int64_t max_cached_path_trees;
+
+	/**
+	 * Scratch space for the breadth first search
+	 */
+	std::vector<uint16_t> search_queue;
+
+	std::vector<bool> visited;
+
+	/**
+	 * Given a destination, find the shortest path to it from all other nodes
 	 * Implements Breadth First Search
+	 *
+	 * @param[in]   destination   Element to find paths towards
+	 * @param[out]  next_nodes    Next element to take from each element
+	 * @param       search_queue  Scratch space for the search
+	 * @param       visited       Scratch space for the search
 	 */
-	matrix<physics::Vector> ComputeAllPathsFromNode(physics::Vector node);
+	void ComputeAllPathsToNode(int64_t destination, uint16_t *next_nodes,
+	                           std::vector<uint16_t> &search_queue,
+	                           std::vector<bool> &visited);
+
+	/**
+	 * Finds the paths towards several destinations, splitting them across
+	 * threads that each write only to their own destinations' rows
+	 *
+	 * @param[in]   destinations  Elements to find paths towards
+	 * @param[in]   next_nodes    Row to write for each destination
+	 * @param[in]   num_threads   Number of threads to search on, including
+	 *                            the calling one
+	 */
+	void ComputeAllPathsToNodes(const std::vector<int64_t> &destinations,
+	                            const std::vector<uint16_t *> &next_nodes,
+	                            int64_t num_threads);
+
+	/**
+	 * Makes a cache entry for a destination that is not cached, evicting
+	 * the least recently used destination if the cache is full. The paths
+	 * in the entry are left to be found
+	 *
+	 * @param[in]   destination  Element the paths lead to
+	 *
+	 * @return      The new entry, now most recently used
+	 */
+	PathTree &AddPathTree(int64_t destination);
+
+	/**
+	 * Returns the paths towards a destination, finding them if they are not
+	 * cached and marking them most recently used
+	 *
+	 * @param[in]   destination  Element the paths lead to
+	 *
+	 * @return      Next element to take from each element
+	 */
+	const std::vector<uint16_t> &GetPathTree(int64_t destination);
+
+	/**
+	 * Checks that paths can be found towards a node
+	 *
+	 * @param[in]   node  The node to check
+	 *
+	 * @throw       std::out_of_range If node is out of bounds or has an
+	 *                                invalid terrain type
+	 */
+	void CheckDestination(const physics::Vector &node);
 
   public:
 	/**
 	 * Constructor for PathPlanner class
+	 *
+	 * @param[in]  map                    Map to plan paths on
+	 * @param[in]  max_cached_path_trees  Number of destinations to keep paths
+	 *                                    towards
+	 *
+	 * @throw      std::out_of_range If the map has more elements than an
+	 *                               element index can hold, or nothing is
+	 *                               to be cached
+	 */
+	PathPlanner(Map *map,
+	            int64_t max_cached_path_trees = PATH_PLANNER_CACHE_SIZE);
+
+	/**
+	 * Constructor for a PathPlanner with every path at hand, read from a
+	 * PathTable file. If the file is missing or was made for another map,
+	 * the paths are found and the file is written for the next planner
+	 *
+	 * @param[in]  map              Map to plan paths on
+	 * @param[in]  path_table_path  Path of the PathTable file
+	 * @param[in]  num_threads      Number of threads to find paths on when
+	 *                              the file has to be written
+	 *
+	 * @throw      std::out_of_range If the map has more elements than an
+	 *                               element index can hold
+	 */
+	PathPlanner(Map *map, const std::string &path_table_path,
+	            int64_t num_threads);
+
+	/**
+	 * Finds the paths towards several destinations up front, splitting the
+	 * searches across threads, so that the first moves towards them are as
+	 * cheap as later ones. Destinations already cached are skipped, and
+	 * only as many as the cache holds are found
+	 *
+	 * @param[in]  destinations  Nodes to find paths towards
+	 * @param[in]  num_threads   Number of threads to search on, including
+	 *                           the calling one
+	 *
+	 * @throw      std::out_of_range If a destination is out of bounds or
+	 *                               has an invalid terrain type
 	 */
-	PathPlanner(Map *map);
+	void PrecomputePaths(const std::vector<physics::Vector> &destinations,
+	                     int64_t num_threads);
 
 	/**
 	 * Given a source node and a destination node, return the next node
@@ -0,0 +1,126 @@
+/**
+ * @file path_table.h
+ * Declares a file of precomputed paths between every pair of map elements
+ */
+
+#ifndef STATE_PATH_PLANNER_PATH_TABLE_H
+#define STATE_PATH_PLANNER_PATH_TABLE_H
+
+#include "state/map/map.h"
+#include "state/state_export.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace state {
+
+/**
+ * Read only view of a path table file, mapped into memory so that every
+ * process using the same file shares one copy of it
+ *
+ * A file holds a Header followed by one row per destination element. Row d
+ * holds, for each source element, the element that comes next on the way to
+ * d, as a uint16_t. Elements are numbered x * map_size + y
+ */
+class STATE_EXPORT PathTable {
+  private:
+	/**
+	 * Header at the start of a path table file
+	 */
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t element_index_size;
+		uint64_t map_size;
+		uint64_t terrain_hash;
+	};
+
+	/**
+	 * Version of the file layout, bump when it changes
+	 */
+	static const uint32_t version = 1;
+
+	/**
+	 * Start of the mapped file, nullptr if nothing is mapped
+	 */
+	void *mapping;
+
+	/**
+	 * Length of the mapped file in bytes
+	 */
+	size_t mapping_size;
+
+	/**
+	 * Number of elements on the map the table is for
+	 */
+	int64_t num_elements;
+
+	/**
+	 * Fills in a header for a map
+	 */
+	static Header MakeHeader(Map *map);
+
+	/**
+	 * Unmaps the file, if one is mapped
+	 */
+	void Close();
+
+  public:
+	PathTable();
+
+	~PathTable();
+
+	PathTable &operator=(const PathTable &other) = delete;
+	PathTable(const PathTable &other) = delete;
+
+	/**
+	 * Hashes the size and terrain of a map. Maps with the same hash have the
+	 * same paths
+	 *
+	 * @param[in]  map  The map to hash
+	 *
+	 * @return     64-bit FNV-1a hash
+	 */
+	static uint64_t HashTerrain(Map *map);
+
+	/**
+	 * Maps a path table file into memory, if it was written for this
+	 * version of the layout and for a map with the same terrain. Every
+	 * entry is checked to be an element of the map
+	 *
+	 * @param[in]  path  Path of the file
+	 * @param[in]  map   Map the paths are wanted for
+	 *
+	 * @return     True if the file was mapped. False if it is missing,
+	 *             unreadable or does not match, which calls for a rebuild
+	 */
+	bool Open(const std::string &path, Map *map);
+
+	/**
+	 * Writes a path table file. The file is written under a temporary name
+	 * and renamed into place, so readers see either the old file or the
+	 * whole new one
+	 *
+	 * @param[in]  path        Path of the file
+	 * @param[in]  map         Map the paths are for
+	 * @param[in]  next_nodes  Rows of next elements, one per destination
+	 *
+	 * @return     True if the file was written
+	 */
+	static bool Write(const std::string &path, Map *map,
+	                  const std::vector<uint16_t> &next_nodes);
+
+	/**
+	 * Gets the row of next elements towards a destination
+	 *
+	 * @param[in]  destination  Element number of the destination
+	 *
+	 * @return     Next element to take from each element, valid while the
+	 *             table stays open
+	 */
+	const uint16_t *GetNextNodes(int64_t destination);
+};
+}
+
+#endif
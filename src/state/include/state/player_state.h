@@ -8,8 +8,12 @@
 
 #include "constants/constants.h"
 #include "physics/vector.h"
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
 #include <ostream>
+#include <vector>
 
 namespace player_state {
 
@@ -52,6 +56,8 @@ inline std::ostream &operator<<(std::ostream &os, SoldierState soldier_state) {
 
 // The members of each struct marked 'Writable' can be written to
 // by the player. They carry information about the player's current move
+// Commands can instead be issued with MoveSoldier, BuildTower and the other
+// functions after State, which saves the simulator scanning the writables
 
 /**
  * Struct holding information about each map grid element
@@ -95,6 +101,196 @@ struct Tower {
 	bool suicide;
 };
 
+/**
+ * Define a name for each command a player can issue
+ */
+enum class CommandType {
+	// Soldier moving to a position
+	MOVE_SOLDIER,
+	// Soldier attacking an enemy soldier
+	ATTACK_SOLDIER,
+	// Soldier attacking an enemy tower
+	ATTACK_TOWER,
+	// Building a tower at a map offset
+	BUILD_TOWER,
+	// Upgrading a tower
+	UPGRADE_TOWER,
+	// Destroying one's own tower
+	SUICIDE_TOWER
+};
+
+/**
+ * Struct holding a command issued by the player
+ */
+struct Command {
+	CommandType type;
+
+	// Index in soldiers or towers of the actor the command is for, -1 for
+	// BUILD_TOWER
+	int64_t actor_index;
+
+	// Id of the enemy soldier or tower to attack, -1 if none
+	int64_t target_id;
+
+	// Destination for MOVE_SOLDIER, map offset for BUILD_TOWER
+	physics::Vector position;
+};
+
+/**
+ * Commands the player issued this turn, in the order they were issued
+ *
+ * Commands are appended with the functions below, and the buffer is cleared
+ * when the next turn's state is written. If no commands were issued, the
+ * writables are read instead
+ */
+struct CommandBuffer {
+	std::array<Command, MAX_NUM_COMMANDS> commands;
+
+	// Number of commands in use in commands
+	int64_t num_commands;
+
+	// true if commands were issued while the buffer was full
+	bool has_dropped_commands;
+};
+
+/**
+ * Index of a list of soldiers by the map element they stand on
+ *
+ * The soldiers on the element at offset (x, y) are at soldier_indices
+ * cell_starts[c] up to but not including cell_starts[c + 1], where
+ * c = x * MAP_SIZE + y. Each index points into the list of soldiers the grid
+ * was built from. Use GetSoldiersInRange and GetNearestSoldiers to query it
+ */
+struct SoldierGrid {
+	std::array<int64_t, MAP_SIZE * MAP_SIZE + 1> cell_starts;
+	std::array<int64_t, NUM_SOLDIERS> soldier_indices;
+};
+
+/**
+ * Gets the index of the SoldierGrid cell containing a position. Positions
+ * off the map are clamped to the nearest cell
+ */
+inline int64_t GetSoldierGridCell(physics::Vector position) {
+	int64_t x = std::floor(position.x / MAP_ELEMENT_SIZE);
+	int64_t y = std::floor(position.y / MAP_ELEMENT_SIZE);
+	x = std::min(std::max(x, (int64_t)0), (int64_t)MAP_SIZE - 1);
+	y = std::min(std::max(y, (int64_t)0), (int64_t)MAP_SIZE - 1);
+
+	return x * MAP_SIZE + y;
+}
+
+/**
+ * Finds the soldiers within a distance of a position, dead soldiers included
+ *
+ * @param[in]  soldiers  List of soldiers, soldiers or enemy_soldiers
+ * @param[in]  grid      Index of that list, soldier_grid or
+ *                       enemy_soldier_grid
+ * @param[in]  position  Centre of the search
+ * @param[in]  range     Largest distance from position to accept
+ *
+ * @return     Indices into soldiers of the soldiers found
+ */
+inline std::vector<int64_t>
+GetSoldiersInRange(const std::array<Soldier, NUM_SOLDIERS> &soldiers,
+                   const SoldierGrid &grid, physics::Vector position,
+                   double range) {
+	std::vector<int64_t> result;
+	if (range < 0) {
+		return result;
+	}
+
+	auto lower = GetSoldierGridCell(position - range);
+	auto upper = GetSoldierGridCell(position + range);
+	for (int64_t x = lower / MAP_SIZE; x <= upper / MAP_SIZE; ++x) {
+		for (int64_t y = lower % MAP_SIZE; y <= upper % MAP_SIZE; ++y) {
+			auto cell = x * MAP_SIZE + y;
+			for (auto i = grid.cell_starts[cell];
+			     i < grid.cell_starts[cell + 1]; ++i) {
+				auto index = grid.soldier_indices[i];
+				if (position.distance(soldiers[index].position) <= range) {
+					result.push_back(index);
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Finds the soldiers closest to a position, dead soldiers included. Ties in
+ * distance are broken by the lower index
+ *
+ * @param[in]  soldiers  List of soldiers, soldiers or enemy_soldiers
+ * @param[in]  grid      Index of that list, soldier_grid or
+ *                       enemy_soldier_grid
+ * @param[in]  position  Centre of the search, on the map
+ * @param[in]  count     Number of soldiers to find
+ *
+ * @return     Indices into soldiers of up to count soldiers, nearest first
+ */
+inline std::vector<int64_t>
+GetNearestSoldiers(const std::array<Soldier, NUM_SOLDIERS> &soldiers,
+                   const SoldierGrid &grid, physics::Vector position,
+                   int64_t count) {
+	std::vector<int64_t> result;
+	if (count <= 0) {
+		return result;
+	}
+
+	auto is_nearer = [&](int64_t a, int64_t b) {
+		auto distance_a = position.distance(soldiers[a].position);
+		auto distance_b = position.distance(soldiers[b].position);
+		if (distance_a != distance_b) {
+			return distance_a < distance_b;
+		}
+		return a < b;
+	};
+
+	auto centre = GetSoldierGridCell(position);
+	int64_t centre_x = centre / MAP_SIZE;
+	int64_t centre_y = centre % MAP_SIZE;
+
+	// Every soldier beyond ring r of cells around the centre is at least r
+	// elements away, so stop once count soldiers are at least that close
+	for (int64_t r = 0; r < MAP_SIZE; ++r) {
+		for (int64_t x = centre_x - r; x <= centre_x + r; ++x) {
+			if (x < 0 || x >= MAP_SIZE) {
+				continue;
+			}
+			bool is_edge_column = (x == centre_x - r || x == centre_x + r);
+			int64_t y_step = is_edge_column ? 1 : std::max(2 * r, (int64_t)1);
+			for (int64_t y = centre_y - r; y <= centre_y + r; y += y_step) {
+				if (y < 0 || y >= MAP_SIZE) {
+					continue;
+				}
+				auto cell = x * MAP_SIZE + y;
+				result.insert(result.end(),
+				              grid.soldier_indices.begin() +
+				                  grid.cell_starts[cell],
+				              grid.soldier_indices.begin() +
+				                  grid.cell_starts[cell + 1]);
+			}
+		}
+
+		if (result.size() >= static_cast<size_t>(count)) {
+			std::nth_element(result.begin(), result.begin() + count - 1,
+			                 result.end(), is_nearer);
+			auto farthest = soldiers[result[count - 1]].position;
+			if (position.distance(farthest) <= r * MAP_ELEMENT_SIZE) {
+				break;
+			}
+		}
+	}
+
+	auto num_found = std::min(count, (int64_t)result.size());
+	std::partial_sort(result.begin(), result.begin() + num_found,
+	                  result.end(), is_nearer);
+	result.resize(num_found);
+
+	return result;
+}
+
 /**
  * Player's copy of state
  */
@@ -108,6 +304,12 @@ struct State {
 	// List of enemy soldiers
 	std::array<Soldier, NUM_SOLDIERS> enemy_soldiers;
 
+	// Player soldiers by map element
+	SoldierGrid soldier_grid;
+
+	// Enemy soldiers by map element
+	SoldierGrid enemy_soldier_grid;
+
 	// List of player towers
 	std::array<Tower, MAX_NUM_TOWERS> towers;
 
@@ -122,7 +324,115 @@ struct State {
 
 	// Money
 	int64_t money;
+
+	// Commands issued this turn
+	CommandBuffer command_buffer;
 };
+
+/**
+ * Appends a command to the state's command buffer
+ *
+ * @param[inout]  state    Player state to issue the command in
+ * @param[in]     command  The command
+ *
+ * @return        false if the buffer is full and the command was dropped
+ */
+inline bool IssueCommand(State &state, const Command &command) {
+	auto &buffer = state.command_buffer;
+	if (buffer.num_commands < 0 || buffer.num_commands >= MAX_NUM_COMMANDS) {
+		buffer.has_dropped_commands = true;
+		return false;
+	}
+
+	buffer.commands[buffer.num_commands++] = command;
+	return true;
+}
+
+/**
+ * Orders a soldier to move to a position
+ *
+ * @param[inout]  state          Player state to issue the command in
+ * @param[in]     soldier_index  Index of the soldier in soldiers
+ * @param[in]     destination    Position to move to
+ *
+ * @return        false if the command buffer is full
+ */
+inline bool MoveSoldier(State &state, int64_t soldier_index,
+                        physics::Vector destination) {
+	return IssueCommand(state, Command{CommandType::MOVE_SOLDIER,
+	                                   soldier_index, -1, destination});
+}
+
+/**
+ * Orders a soldier to attack an enemy soldier
+ *
+ * @param[inout]  state             Player state to issue the command in
+ * @param[in]     soldier_index     Index of the soldier in soldiers
+ * @param[in]     enemy_soldier_id  Id of the soldier to attack
+ *
+ * @return        false if the command buffer is full
+ */
+inline bool AttackSoldier(State &state, int64_t soldier_index,
+                          int64_t enemy_soldier_id) {
+	return IssueCommand(state,
+	                    Command{CommandType::ATTACK_SOLDIER, soldier_index,
+	                            enemy_soldier_id, physics::Vector(-1, -1)});
+}
+
+/**
+ * Orders a soldier to attack an enemy tower
+ *
+ * @param[inout]  state           Player state to issue the command in
+ * @param[in]     soldier_index   Index of the soldier in soldiers
+ * @param[in]     enemy_tower_id  Id of the tower to attack
+ *
+ * @return        false if the command buffer is full
+ */
+inline bool AttackTower(State &state, int64_t soldier_index,
+                        int64_t enemy_tower_id) {
+	return IssueCommand(state,
+	                    Command{CommandType::ATTACK_TOWER, soldier_index,
+	                            enemy_tower_id, physics::Vector(-1, -1)});
+}
+
+/**
+ * Builds a tower on a map element
+ *
+ * @param[inout]  state   Player state to issue the command in
+ * @param[in]     offset  Offset of the element in map
+ *
+ * @return        false if the command buffer is full
+ */
+inline bool BuildTower(State &state, physics::Vector offset) {
+	return IssueCommand(state,
+	                    Command{CommandType::BUILD_TOWER, -1, -1, offset});
+}
+
+/**
+ * Upgrades a tower to the next level
+ *
+ * @param[inout]  state        Player state to issue the command in
+ * @param[in]     tower_index  Index of the tower in towers
+ *
+ * @return        false if the command buffer is full
+ */
+inline bool UpgradeTower(State &state, int64_t tower_index) {
+	return IssueCommand(state, Command{CommandType::UPGRADE_TOWER, tower_index,
+	                                   -1, physics::Vector(-1, -1)});
+}
+
+/**
+ * Destroys one of the player's own towers
+ *
+ * @param[inout]  state        Player state to issue the command in
+ * @param[in]     tower_index  Index of the tower in towers
+ *
+ * @return        false if the command buffer is full
+ */
+inline bool SuicideTower(State &state, int64_t tower_index) {
+	return IssueCommand(state, Command{CommandType::SUICIDE_TOWER, tower_index,
+	                                   -1, physics::Vector(-1, -1)});
+}
 }
 
 #endif
@@ -0,0 +1,186 @@
+/**
+ * @file profiler.h
+ * Declares the profiler that times the phases of each turn
+ */
+
+#ifndef STATE_PROFILER_PROFILER_H
+#define STATE_PROFILER_PROFILER_H
+
+#include "state/state_export.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace state {
+
+/**
+ * Parts of a turn that are timed
+ */
+enum class ProfilePhase {
+	// Everything the main driver does in a turn, waits included
+	TURN,
+	// Waiting for the first player to finish its turn
+	WAIT_FOR_PLAYER1,
+	// Waiting for the second player to finish its turn
+	WAIT_FOR_PLAYER2,
+	// Validating and running the players' commands
+	EXECUTE_PLAYER_COMMANDS,
+	// Updating the tower managers
+	UPDATE_TOWER_MANAGERS,
+	// Updating the soldiers
+	UPDATE_SOLDIERS,
+	// Late updating the soldiers and refiling them in the soldier grids
+	LATE_UPDATE_SOLDIERS,
+	// Copying the main state into the player states, without logging
+	UPDATE_PLAYER_STATES,
+	// Logging the main state
+	LOG_STATE,
+	// Number of phases, not a phase
+	PHASE_COUNT
+};
+
+/**
+ * Names of the phases, as written to profiles
+ */
+const std::vector<std::string> ProfilePhaseName = {
+    "turn",
+    "wait_for_player1",
+    "wait_for_player2",
+    "execute_player_commands",
+    "update_tower_managers",
+    "update_soldiers",
+    "late_update_soldiers",
+    "update_player_states",
+    "log_state"};
+
+/**
+ * Collects the time taken by each phase of a game's turns into histograms
+ *
+ * The phases are timed by PhaseTimers, which record into the profiler active
+ * on their thread. The timers are placed with the PROFILE_ macros, which are
+ * compiled out unless PROFILE_TURNS is defined
+ */
+class STATE_EXPORT Profiler {
+  public:
+	/**
+	 * Number of histogram buckets. Bucket i counts durations below 2^i ns,
+	 * and at least 2^(i-1) ns
+	 */
+	static const int num_buckets = 64;
+
+	/**
+	 * Durations recorded for one phase
+	 */
+	struct PhaseStats {
+		int64_t count;
+		int64_t total_ns;
+		int64_t min_ns;
+		int64_t max_ns;
+		std::array<int64_t, num_buckets> buckets;
+	};
+
+  private:
+	std::array<PhaseStats, static_cast<int>(ProfilePhase::PHASE_COUNT)>
+	    phase_stats;
+
+  public:
+	Profiler();
+
+	/**
+	 * Records one run of a phase
+	 *
+	 * @param[in]  phase        The phase
+	 * @param[in]  duration_ns  Time it took, in nanoseconds
+	 */
+	void Record(ProfilePhase phase, int64_t duration_ns);
+
+	/**
+	 * Returns the durations recorded for a phase
+	 */
+	const PhaseStats &GetPhaseStats(ProfilePhase phase) const;
+
+	/**
+	 * Returns an upper bound on a quantile of a phase's durations, from its
+	 * histogram
+	 *
+	 * @param[in]  phase     The phase
+	 * @param[in]  quantile  Quantile between 0 and 1
+	 *
+	 * @return     Upper bound in nanoseconds, 0 if nothing was recorded
+	 */
+	int64_t GetQuantile(ProfilePhase phase, double quantile) const;
+
+	/**
+	 * Writes the stats and non empty histogram buckets of every phase as JSON
+	 *
+	 * @param[in]  write_stream  Stream to write to
+	 */
+	void WriteJson(std::ostream &write_stream) const;
+
+	/**
+	 * Makes a profiler record the phases timed on the calling thread
+	 *
+	 * @param[in]  profiler  The profiler, nullptr to stop recording
+	 */
+	static void SetActive(Profiler *profiler);
+
+	/**
+	 * Returns the profiler active on the calling thread, nullptr if none
+	 */
+	static Profiler *GetActive();
+};
+
+/**
+ * Times a phase from its construction until it is stopped or destroyed, and
+ * records it in the profiler active on the thread
+ */
+class STATE_EXPORT PhaseTimer {
+  private:
+	ProfilePhase phase;
+
+	/**
+	 * Profiler to record into, nullptr once stopped or if none was active
+	 */
+	Profiler *profiler;
+
+	std::chrono::steady_clock::time_point start;
+
+  public:
+	explicit PhaseTimer(ProfilePhase phase);
+
+	~PhaseTimer();
+
+	PhaseTimer(const PhaseTimer &) = delete;
+	PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+	/**
+	 * Records the phase now, instead of when the timer is destroyed
+	 */
+	void Stop();
+};
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PROFILE_TURNS
+/**
+ * Times the rest of the enclosing scope as a phase
+ */
+#define PROFILE_SCOPE(phase)                                                   \
+	::state::PhaseTimer PROFILE_CONCAT(profile_timer_, __LINE__)(phase)
+/**
+ * Starts timing a phase with a named timer, which PROFILE_STOP stops
+ */
+#define PROFILE_START(timer, phase) ::state::PhaseTimer timer(phase)
+#define PROFILE_STOP(timer) timer.Stop()
+#else
+#define PROFILE_SCOPE(phase)
+#define PROFILE_START(timer, phase)
+#define PROFILE_STOP(timer)
+#endif
+
+#endif
@@ -7,12 +7,14 @@
 #define STATE_STATE_H
 
 #include "physics/vector.h"
+#include "state/actor/actor_id_allocator.h"
 #include "state/actor/soldier.h"
 #include "state/actor/tower.h"
 #include "state/interfaces/i_path_planner.h"
 #include "state/interfaces/i_state.h"
 #include "state/map/interfaces/i_map.h"
 #include "state/map/map_element.h"
+#include "state/map/spatial_grid.h"
 #include "state/money_manager/money_manager.h"
 #include "state/state_export.h"
 #include "state/tower_manager/tower_manager.h"
@@ -51,6 +53,34 @@ class STATE_EXPORT State : public IState {
 	 */
 	std::unique_ptr<IPathPlanner> path_planner;
 
+	/**
+	 * Hands out ids to the actors of this game
+	 */
+	std::unique_ptr<ActorIdAllocator> actor_id_allocator;
+
+	/**
+	 * Offsets of map elements whose ownership changed since the last call to
+	 * ClearDirtyMapOffsets, collected from the tower managers every update
+	 */
+	std::vector<physics::Vector> dirty_map_offsets;
+
+	/**
+	 * Pointers to the soldiers in soldiers, indexed by PlayerId
+	 */
+	std::vector<std::vector<Soldier *>> soldier_ptrs;
+
+	/**
+	 * Pointers to the towers of every tower manager, indexed by PlayerId.
+	 * Refreshed after the tower managers update
+	 */
+	std::vector<std::vector<Tower *>> tower_ptrs;
+
+	/**
+	 * Index of each player's soldiers by map element, indexed by PlayerId.
+	 * Kept up to date with soldier positions at the end of every update
+	 */
+	std::vector<SpatialGrid> soldier_grids;
+
 	/**
 	 * Helper function returns a pointer to a soldier
 	 * PlayerId helps identify the right soldier vector faster
@@ -71,7 +101,8 @@ class STATE_EXPORT State : public IState {
 	      std::unique_ptr<IMap> map,
 	      std::unique_ptr<MoneyManager> money_manager,
 	      std::vector<std::unique_ptr<TowerManager>> tower_managers,
-	      std::unique_ptr<IPathPlanner> path_planner);
+	      std::unique_ptr<IPathPlanner> path_planner,
+	      std::unique_ptr<ActorIdAllocator> actor_id_allocator);
 
 	State();
 
@@ -84,28 +115,57 @@ class STATE_EXPORT State : public IState {
 	/**
 	 * @see IIState#GetAllSoldiers
 	 */
-	const std::vector<std::vector<Soldier *>> GetAllSoldiers() override;
+	const std::vector<std::vector<Soldier *>> &GetAllSoldiers() override;
 
 	/**
 	 * @see IState#GetAllTowers
 	 */
-	const std::vector<std::vector<Tower *>> GetAllTowers() override;
+	const std::vector<std::vector<Tower *>> &GetAllTowers() override;
 
 	/**
 	 * @see IState#GetMoney
 	 */
-	std::vector<int64_t> GetMoney() override;
+	const std::vector<int64_t> &GetMoney() override;
 
 	/**
 	 * @see IState#GetMap
 	 */
 	IMap *GetMap() override;
 
+	/**
+	 * @see IState#GetDirtyMapOffsets
+	 */
+	const std::vector<physics::Vector> &GetDirtyMapOffsets() override;
+
+	/**
+	 * @see IState#ClearDirtyMapOffsets
+	 */
+	void ClearDirtyMapOffsets() override;
+
+	/**
+	 * @see IState#GetSoldiersInRange
+	 */
+	void GetSoldiersInRange(PlayerId player_id, physics::Vector position,
+	                        double range,
+	                        std::vector<Soldier *> &soldiers) override;
+
+	/**
+	 * @see IState#GetNearestSoldiers
+	 */
+	void GetNearestSoldiers(PlayerId player_id, physics::Vector position,
+	                        int64_t count,
+	                        std::vector<Soldier *> &soldiers) override;
+
 	/**
 	 * @see IState#GetScores
 	 */
 	std::vector<int64_t> GetScores() override;
 
+	/**
+	 * @see IState#GetHash
+	 */
+	uint64_t GetHash() override;
+
 	/**
 	 * @see IState#MoveSoldier
 	 */
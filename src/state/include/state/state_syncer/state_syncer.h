@@ -45,6 +45,107 @@ class STATE_EXPORT StateSyncer : public IStateSyncer {
 	 */
 	int64_t max_num_towers;
 
+	/**
+	 * Player state copies as of the last sync, indexed by PlayerId. A copy
+	 * that was synced last time only has the map elements that could have
+	 * changed written, any other copy has its map written in full
+	 */
+	std::vector<player_state::State *> synced_player_states;
+
+	/**
+	 * Offsets of each player's towers as of the last sync, indexed by PlayerId
+	 */
+	std::vector<std::vector<physics::Vector>> tower_offsets;
+
+	/**
+	 * Scratch list holding a player's tower offsets from the sync before
+	 */
+	std::vector<physics::Vector> old_tower_offsets;
+
+	/**
+	 * Money each player has left to spend while their commands are executed
+	 */
+	std::vector<int64_t> player_money;
+
+	/**
+	 * Towers razed during the turn whose commands are being executed
+	 */
+	std::vector<int64_t> razed_towers;
+
+	/**
+	 * Commands of each player being executed, indexed by PlayerId
+	 */
+	std::vector<std::vector<player_state::Command>> player_commands;
+
+	/**
+	 * Number of commands each soldier and tower was given, indexed by
+	 * PlayerId and then by the actor's index. -1 once an actor given more
+	 * than one command has been reported. All 0 between turns
+	 */
+	std::vector<std::vector<int64_t>> soldier_command_counts;
+	std::vector<std::vector<int64_t>> tower_command_counts;
+
+	/**
+	 * Offsets of the map elements whose build_tower writable each player may
+	 * have set when their commands were read, indexed by PlayerId. Only these
+	 * are reset when the player's state is next updated
+	 */
+	std::vector<std::vector<physics::Vector>> build_tower_offsets;
+
+	/**
+	 * Offsets each player has had a tower built at by the commands being
+	 * executed, indexed by PlayerId. The towers are only added to the state
+	 * when it is updated, so they aren't among the player's towers yet
+	 */
+	std::vector<std::vector<physics::Vector>> queued_tower_offsets;
+
+	/**
+	 * Scratch count of soldiers in each map element while a soldier grid is
+	 * built. All 0 between builds
+	 */
+	std::vector<int64_t> soldier_cell_counts;
+
+	/**
+	 * Finds the map elements whose build_tower writable the player set, by
+	 * searching the map if it issued no commands. A player that did has its
+	 * writables ignored, so the elements its build commands name are taken
+	 * instead, keeping the map out of the cost of its turn
+	 *
+	 * @param[in]   player_state  the player's state
+	 * @param[out]  offsets       list to write the offsets to, in row order
+	 *                            if the map was searched
+	 */
+	void FindBuildTowerOffsets(const player_state::State &player_state,
+	                           std::vector<physics::Vector> &offsets);
+
+	/**
+	 * Reads the commands a player issued, from its command buffer or, if it
+	 * issued none, from its writables
+	 *
+	 * Commands for actors the player doesn't have are logged and dropped, and
+	 * each actor's commands are counted
+	 *
+	 * @param[in]   player_id     player whose commands are read
+	 * @param[in]   player_state  the player's state
+	 * @param[out]  commands      list to write the commands to
+	 */
+	void ReadPlayerCommands(PlayerId player_id,
+	                        const player_state::State &player_state,
+	                        std::vector<player_state::Command> &commands);
+
+	/**
+	 * Appends the commands the player set in its writables, in the order the
+	 * writables were read in before the command buffer. Build commands come
+	 * from the player's build_tower_offsets
+	 *
+	 * @param[in]   player_id     player whose commands are read
+	 * @param[in]   player_state  the player's state
+	 * @param[out]  commands      list to append the commands to
+	 */
+	void AppendWritableCommands(PlayerId player_id,
+	                            const player_state::State &player_state,
+	                            std::vector<player_state::Command> &commands);
+
 	// The functions below call corresponding action functions in State
 
 	/**
@@ -127,15 +228,16 @@ class STATE_EXPORT StateSyncer : public IStateSyncer {
 	                  std::vector<int64_t> &razed_towers);
 
 	/**
-	 * Changes orientation of map such that there is a
-	 * commom point of origin for all player states for all
-	 * map related activities
-	 *
-	 * @param[in]	player_map		map to be inverted
+	 * Writes a single map element of the main state to a player's map,
+	 * flipping it for the second player so that all player states share a
+	 * common point of origin. Also resets the element's writables
 	 *
+	 * @param[in]	player_id     player whose map is written to
+	 * @param[in]	offset        offset of the element in the main state
+	 * @param[out]	player_state  state to write to
 	 */
-	void
-	FlipMap(std::vector<std::vector<player_state::MapElement>> &player_map);
+	void UpdatePlayerMapElement(int64_t player_id, physics::Vector offset,
+	                            player_state::State *player_state);
 
 	/**
 	 * Returns flipped position
@@ -150,36 +252,57 @@ class STATE_EXPORT StateSyncer : public IStateSyncer {
 	 *
 	 * @param[in]	player_id  	  player identifier
 	 * @param[in]	error_type 	  error type
-	 * @param[in]	message	      error message
+	 * @param[in]	actor_id      actor that made the error, -1 if none
+	 * @param[in]	arg           actor the error concerns, -1 if none
 	 *
 	 */
 	void LogErrors(PlayerId player_id, logger::ErrorType error_type,
-	               std::string message);
+	               int64_t actor_id = -1, int64_t arg = -1);
 
 	/**
 	 * Assigns attributes for towers
 	 *
 	 * @param[in]   id            player identifier
+	 * @param[in]   state_towers  towers of the player in the main state
 	 * @param[in]   towers        array to assign values to
 	 * @param[in]   is_opponent   if it is opponent id
 	 *
 	 */
 	void AssignTowerAttributes(
-	    int64_t id, std::array<player_state::Tower, MAX_NUM_TOWERS> &towers,
+	    int64_t id, const std::vector<Tower *> &state_towers,
+	    std::array<player_state::Tower, MAX_NUM_TOWERS> &towers,
 	    bool is_opponent);
 
 	/**
-	 * Assigns attributes for towers
+	 * Assigns attributes for soldiers
 	 *
-	 * @param[in]   id            player identifier
-	 * @param[in]   soldiers      array to assign values to
-	 * @param[in]   is_opponent   if it is opponent id
+	 * @param[in]   id              player identifier
+	 * @param[in]   state_soldiers  soldiers of the player in the main state
+	 * @param[in]   soldiers        array to assign values to
+	 * @param[in]   is_opponent     if it is opponent id
 	 *
 	 */
 	void AssignSoldierAttributes(
-	    int64_t id, std::array<player_state::Soldier, NUM_SOLDIERS> &soldiers,
+	    int64_t id, const std::vector<Soldier *> &state_soldiers,
+	    std::array<player_state::Soldier, NUM_SOLDIERS> &soldiers,
 	    bool is_opponent);
 
+	/**
+	 * Rebuilds the index of a list of player state soldiers by map element
+	 *
+	 * The grid has MAP_SIZE * MAP_SIZE + 1 starts, which the player may read
+	 * any of, so each is written once. That pass is the bulk of the cost.
+	 * The soldiers are counted in soldier_cell_counts, of which only the
+	 * cells they occupy are cleared afterwards
+	 *
+	 * @param[in]   soldiers      soldiers already synced from the main state
+	 * @param[in]   num_soldiers  number of soldiers in use in soldiers
+	 * @param[out]  grid          index to write to
+	 */
+	void AssignSoldierGrid(
+	    const std::array<player_state::Soldier, NUM_SOLDIERS> &soldiers,
+	    int64_t num_soldiers, player_state::SoldierGrid &grid);
+
   public:
 	/**
 	 * Constructor for StateSyncer class
@@ -192,6 +315,11 @@ class STATE_EXPORT StateSyncer : public IStateSyncer {
 	 * Also checks player moves and rejects them if invalid
 	 * Calls corresponding action functions on valid moves
 	 *
+	 * Commands are read from each player's command buffer, which takes time
+	 * in the number of commands. A player that issued none has its writables
+	 * scanned instead. Tower commands of all players run first, then each
+	 * player's soldier and build commands in the order they were issued
+	 *
 	 * @param[in]   player_states               list of player states to
 	 *                                          read and execute moves from
 	 * @param[in]   skip_player_commands_flags  if true at an index, skip that
@@ -211,6 +339,10 @@ class STATE_EXPORT StateSyncer : public IStateSyncer {
 	 * After the state has been updated, refresh the player states
 	 * with new values, and remove the player moves
 	 *
+	 * The player states are written to in place. After the first call, only
+	 * map elements whose ownership changed or that gained or lost a tower
+	 * are written
+	 *
 	 * @param[inout]  player_states  list of player states to update
 	 */
 	void UpdatePlayerStates(
@@ -7,6 +7,7 @@
 #define STATE_TOWER_MANAGER_TOWER_MANAGER_H
 
 #include "physics/vector.h"
+#include "state/actor/actor_id_allocator.h"
 #include "state/actor/tower.h"
 #include "state/interfaces/i_updatable.h"
 #include "state/map/map.h"
@@ -30,6 +31,12 @@ class STATE_EXPORT TowerManager : public IUpdatable {
 	 */
 	std::vector<std::unique_ptr<Tower>> towers;
 
+	/**
+	 * Pointers to the towers in towers, in the same order. Refreshed whenever
+	 * towers are built or destroyed
+	 */
+	std::vector<Tower *> tower_ptrs;
+
 	/**
 	 * Denotes which player this tower manager corresponds to
 	 */
@@ -45,6 +52,11 @@ class STATE_EXPORT TowerManager : public IUpdatable {
 	 */
 	IMap *map;
 
+	/**
+	 * Pointer to the game's actor id allocator, for ids of new towers
+	 */
+	ActorIdAllocator *actor_id_allocator;
+
 	/**
 	 * List of offsets to build towers at
 	 *
@@ -82,6 +94,33 @@ class STATE_EXPORT TowerManager : public IUpdatable {
 	 */
 	std::vector<std::vector<int64_t>> territory_refs;
 
+	/**
+	 * Offsets of map elements whose ownership by this player changed since
+	 * the last call to ClearDirtyOffsets
+	 */
+	std::vector<physics::Vector> dirty_offsets;
+
+	/**
+	 * Adds a reference to territory at the given offset, taking ownership of
+	 * it if it wasn't owned already
+	 *
+	 * @param[in]  offset  Offset of the map element
+	 */
+	void AddTerritoryRef(physics::Vector offset);
+
+	/**
+	 * Removes a reference to territory at the given offset, giving up
+	 * ownership of it once no references are left
+	 *
+	 * @param[in]  offset  Offset of the map element
+	 */
+	void RemoveTerritoryRef(physics::Vector offset);
+
+	/**
+	 * Refreshes tower_ptrs to match towers
+	 */
+	void RefreshTowerPtrs();
+
 	/**
 	 * Utility function that when given a tower, returns its range on the map
 	 * as a vector containing the lower bound and the upper bound
@@ -126,7 +165,8 @@ class STATE_EXPORT TowerManager : public IUpdatable {
 	TowerManager();
 
 	TowerManager(std::vector<std::unique_ptr<Tower>> towers, PlayerId player_id,
-	             MoneyManager *money_manager, IMap *map);
+	             MoneyManager *money_manager, IMap *map,
+	             ActorIdAllocator *actor_id_allocator);
 
 	/**
 	 * Amount of money necessary to upgrade tower to next level
@@ -186,12 +226,25 @@ class STATE_EXPORT TowerManager : public IUpdatable {
 	 */
 	Tower *GetTowerById(ActorId tower_id);
 
+	/**
+	 * Get the offsets of map elements whose ownership by this player changed
+	 * since the last call to ClearDirtyOffsets
+	 *
+	 * @return     List of offsets, may contain duplicates
+	 */
+	const std::vector<physics::Vector> &GetDirtyOffsets();
+
+	/**
+	 * Forget about ownership changes made so far
+	 */
+	void ClearDirtyOffsets();
+
 	/**
 	 * Get all the towers currently owned by this manager
 	 *
-	 * @return     List of tower pointers
+	 * @return     List of tower pointers, valid until the next Update
 	 */
-	std::vector<Tower *> GetTowers();
+	const std::vector<Tower *> &GetTowers();
 
 	/**
 	 * Update function that sets tower statuses
@@ -20,19 +20,8 @@ Actor::Actor(ActorId id, PlayerId player_id, ActorType actor_type, int64_t hp,
 
 Actor::~Actor() {}
 
-ActorId Actor::actor_id_increment = 0;
-
 ActorId Actor::GetActorId() { return id; }
 
-void Actor::SetActorIdIncrement(ActorId actor_id) {
-	if (actor_id < 0) {
-		throw std::out_of_range("`actor_id` cannot be negative");
-	}
-	actor_id_increment = actor_id;
-}
-
-ActorId Actor::GetNextActorId() { return actor_id_increment++; }
-
 PlayerId Actor::GetPlayerId() { return player_id; }
 
 ActorType Actor::GetActorType() { return actor_type; }
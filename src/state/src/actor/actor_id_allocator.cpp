@@ -0,0 +1,23 @@
+/**
+ * @file actor_id_allocator.cpp
+ * Defines the methods of the ActorIdAllocator class
+ */
+
+#include "state/actor/actor_id_allocator.h"
+#include <stdexcept>
+
+namespace state {
+
+ActorIdAllocator::ActorIdAllocator(ActorId next_actor_id) {
+	SetNextActorId(next_actor_id);
+}
+
+ActorId ActorIdAllocator::GetNextActorId() { return next_actor_id++; }
+
+void ActorIdAllocator::SetNextActorId(ActorId next_actor_id) {
+	if (next_actor_id < 0) {
+		throw std::out_of_range("`next_actor_id` cannot be negative");
+	}
+	this->next_actor_id = next_actor_id;
+}
+}
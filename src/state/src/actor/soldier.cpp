@@ -5,7 +5,6 @@
 
 #include "state/actor/soldier.h"
 #include "physics/vector.h"
-#include "state/actor/soldier_states/idle_state.h"
 #include "state/actor/soldier_states/soldier_state.h"
 
 namespace state {
@@ -22,9 +21,9 @@ Soldier::Soldier(ActorId id, PlayerId player_id, ActorType actor_type,
       attack_target(nullptr), destination(physics::Vector(0, 0)),
       is_destination_set(false), new_position(physics::Vector(0, 0)),
       is_new_position_set(false), damage_incurred(0),
-      state(std::make_unique<IdleState>(this)), path_planner(path_planner),
-      money_manager(money_manager), is_invulnerable(false),
-      num_turns_invulnerable(0) {}
+      state(SoldierStateName::IDLE), remaining_turns_to_respawn(0),
+      path_planner(path_planner), money_manager(money_manager),
+      is_invulnerable(false), num_turns_invulnerable(0) {}
 
 int64_t Soldier::GetSpeed() { return speed; }
 
@@ -83,7 +82,7 @@ IPathPlanner *Soldier::GetPathPlanner() { return path_planner; }
 
 MoneyManager *Soldier::GetMoneyManager() { return money_manager; }
 
-SoldierStateName Soldier::GetState() { return state->GetName(); }
+SoldierStateName Soldier::GetState() { return state; }
 
 void Soldier::Move(physics::Vector destination) {
 	this->destination = destination;
@@ -134,24 +133,162 @@ void Soldier::LateUpdate() {
 	}
 
 	// Allow soldier to transition to dead state if it's dead
-	if (this->hp == 0 && state->GetName() != SoldierStateName::DEAD) {
-		auto new_state = state->Update();
-		state->Exit();
-		state = std::move(new_state);
-		state->Enter();
-		state->Update();
+	if (this->hp == 0 && state != SoldierStateName::DEAD) {
+		SoldierStateName new_state;
+		UpdateState(new_state);
+		TransitionTo(new_state);
+		UpdateState(new_state);
 	}
 }
 
 void Soldier::Update() {
-	auto new_state = state->Update();
+	SoldierStateName new_state;
 
-	while (new_state != nullptr) {
+	while (UpdateState(new_state)) {
 		// State transition has occured
-		state->Exit();
-		state = std::move(new_state);
-		state->Enter();
-		new_state = state->Update();
+		TransitionTo(new_state);
+	}
+}
+
+bool Soldier::UpdateState(SoldierStateName &new_state) {
+	switch (state) {
+	case SoldierStateName::IDLE:
+		// Check if the soldier is dead
+		if (hp == 0) {
+			new_state = SoldierStateName::DEAD;
+			return true;
+		}
+
+		// Check if the destination is set
+		if (is_destination_set) {
+			new_state = SoldierStateName::MOVE;
+			return true;
+		}
+
+		// Check if there's an attack target set
+		if (IsAttackTargetSet()) {
+			new_state = IsAttackTargetInRange() ? SoldierStateName::ATTACK
+			                                    : SoldierStateName::PURSUIT;
+			return true;
+		}
+		return false;
+
+	case SoldierStateName::MOVE:
+		// Check if the soldier is dead
+		if (hp == 0) {
+			new_state = SoldierStateName::DEAD;
+			return true;
+		}
+
+		// Check if there's an attack target set
+		if (IsAttackTargetSet()) {
+			new_state = IsAttackTargetInRange() ? SoldierStateName::ATTACK
+			                                    : SoldierStateName::PURSUIT;
+			return true;
+		}
+
+		// Check if destination has been reached
+		if (position == destination) {
+			new_state = SoldierStateName::IDLE;
+			return true;
+		}
+
+		// Use path planner to get next position
+		SetNewPosition(
+		    path_planner->GetNextPosition(position, destination, speed));
+		return false;
+
+	case SoldierStateName::PURSUIT:
+	case SoldierStateName::ATTACK:
+		// Check if the soldier is dead
+		if (hp == 0) {
+			attack_target = nullptr;
+			new_state = SoldierStateName::DEAD;
+			return true;
+		}
+
+		// Check if destination is set
+		if (is_destination_set) {
+			attack_target = nullptr;
+			new_state = SoldierStateName::MOVE;
+			return true;
+		}
+
+		// Check if the target is dead
+		if (attack_target->GetLatestHp() == 0) {
+			attack_target = nullptr;
+			new_state = SoldierStateName::IDLE;
+			return true;
+		}
+
+		if (state == SoldierStateName::PURSUIT) {
+			// Check if target in range
+			if (IsAttackTargetInRange()) {
+				new_state = SoldierStateName::ATTACK;
+				return true;
+			}
+
+			// Use path planner to get next position
+			SetNewPosition(path_planner->GetNextPosition(
+			    position, attack_target->GetPosition(), speed));
+			return false;
+		}
+
+		// Check if the target is out of range
+		if (not IsAttackTargetInRange()) {
+			new_state = SoldierStateName::PURSUIT;
+			return true;
+		}
+
+		// Inflict damage on opponent
+		attack_target->Damage(attack_damage);
+
+		// Check if opponent is now dead
+		if (attack_target->GetLatestHp() == 0) {
+			// Reward player for kill
+			money_manager->RewardKill(attack_target);
+		}
+		return false;
+
+	case SoldierStateName::DEAD:
+		// Check if soldier should be respawned
+		if (remaining_turns_to_respawn == 0) {
+			new_state = SoldierStateName::IDLE;
+			return true;
+		}
+
+		// Decrement respawn timer
+		remaining_turns_to_respawn--;
+		return false;
+	}
+	return false;
+}
+
+void Soldier::TransitionTo(SoldierStateName new_state) {
+	// Exit the current state
+	switch (state) {
+	case SoldierStateName::MOVE:
+		// Unset the destination on exit
+		ClearDestination();
+		break;
+	case SoldierStateName::DEAD:
+		// Respawn the soldier
+		SetPosition(Soldier::respawn_positions[(int)player_id]);
+		SetHp(max_hp);
+		SetAttackTarget(nullptr);
+		ClearDestination();
+		MakeInvulnerable();
+		break;
+	default:
+		break;
+	}
+
+	state = new_state;
+
+	// Enter the new state
+	if (state == SoldierStateName::DEAD) {
+		// Start the respawn timer
+		remaining_turns_to_respawn = Soldier::total_turns_to_respawn;
 	}
 }
 }
@@ -17,6 +17,10 @@ TerrainType MapElement::GetTerrainType() { return this->terrain_type; }
 
 std::vector<bool> MapElement::GetOwnership() { return this->ownership; }
 
+bool MapElement::GetOwnership(PlayerId player_id) {
+	return this->ownership[static_cast<int>(player_id)];
+}
+
 void MapElement::SetOwnership(PlayerId player_id, bool ownership) {
 	this->ownership[static_cast<int>(player_id)] = ownership;
 }
@@ -0,0 +1,169 @@
+/**
+ * @file spatial_grid.cpp
+ * Definitions for the index of soldiers by map element
+ */
+
+#include "state/map/spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace state {
+
+SpatialGrid::SpatialGrid() {
+	// Init None
+}
+
+SpatialGrid::SpatialGrid(int64_t map_size, int64_t element_size)
+    : map_size(map_size), element_size(element_size),
+      cells(map_size * map_size) {}
+
+int64_t SpatialGrid::GetCellIndex(physics::Vector position) {
+	int64_t x = std::floor(position.x / element_size);
+	int64_t y = std::floor(position.y / element_size);
+	x = std::min(std::max(x, (int64_t)0), map_size - 1);
+	y = std::min(std::max(y, (int64_t)0), map_size - 1);
+
+	return x * map_size + y;
+}
+
+void SpatialGrid::AddToCell(Soldier *soldier, int64_t cell_index) {
+	auto actor_id = soldier->GetActorId();
+	auto &cell = this->cells[cell_index];
+
+	this->soldier_cells[actor_id] = cell_index;
+	this->soldier_slots[actor_id] = cell.size();
+	cell.push_back(soldier);
+}
+
+void SpatialGrid::RemoveFromCell(Soldier *soldier) {
+	auto actor_id = soldier->GetActorId();
+	auto &cell = this->cells[this->soldier_cells[actor_id]];
+	auto slot = this->soldier_slots[actor_id];
+
+	// Fill the gap with the last soldier of the cell
+	cell[slot] = cell.back();
+	this->soldier_slots[cell[slot]->GetActorId()] = slot;
+	cell.pop_back();
+
+	this->soldier_cells[actor_id] = -1;
+}
+
+void SpatialGrid::Insert(Soldier *soldier) {
+	auto actor_id = soldier->GetActorId();
+	if (static_cast<size_t>(actor_id) >= this->soldier_cells.size()) {
+		this->soldier_cells.resize(actor_id + 1, -1);
+		this->soldier_slots.resize(actor_id + 1, -1);
+	}
+	if (this->soldier_cells[actor_id] != -1) {
+		throw std::out_of_range("Soldier is already in the grid");
+	}
+
+	AddToCell(soldier, GetCellIndex(soldier->GetPosition()));
+}
+
+void SpatialGrid::Remove(Soldier *soldier) {
+	auto actor_id = soldier->GetActorId();
+	if (static_cast<size_t>(actor_id) >= this->soldier_cells.size() ||
+	    this->soldier_cells[actor_id] == -1) {
+		throw std::out_of_range("Soldier is not in the grid");
+	}
+
+	RemoveFromCell(soldier);
+}
+
+void SpatialGrid::UpdateSoldier(Soldier *soldier) {
+	auto actor_id = soldier->GetActorId();
+	if (static_cast<size_t>(actor_id) >= this->soldier_cells.size() ||
+	    this->soldier_cells[actor_id] == -1) {
+		throw std::out_of_range("Soldier is not in the grid");
+	}
+
+	auto new_cell_index = GetCellIndex(soldier->GetPosition());
+	if (new_cell_index == this->soldier_cells[actor_id]) {
+		return;
+	}
+
+	RemoveFromCell(soldier);
+	AddToCell(soldier, new_cell_index);
+}
+
+void SpatialGrid::GetSoldiersInRange(physics::Vector position, double range,
+                                     std::vector<Soldier *> &soldiers) {
+	soldiers.clear();
+	if (range < 0) {
+		return;
+	}
+
+	// Only the cells overlapping the square around the circle can hold
+	// soldiers in range
+	auto lower = GetCellIndex(position - range);
+	auto upper = GetCellIndex(position + range);
+
+	for (int64_t x = lower / map_size; x <= upper / map_size; ++x) {
+		for (int64_t y = lower % map_size; y <= upper % map_size; ++y) {
+			for (auto *soldier : this->cells[x * map_size + y]) {
+				if (position.distance(soldier->GetPosition()) <= range) {
+					soldiers.push_back(soldier);
+				}
+			}
+		}
+	}
+}
+
+void SpatialGrid::GetNearestSoldiers(physics::Vector position, int64_t count,
+                                     std::vector<Soldier *> &soldiers) {
+	soldiers.clear();
+	if (count <= 0) {
+		return;
+	}
+
+	auto is_nearer = [&position](Soldier *a, Soldier *b) {
+		auto distance_a = position.distance(a->GetPosition());
+		auto distance_b = position.distance(b->GetPosition());
+		if (distance_a != distance_b) {
+			return distance_a < distance_b;
+		}
+		return a->GetActorId() < b->GetActorId();
+	};
+
+	auto centre = GetCellIndex(position);
+	int64_t centre_x = centre / map_size;
+	int64_t centre_y = centre % map_size;
+
+	// Collect soldiers ring by ring of cells around the centre cell. Every
+	// soldier beyond ring r is at least r cells away, so once count soldiers
+	// are at least that close, the rest cannot be nearer
+	for (int64_t r = 0; r < map_size; ++r) {
+		for (int64_t x = centre_x - r; x <= centre_x + r; ++x) {
+			if (x < 0 || x >= map_size) {
+				continue;
+			}
+			// Inner columns of the ring only have their top and bottom cells
+			bool is_edge_column = (x == centre_x - r || x == centre_x + r);
+			int64_t y_step = is_edge_column ? 1 : std::max(2 * r, (int64_t)1);
+			for (int64_t y = centre_y - r; y <= centre_y + r; y += y_step) {
+				if (y < 0 || y >= map_size) {
+					continue;
+				}
+				auto &cell = this->cells[x * map_size + y];
+				soldiers.insert(soldiers.end(), cell.begin(), cell.end());
+			}
+		}
+
+		if (soldiers.size() >= static_cast<size_t>(count)) {
+			std::nth_element(soldiers.begin(), soldiers.begin() + count - 1,
+			                 soldiers.end(), is_nearer);
+			auto farthest = soldiers[count - 1]->GetPosition();
+			if (position.distance(farthest) <= r * element_size) {
+				break;
+			}
+		}
+	}
+
+	auto num_found = std::min(count, (int64_t)soldiers.size());
+	std::partial_sort(soldiers.begin(), soldiers.begin() + num_found,
+	                  soldiers.end(), is_nearer);
+	soldiers.resize(num_found);
+}
+}
@@ -80,6 +80,10 @@ int64_t MoneyManager::GetBalance(state::PlayerId player_id) {
 	return player_money[static_cast<int>(player_id)];
 }
 
+const std::vector<int64_t> &MoneyManager::GetBalances() {
+	return player_money;
+}
+
 void MoneyManager::RewardSuicide(Tower *tower) {
 	auto tower_level = tower->GetTowerLevel();
 	auto player_id = tower->GetPlayerId();
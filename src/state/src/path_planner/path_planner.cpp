@@ -7,105 +7,224 @@
 #include <algorithm>
 #include <cmath>
 #include <exception>
-#include <memory>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
 
 namespace state {
 
-PathPlanner::PathPlanner(Map *map) {
-	// Initialise Members
-	this->map_size = map->GetSize();
-	this->map = map;
-	this->adjacency_list = init_matrix(std::list<physics::Vector>(), map_size);
-	this->paths =
-	    init_matrix(init_matrix(physics::Vector(), map_size), map_size);
-
-	// Set Edges into the Adjacency List
-	for (int i = 0; i < map->GetSize(); ++i) {
-		for (int j = 0; j < map->GetSize(); ++j) {
-			MapElement element = map->GetElementByOffset(physics::Vector(i, j));
-			if (element.GetTerrainType() == TerrainType::LAND) {
-				this->adjacency_list[i][j] =
-				    FindNeighbors(physics::Vector(i, j), map);
-			} else if (element.GetTerrainType() == TerrainType::WATER) {
+PathPlanner::PathPlanner(Map *map, int64_t max_cached_path_trees)
+    : map(map), map_size(map->GetSize()), all_paths(nullptr),
+      max_cached_path_trees(max_cached_path_trees) {
+	int64_t num_elements = map_size * map_size;
+	if (num_elements > UINT16_MAX + 1) {
+		throw std::out_of_range("Map too large to plan paths on");
+	}
+	if (max_cached_path_trees < 1) {
+		throw std::out_of_range("Path planner must cache at least one path");
+	}
+
+	// Choose the 4 Adjacent Nodes
+	const physics::Vector rel_neighbors[] = {
+	    physics::Vector(0, 1), physics::Vector(0, -1), physics::Vector(1, 0),
+	    physics::Vector(-1, 0)};
+
+	// Set Edges into the adjacency lists. Water has no way out
+	this->neighbor_starts.reserve(num_elements + 1);
+	this->offsets.reserve(num_elements);
+	for (int i = 0; i < map_size; ++i) {
+		for (int j = 0; j < map_size; ++j) {
+			this->neighbor_starts.push_back(this->neighbors.size());
+			this->offsets.emplace_back(i, j);
+
+			auto terrain = map->GetElementByOffset(physics::Vector(i, j))
+			                   .GetTerrainType();
+			if (terrain != TerrainType::LAND) {
 				continue;
 			}
-		}
-	}
 
-	// Populate the paths array with next node data
-	for (int i = 0; i < map->GetSize(); ++i) {
-		for (int j = 0; j < map->GetSize(); ++j) {
-			paths[i][j] = ComputeAllPathsFromNode(physics::Vector(i, j));
+			for (auto &rel_neighbor : rel_neighbors) {
+				int64_t x = i + rel_neighbor.x;
+				int64_t y = j + rel_neighbor.y;
+				if (x >= 0 && x < map_size && y >= 0 && y < map_size) {
+					this->neighbors.push_back(x * map_size + y);
+				}
+			}
 		}
 	}
-}
+	this->neighbor_starts.push_back(this->neighbors.size());
 
-std::list<physics::Vector> PathPlanner::FindNeighbors(physics::Vector elem,
-                                                      Map *map) {
-	int x, y;
+	this->cached_path_trees.resize(num_elements, this->path_trees.end());
+	this->search_queue.reserve(num_elements);
+}
 
-	std::list<physics::Vector> neighbors;
-	std::list<physics::Vector> rel_neighbors;
+PathPlanner::PathPlanner(Map *map, const std::string &path_table_path,
+                         int64_t num_threads)
+    : PathPlanner(map) {
+	if (!this->path_table.Open(path_table_path, map)) {
+		// Missing or stale, find every path and save them for next time
+		int64_t num_elements = map_size * map_size;
+		std::vector<uint16_t> all_next_nodes(num_elements * num_elements);
+		std::vector<int64_t> destinations;
+		std::vector<uint16_t *> rows;
+		for (int64_t i = 0; i < num_elements; ++i) {
+			destinations.push_back(i);
+			rows.push_back(&all_next_nodes[i * num_elements]);
+		}
+		ComputeAllPathsToNodes(destinations, rows, num_threads);
 
-	// Choose the 4 Adjacent Nodes
-	rel_neighbors.emplace_back(0, 1);
-	rel_neighbors.emplace_back(0, -1);
-	rel_neighbors.emplace_back(1, 0);
-	rel_neighbors.emplace_back(-1, 0);
-
-	for (auto neighbor_pos : rel_neighbors) {
-		if (neighbor_pos.x == 0 && neighbor_pos.y == 0)
-			continue;
-		x = elem.x + neighbor_pos.x;
-		y = elem.y + neighbor_pos.y;
-		if (x >= 0 && x < map_size && y >= 0 && y < map_size &&
-		    map->GetElementByOffset(elem).GetTerrainType() ==
-		        TerrainType::LAND) {
-			neighbors.emplace_back(x, y);
+		if (!PathTable::Write(path_table_path, map, all_next_nodes) ||
+		    !this->path_table.Open(path_table_path, map)) {
+			// Could not share them, keep this process' copy
+			this->all_paths_copy = std::move(all_next_nodes);
+			this->all_paths = this->all_paths_copy.data();
+			return;
 		}
 	}
-	return neighbors;
+
+	this->all_paths = this->path_table.GetNextNodes(0);
 }
 
-matrix<physics::Vector>
-PathPlanner::ComputeAllPathsFromNode(physics::Vector node) {
-	std::queue<physics::Vector> queue;
-	auto visited = init_matrix(false, map_size);
-
-	// A matrix which for each element, contains the node that comes
-	// next in the path. By following the nodeset for a particular
-	// destination from a source, we can obtain the path.
-	//
-	// Each element of this->paths will be the next_node_matrix belonging
-	// to that particular element. This function will generate the
-	// next_node_matrix corresponding to the argument passed
-	auto next_node_matrix = init_matrix(physics::Vector(), map_size);
-	next_node_matrix[node.x][node.y] = node;
+void PathPlanner::ComputeAllPathsToNode(int64_t destination,
+                                        uint16_t *next_nodes,
+                                        std::vector<uint16_t> &search_queue,
+                                        std::vector<bool> &visited) {
+	// For each element, next_nodes holds the element that comes next in the
+	// path towards destination. By following it from a source, we can
+	// obtain the path
+	std::fill(next_nodes, next_nodes + map_size * map_size, 0);
+	next_nodes[destination] = destination;
 
 	// BFS All Nodes
 	// Add the first node
-	queue.push(node);
-	visited[node.x][node.y] = true;
+	visited.assign(map_size * map_size, false);
+	search_queue.clear();
+	search_queue.push_back(destination);
+	visited[destination] = true;
 
-	// Variable to store the node currently being searched on
-	physics::Vector current;
+	// The queue is never popped from, every element is pushed at most once
+	for (int64_t head = 0; head < search_queue.size(); ++head) {
+		auto current = search_queue[head];
 
-	// While there are no new nodes to visit
-	while (!queue.empty()) {
-		// Get the next node from the queue
-		current = queue.front();
-		queue.pop();
 		// Iterate through all the neighbors of the current node
-		for (const auto &neighbor : adjacency_list[current.x][current.y]) {
-			if (visited[neighbor.x][neighbor.y])
+		for (int64_t k = this->neighbor_starts[current];
+		     k < this->neighbor_starts[current + 1]; ++k) {
+			auto neighbor = this->neighbors[k];
+			if (visited[neighbor])
 				continue;
 			// Visit the neighbor
-			visited[neighbor.x][neighbor.y] = true;
-			next_node_matrix[neighbor.x][neighbor.y] = current;
-			queue.push(neighbor);
+			visited[neighbor] = true;
+			next_nodes[neighbor] = current;
+			search_queue.push_back(neighbor);
+		}
+	}
+}
+
+void PathPlanner::ComputeAllPathsToNodes(
+    const std::vector<int64_t> &destinations,
+    const std::vector<uint16_t *> &next_nodes, int64_t num_threads) {
+	int64_t num_destinations = destinations.size();
+	num_threads = std::max((int64_t)1, std::min(num_threads, num_destinations));
+
+	// Thread i finds paths to destinations i, i + num_threads, ... with its
+	// own scratch space
+	auto compute_slice = [&, num_threads](int64_t i) {
+		std::vector<uint16_t> search_queue;
+		search_queue.reserve(map_size * map_size);
+		std::vector<bool> visited;
+		for (; i < num_destinations; i += num_threads) {
+			ComputeAllPathsToNode(destinations[i], next_nodes[i], search_queue,
+			                      visited);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int64_t i = 1; i < num_threads; ++i) {
+		threads.emplace_back(compute_slice, i);
+	}
+	compute_slice(0);
+	for (auto &thread : threads) {
+		thread.join();
+	}
+}
+
+PathPlanner::PathTree &PathPlanner::AddPathTree(int64_t destination) {
+	if (this->path_trees.size() < this->max_cached_path_trees) {
+		this->path_trees.emplace_front();
+	} else {
+		// Reuse the least recently used entry and its storage
+		this->path_trees.splice(this->path_trees.begin(), this->path_trees,
+		                        std::prev(this->path_trees.end()));
+		this->cached_path_trees[this->path_trees.front().destination] =
+		    this->path_trees.end();
+	}
+
+	auto path_tree = this->path_trees.begin();
+	path_tree->destination = destination;
+	path_tree->next_nodes.resize(map_size * map_size);
+	this->cached_path_trees[destination] = path_tree;
+
+	return *path_tree;
+}
+
+const std::vector<uint16_t> &PathPlanner::GetPathTree(int64_t destination) {
+	auto path_tree = this->cached_path_trees[destination];
+
+	if (path_tree != this->path_trees.end()) {
+		// Cached, move it to the front
+		if (path_tree != this->path_trees.begin()) {
+			this->path_trees.splice(this->path_trees.begin(),
+			                        this->path_trees, path_tree);
+		}
+		return path_tree->next_nodes;
+	}
+
+	auto &new_path_tree = AddPathTree(destination);
+	ComputeAllPathsToNode(destination, new_path_tree.next_nodes.data(),
+	                      this->search_queue, this->visited);
+
+	return new_path_tree.next_nodes;
+}
+
+void PathPlanner::CheckDestination(const physics::Vector &node) {
+	if (node.x < 0 || node.y < 0 || node.x >= map_size ||
+	    node.y >= map_size) {
+		throw std::out_of_range("Destination node out of range");
+	}
+
+	if (this->map->GetElementByOffset(node).GetTerrainType() !=
+	    TerrainType::LAND) {
+		throw std::out_of_range("Destination node is of invalid terrain type");
+	}
+}
+
+void PathPlanner::PrecomputePaths(
+    const std::vector<physics::Vector> &destinations, int64_t num_threads) {
+	for (auto &destination : destinations) {
+		CheckDestination(destination);
+	}
+
+	// Every path is already at hand
+	if (this->all_paths != nullptr) {
+		return;
+	}
+
+	// Claim cache entries up front, so that the threads only write to the
+	// path trees they were handed
+	std::vector<int64_t> new_destinations;
+	std::vector<uint16_t *> new_next_nodes;
+	for (auto &destination : destinations) {
+		if (new_destinations.size() == this->max_cached_path_trees) {
+			break;
+		}
+		int64_t index = destination.x * map_size + destination.y;
+		if (this->cached_path_trees[index] == this->path_trees.end()) {
+			new_destinations.push_back(index);
+			new_next_nodes.push_back(AddPathTree(index).next_nodes.data());
 		}
 	}
-	return next_node_matrix;
+
+	ComputeAllPathsToNodes(new_destinations, new_next_nodes, num_threads);
 }
 
 physics::Vector PathPlanner::GetNextNode(const physics::Vector &source,
@@ -116,10 +235,7 @@ physics::Vector PathPlanner::GetNextNode(const physics::Vector &source,
 		throw std::out_of_range("Source node out of range");
 	}
 
-	if (destination.x < 0 || destination.y < 0 || destination.x >= map_size ||
-	    destination.y >= map_size) {
-		throw std::out_of_range("Destination node out of range");
-	}
+	CheckDestination(destination);
 
 	// Terrain Checks
 	if (this->map->GetElementByOffset(source).GetTerrainType() !=
@@ -127,13 +243,18 @@ physics::Vector PathPlanner::GetNextNode(const physics::Vector &source,
 		throw std::out_of_range("Source node is of invalid terrain type");
 	}
 
-	if (this->map->GetElementByOffset(destination).GetTerrainType() !=
-	    TerrainType::LAND) {
-		throw std::out_of_range("Destination node is of invalid terrain type");
+	// Return the next node in the path
+	int64_t destination_index = destination.x * map_size + destination.y;
+	int64_t source_index = source.x * map_size + source.y;
+	if (this->all_paths != nullptr) {
+		int64_t num_elements = map_size * map_size;
+		auto next_node =
+		    this->all_paths[destination_index * num_elements + source_index];
+		return this->offsets[next_node];
 	}
 
-	// Return the next node in the list
-	return paths[destination.x][destination.y][source.x][source.y];
+	auto &next_nodes = GetPathTree(destination_index);
+	return this->offsets[next_nodes[source_index]];
 }
 
 physics::Vector PathPlanner::GetNextPosition(const physics::Vector &source,
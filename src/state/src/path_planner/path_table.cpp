@@ -0,0 +1,160 @@
+/**
+ * @file path_table.cpp
+ * Defines the file of precomputed paths between map elements
+ */
+
+#include "state/path_planner/path_table.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace state {
+
+namespace {
+
+const char path_table_magic[8] = {'C', 'C', 'P', 'A', 'T', 'H', 'S', '\0'};
+
+/**
+ * Writes all of a buffer to a file descriptor
+ */
+bool WriteAll(int fd, const char *data, size_t size) {
+	while (size > 0) {
+		auto written = write(fd, data, size);
+		if (written <= 0) {
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+}
+
+PathTable::PathTable() : mapping(nullptr), mapping_size(0), num_elements(0) {}
+
+PathTable::~PathTable() { Close(); }
+
+void PathTable::Close() {
+	if (this->mapping != nullptr) {
+		munmap(this->mapping, this->mapping_size);
+		this->mapping = nullptr;
+	}
+}
+
+uint64_t PathTable::HashTerrain(Map *map) {
+	uint64_t hash = 14695981039346656037ULL;
+	auto mix = [&hash](uint64_t value) {
+		for (int i = 0; i < 8; ++i) {
+			hash ^= (value >> (8 * i)) & 0xff;
+			hash *= 1099511628211ULL;
+		}
+	};
+
+	auto map_size = map->GetSize();
+	mix(map_size);
+	for (int i = 0; i < map_size; ++i) {
+		for (int j = 0; j < map_size; ++j) {
+			mix(static_cast<uint64_t>(
+			    map->GetElementByOffset(physics::Vector(i, j))
+			        .GetTerrainType()));
+		}
+	}
+
+	return hash;
+}
+
+PathTable::Header PathTable::MakeHeader(Map *map) {
+	Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, path_table_magic, sizeof(header.magic));
+	header.version = PathTable::version;
+	header.element_index_size = sizeof(uint16_t);
+	header.map_size = map->GetSize();
+	header.terrain_hash = HashTerrain(map);
+
+	return header;
+}
+
+bool PathTable::Open(const std::string &path, Map *map) {
+	Close();
+
+	int64_t num_elements = map->GetSize() * map->GetSize();
+	size_t expected_size =
+	    sizeof(Header) + num_elements * num_elements * sizeof(uint16_t);
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 ||
+	    static_cast<size_t>(file_stat.st_size) != expected_size) {
+		close(fd);
+		return false;
+	}
+
+	auto *mapping = mmap(nullptr, expected_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+
+	auto expected_header = MakeHeader(map);
+	if (std::memcmp(mapping, &expected_header, sizeof(Header)) != 0) {
+		munmap(mapping, expected_size);
+		return false;
+	}
+
+	// Paths are followed without bounds checks, so an element number off the
+	// map, from a corrupt or half-written file, must not get past here
+	auto *next_nodes = reinterpret_cast<const uint16_t *>(
+	    static_cast<const char *>(mapping) + sizeof(Header));
+	auto num_next_nodes = num_elements * num_elements;
+	for (int64_t i = 0; i < num_next_nodes; ++i) {
+		if (next_nodes[i] >= num_elements) {
+			munmap(mapping, expected_size);
+			return false;
+		}
+	}
+
+	this->mapping = mapping;
+	this->mapping_size = expected_size;
+	this->num_elements = num_elements;
+
+	return true;
+}
+
+bool PathTable::Write(const std::string &path, Map *map,
+                      const std::vector<uint16_t> &next_nodes) {
+	auto temp_path = path + ".tmp." + std::to_string(getpid());
+	int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+
+	auto header = MakeHeader(map);
+	bool is_written =
+	    WriteAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) &&
+	    WriteAll(fd, reinterpret_cast<const char *>(next_nodes.data()),
+	             next_nodes.size() * sizeof(uint16_t)) &&
+	    fsync(fd) == 0;
+	is_written = (close(fd) == 0) && is_written;
+
+	if (!is_written || rename(temp_path.c_str(), path.c_str()) != 0) {
+		unlink(temp_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+const uint16_t *PathTable::GetNextNodes(int64_t destination) {
+	auto *rows = reinterpret_cast<const uint16_t *>(
+	    static_cast<const char *>(this->mapping) + sizeof(Header));
+
+	return rows + destination * this->num_elements;
+}
+}
@@ -0,0 +1,126 @@
+/**
+ * @file profiler.cpp
+ * Defines the profiler that times the phases of each turn
+ */
+
+#include "state/profiler/profiler.h"
+#include <algorithm>
+#include <limits>
+
+namespace state {
+
+namespace {
+
+thread_local Profiler *active_profiler = nullptr;
+
+/**
+ * Returns the histogram bucket of a duration
+ */
+int GetBucket(int64_t duration_ns) {
+	int bucket = 0;
+	while (bucket < Profiler::num_buckets - 1 &&
+	       duration_ns >= (int64_t(1) << bucket)) {
+		++bucket;
+	}
+	return bucket;
+}
+}
+
+Profiler::Profiler() {
+	for (auto &stats : this->phase_stats) {
+		stats.count = 0;
+		stats.total_ns = 0;
+		stats.min_ns = std::numeric_limits<int64_t>::max();
+		stats.max_ns = 0;
+		stats.buckets.fill(0);
+	}
+}
+
+void Profiler::Record(ProfilePhase phase, int64_t duration_ns) {
+	auto &stats = this->phase_stats[static_cast<int>(phase)];
+	stats.count++;
+	stats.total_ns += duration_ns;
+	stats.min_ns = std::min(stats.min_ns, duration_ns);
+	stats.max_ns = std::max(stats.max_ns, duration_ns);
+	stats.buckets[GetBucket(duration_ns)]++;
+}
+
+const Profiler::PhaseStats &Profiler::GetPhaseStats(ProfilePhase phase) const {
+	return this->phase_stats[static_cast<int>(phase)];
+}
+
+int64_t Profiler::GetQuantile(ProfilePhase phase, double quantile) const {
+	auto &stats = this->phase_stats[static_cast<int>(phase)];
+	if (stats.count == 0) {
+		return 0;
+	}
+
+	// The count of durations at or below the quantile, at least one
+	int64_t rank = std::max<int64_t>(1, quantile * stats.count + 0.5);
+	int64_t seen = 0;
+	for (int bucket = 0; bucket < num_buckets; ++bucket) {
+		seen += stats.buckets[bucket];
+		if (seen >= rank) {
+			// The bucket's bound may be above the largest duration
+			return std::min(int64_t(1) << bucket, stats.max_ns);
+		}
+	}
+	return stats.max_ns;
+}
+
+void Profiler::WriteJson(std::ostream &write_stream) const {
+	write_stream << "{\n  \"phases\": {";
+	for (size_t i = 0; i < this->phase_stats.size(); ++i) {
+		auto phase = static_cast<ProfilePhase>(i);
+		auto &stats = this->phase_stats[i];
+
+		write_stream << (i == 0 ? "\n" : ",\n") << "    \""
+		             << ProfilePhaseName[i] << "\": {"
+		             << "\"count\": " << stats.count
+		             << ", \"total_ns\": " << stats.total_ns
+		             << ", \"mean_ns\": "
+		             << (stats.count ? stats.total_ns / stats.count : 0)
+		             << ", \"min_ns\": " << (stats.count ? stats.min_ns : 0)
+		             << ", \"max_ns\": " << stats.max_ns
+		             << ", \"p50_ns\": " << GetQuantile(phase, 0.5)
+		             << ", \"p99_ns\": " << GetQuantile(phase, 0.99)
+		             << ", \"histogram\": [";
+
+		// Buckets as [upper bound in ns, count]
+		bool is_first_bucket = true;
+		for (int bucket = 0; bucket < num_buckets; ++bucket) {
+			if (stats.buckets[bucket] == 0) {
+				continue;
+			}
+			write_stream << (is_first_bucket ? "" : ", ") << "["
+			             << (int64_t(1) << bucket) << ", "
+			             << stats.buckets[bucket] << "]";
+			is_first_bucket = false;
+		}
+		write_stream << "]}";
+	}
+	write_stream << "\n  }\n}\n";
+}
+
+void Profiler::SetActive(Profiler *profiler) { active_profiler = profiler; }
+
+Profiler *Profiler::GetActive() { return active_profiler; }
+
+PhaseTimer::PhaseTimer(ProfilePhase phase)
+    : phase(phase), profiler(Profiler::GetActive()),
+      start(std::chrono::steady_clock::now()) {}
+
+PhaseTimer::~PhaseTimer() { Stop(); }
+
+void PhaseTimer::Stop() {
+	if (this->profiler == nullptr) {
+		return;
+	}
+
+	auto duration = std::chrono::steady_clock::now() - this->start;
+	this->profiler->Record(
+	    this->phase,
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+	this->profiler = nullptr;
+}
+}
@@ -4,9 +4,38 @@
  */
 
 #include "state/state.h"
+#include "state/profiler/profiler.h"
+#include <cstring>
 
 namespace state {
 
+namespace {
+
+/**
+ * Mixes a value into a hash
+ */
+void HashCombine(uint64_t &hash, uint64_t value) {
+	const uint64_t multiplier = 0x9e3779b97f4a7c15ULL;
+	hash = (hash ^ value) * multiplier;
+	hash ^= hash >> 29;
+}
+
+/**
+ * Mixes a double into a hash, bit for bit, so that the smallest difference
+ * in a computation changes the hash
+ */
+void HashCombine(uint64_t &hash, double value) {
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	HashCombine(hash, bits);
+}
+
+void HashCombine(uint64_t &hash, physics::Vector vector) {
+	HashCombine(hash, vector.x);
+	HashCombine(hash, vector.y);
+}
+}
+
 State::State() {
 	// Init None
 }
@@ -15,11 +44,34 @@ State::State(std::vector<std::vector<std::unique_ptr<Soldier>>> soldiers,
              std::unique_ptr<IMap> map,
              std::unique_ptr<MoneyManager> money_manager,
              std::vector<std::unique_ptr<TowerManager>> tower_managers,
-             std::unique_ptr<IPathPlanner> path_planner)
+             std::unique_ptr<IPathPlanner> path_planner,
+             std::unique_ptr<ActorIdAllocator> actor_id_allocator)
     : soldiers(std::move(soldiers)), map(std::move(map)),
       money_manager(std::move(money_manager)),
       tower_managers(std::move(tower_managers)),
-      path_planner(std::move(path_planner)) {}
+      path_planner(std::move(path_planner)),
+      actor_id_allocator(std::move(actor_id_allocator)) {
+	for (auto &player_soldiers : this->soldiers) {
+		std::vector<Soldier *> player_soldier_ptrs;
+		for (auto &soldier : player_soldiers) {
+			player_soldier_ptrs.push_back(soldier.get());
+		}
+		this->soldier_ptrs.push_back(player_soldier_ptrs);
+	}
+
+	for (auto &tower_manager : this->tower_managers) {
+		this->tower_ptrs.push_back(tower_manager->GetTowers());
+	}
+
+	for (auto &player_soldiers : this->soldier_ptrs) {
+		SpatialGrid soldier_grid(this->map->GetSize(),
+		                         this->map->GetElementSize());
+		for (auto *soldier : player_soldiers) {
+			soldier_grid.Insert(soldier);
+		}
+		this->soldier_grids.push_back(std::move(soldier_grid));
+	}
+}
 
 Soldier *State::GetSoldierById(ActorId actor_id, PlayerId player_id) {
 	int soldiers_per_team = soldiers[0].size();
@@ -38,37 +90,40 @@ Soldier *State::GetSoldierById(ActorId actor_id, PlayerId player_id) {
 	return soldiers[(int)player_id][index_of_soldier].get();
 }
 
-const std::vector<std::vector<Soldier *>> State::GetAllSoldiers() {
-	std::vector<std::vector<Soldier *>> ret_soldiers;
-	for (int i = 0; i < soldiers.size(); ++i) {
-		std::vector<Soldier *> player_soldiers;
-		for (int j = 0; j < soldiers[i].size(); ++j) {
-			player_soldiers.push_back(soldiers[i][j].get());
-		}
-		ret_soldiers.push_back(player_soldiers);
-	}
-	return ret_soldiers;
+const std::vector<std::vector<Soldier *>> &State::GetAllSoldiers() {
+	return this->soldier_ptrs;
 }
 
-const std::vector<std::vector<Tower *>> State::GetAllTowers() {
-	std::vector<std::vector<Tower *>> ret_towers;
-	for (int i = 0; i < this->tower_managers.size(); ++i) {
-		ret_towers.push_back(this->tower_managers[i]->GetTowers());
-	}
-	return ret_towers;
+const std::vector<std::vector<Tower *>> &State::GetAllTowers() {
+	return this->tower_ptrs;
 }
 
-std::vector<int64_t> State::GetMoney() {
-	std::vector<int64_t> ret_balance;
-	int player_count = static_cast<int>(PlayerId::PLAYER_COUNT);
-	for (int i = 0; i < player_count; ++i) {
-		ret_balance.push_back(money_manager->GetBalance(PlayerId(i)));
-	}
-	return ret_balance;
+const std::vector<int64_t> &State::GetMoney() {
+	return money_manager->GetBalances();
 }
 
 IMap *State::GetMap() { return this->map.get(); }
 
+const std::vector<physics::Vector> &State::GetDirtyMapOffsets() {
+	return this->dirty_map_offsets;
+}
+
+void State::ClearDirtyMapOffsets() { this->dirty_map_offsets.clear(); }
+
+void State::GetSoldiersInRange(PlayerId player_id, physics::Vector position,
+                               double range,
+                               std::vector<Soldier *> &soldiers) {
+	this->soldier_grids[(int)player_id].GetSoldiersInRange(position, range,
+	                                                       soldiers);
+}
+
+void State::GetNearestSoldiers(PlayerId player_id, physics::Vector position,
+                               int64_t count,
+                               std::vector<Soldier *> &soldiers) {
+	this->soldier_grids[(int)player_id].GetNearestSoldiers(position, count,
+	                                                       soldiers);
+}
+
 std::vector<int64_t> State::GetScores() {
 	int num_players = (int)PlayerId::PLAYER_COUNT;
 	std::vector<int64_t> scores(num_players, 0);
@@ -87,6 +142,60 @@ std::vector<int64_t> State::GetScores() {
 	return scores;
 }
 
+uint64_t State::GetHash() {
+	uint64_t hash = 0;
+
+	for (auto &player_soldiers : this->soldier_ptrs) {
+		for (auto *soldier : player_soldiers) {
+			HashCombine(hash, static_cast<uint64_t>(soldier->GetActorId()));
+			HashCombine(hash, static_cast<uint64_t>(soldier->GetHp()));
+			HashCombine(hash, soldier->GetPosition());
+			HashCombine(hash, static_cast<uint64_t>(soldier->GetState()));
+			HashCombine(hash, soldier->GetDestination());
+			int64_t attack_target_id = -1;
+			if (soldier->IsAttackTargetSet()) {
+				attack_target_id = soldier->GetAttackTarget()->GetActorId();
+			}
+			HashCombine(hash, static_cast<uint64_t>(attack_target_id));
+		}
+	}
+
+	for (auto &player_towers : this->tower_ptrs) {
+		// Towers come and go, so each player's list is delimited by its size
+		HashCombine(hash, static_cast<uint64_t>(player_towers.size()));
+		for (auto *tower : player_towers) {
+			HashCombine(hash, static_cast<uint64_t>(tower->GetActorId()));
+			HashCombine(hash, static_cast<uint64_t>(tower->GetHp()));
+			HashCombine(hash, static_cast<uint64_t>(tower->GetTowerLevel()));
+			HashCombine(hash, tower->GetPosition());
+		}
+	}
+
+	for (auto money : this->money_manager->GetBalances()) {
+		HashCombine(hash, static_cast<uint64_t>(money));
+	}
+
+	// One bit per player for each map element, packed a row at a time
+	int num_players = (int)PlayerId::PLAYER_COUNT;
+	for (int i = 0; i < this->map->GetSize(); ++i) {
+		uint64_t row_ownership = 0;
+		for (int j = 0; j < this->map->GetSize(); ++j) {
+			auto &elt = this->map->GetElementByOffset(physics::Vector(i, j));
+			for (int player_id = 0; player_id < num_players; ++player_id) {
+				row_ownership = (row_ownership << 1) |
+				                elt.GetOwnership((PlayerId)player_id);
+			}
+			if ((j + 1) % (64 / num_players) == 0) {
+				HashCombine(hash, row_ownership);
+				row_ownership = 0;
+			}
+		}
+		HashCombine(hash, row_ownership);
+	}
+
+	return hash;
+}
+
 void State::MoveSoldier(PlayerId player_id, int64_t soldier_id,
                         physics::Vector position) {
 	auto soldier = GetSoldierById(soldier_id, player_id);
@@ -127,20 +236,42 @@ void State::SuicideTower(PlayerId player_id, int64_t tower_id) {
 }
 
 void State::Update() {
-	for (auto &tower_manager : this->tower_managers) {
+	PROFILE_START(tower_managers_timer, ProfilePhase::UPDATE_TOWER_MANAGERS);
+	for (int i = 0; i < this->tower_managers.size(); ++i) {
+		auto &tower_manager = this->tower_managers[i];
 		tower_manager->Update();
+
+		// Assigning over the old list reuses its storage
+		this->tower_ptrs[i] = tower_manager->GetTowers();
+
+		auto &tower_dirty_offsets = tower_manager->GetDirtyOffsets();
+		this->dirty_map_offsets.insert(this->dirty_map_offsets.end(),
+		                               tower_dirty_offsets.begin(),
+		                               tower_dirty_offsets.end());
+		tower_manager->ClearDirtyOffsets();
 	}
+	PROFILE_STOP(tower_managers_timer);
 
+	PROFILE_START(soldiers_timer, ProfilePhase::UPDATE_SOLDIERS);
 	for (auto &player_soldiers : this->soldiers) {
 		for (auto &soldier : player_soldiers) {
 			soldier->Update();
 		}
 	}
+	PROFILE_STOP(soldiers_timer);
 
+	PROFILE_SCOPE(ProfilePhase::LATE_UPDATE_SOLDIERS);
 	for (auto &player_soldiers : this->soldiers) {
 		for (auto &soldier : player_soldiers) {
 			soldier->LateUpdate();
 		}
 	}
+
+	// Soldiers have moved or respawned, file them under their new cells
+	for (int i = 0; i < this->soldier_ptrs.size(); ++i) {
+		for (auto *soldier : this->soldier_ptrs[i]) {
+			this->soldier_grids[i].UpdateSoldier(soldier);
+		}
+	}
 }
 }
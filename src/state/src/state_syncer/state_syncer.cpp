@@ -5,246 +5,487 @@
 
 #include "state/state_syncer/state_syncer.h"
 #include "state/actor/soldier_states/soldier_state.h"
+#include "state/profiler/profiler.h"
 #include <algorithm>
 #include <cmath>
 
 namespace state {
 
+namespace {
+
+/**
+ * Returns true for the commands that act on one of the player's towers
+ */
+bool IsTowerCommand(player_state::CommandType command_type) {
+	return command_type == player_state::CommandType::UPGRADE_TOWER ||
+	       command_type == player_state::CommandType::SUICIDE_TOWER;
+}
+
+/**
+ * Returns the actor with the given id, or nullptr if there is none. The
+ * actor is looked for at the index it is expected at first, and the whole
+ * list is searched only if it isn't there
+ */
+template <typename T>
+T *FindActor(const std::vector<T *> &actors, int64_t expected_index,
+             int64_t actor_id) {
+	if (expected_index >= 0 &&
+	    expected_index < static_cast<int64_t>(actors.size()) &&
+	    actors[expected_index]->GetActorId() == actor_id) {
+		return actors[expected_index];
+	}
+
+	auto actor = std::find_if(actors.begin(), actors.end(), [&](T *actor) {
+		return actor->GetActorId() == actor_id;
+	});
+	return actor != actors.end() ? *actor : nullptr;
+}
+}
+
 StateSyncer::StateSyncer(std::unique_ptr<IState> state, logger::ILogger *logger,
                          std::vector<int64_t> tower_build_costs,
                          int64_t max_num_towers)
     : state(std::move(state)), logger(logger),
-      tower_build_costs(tower_build_costs), max_num_towers(max_num_towers) {}
+      tower_build_costs(tower_build_costs), max_num_towers(max_num_towers),
+      synced_player_states(),
+      soldier_cell_counts(MAP_SIZE * MAP_SIZE, 0) {}
 
 void StateSyncer::ExecutePlayerCommands(
     const std::vector<player_state::State *> &player_states,
     const std::vector<bool> &skip_player_commands_flags) {
-	auto state_soldiers = state->GetAllSoldiers();
-	auto state_towers = state->GetAllTowers();
-	auto state_money = state->GetMoney();
-	std::vector<int64_t> razed_towers;
+	PROFILE_SCOPE(ProfilePhase::EXECUTE_PLAYER_COMMANDS);
+	auto &state_towers = state->GetAllTowers();
+
+	// Assigning over the old lists reuses their storage
+	this->player_money = state->GetMoney();
+	this->razed_towers.clear();
+	this->player_commands.resize(player_states.size());
+	this->soldier_command_counts.resize(player_states.size());
+	this->tower_command_counts.resize(player_states.size());
+	this->build_tower_offsets.resize(player_states.size());
+	this->queued_tower_offsets.resize(player_states.size());
 
 	for (int player_id = 0; player_id < player_states.size(); ++player_id) {
+		// Found even when the commands are skipped, so that the writables
+		// are still reset
+		FindBuildTowerOffsets(*player_states[player_id],
+		                      this->build_tower_offsets[player_id]);
+
+		this->queued_tower_offsets[player_id].clear();
+		this->player_commands[player_id].clear();
 		if (skip_player_commands_flags[player_id] == false) {
-			for (int64_t tower_index = 0;
-			     tower_index < state_towers[player_id].size(); ++tower_index) {
-				auto const &tower =
-				    player_states[player_id]->towers[tower_index];
-				if (tower.upgrade_tower == true && tower.suicide == true) {
-					LogErrors(static_cast<PlayerId>(player_id),
-					          logger::ErrorType::NO_MULTIPLE_TOWER_TASKS,
-					          "Tower with id " + std::to_string(tower.id) +
-					              " can perform only one task each turn");
-				} else if (tower.upgrade_tower == true) {
+			ReadPlayerCommands(static_cast<PlayerId>(player_id),
+			                   *player_states[player_id],
+			                   this->player_commands[player_id]);
+		}
+	}
+
+	// Tower commands of every player run before any soldier commands
+	for (int player_id = 0; player_id < player_states.size(); ++player_id) {
+		auto &tower_counts = this->tower_command_counts[player_id];
+		for (auto const &command : this->player_commands[player_id]) {
+			if (!IsTowerCommand(command.type)) {
+				continue;
+			}
+
+			auto const &tower =
+			    player_states[player_id]->towers[command.actor_index];
+			auto &command_count = tower_counts[command.actor_index];
+			if (command_count > 1) {
+				LogErrors(static_cast<PlayerId>(player_id),
+				          logger::ErrorType::NO_MULTIPLE_TOWER_TASKS,
+				          tower.id);
+				command_count = -1;
+			} else if (command_count == 1) {
+				if (command.type == player_state::CommandType::UPGRADE_TOWER) {
 					UpgradeTower(static_cast<PlayerId>(player_id), tower.id,
-					             tower_index, state_money[player_id]);
-				} else if (tower.suicide == true) {
+					             command.actor_index, player_money[player_id]);
+				} else {
 					SuicideTower(static_cast<PlayerId>(player_id), tower.id,
-					             tower_index, razed_towers);
+					             command.actor_index, razed_towers);
 				}
 			}
 		}
 	}
 
+	// Then each player's soldier and build commands, in the order issued
 	for (int player_id = 0; player_id < player_states.size(); ++player_id) {
-		if (skip_player_commands_flags[player_id] == false) {
-			int64_t current_num_towers = state_towers[player_id].size();
-			for (int64_t soldier_index = 0;
-			     soldier_index < state_soldiers[player_id].size();
-			     ++soldier_index) {
-				auto const &soldiers =
-				    player_states[player_id]->soldiers[soldier_index];
-				// A soldier can only either move, attack tower or another
-				// soldier
-				bool is_attacking_tower = soldiers.tower_target != -1;
-				bool is_attacking_soldier = soldiers.soldier_target != -1;
-				bool is_moving =
-				    soldiers.destination != physics::Vector(-1, -1);
-
-				std::vector<bool> flags{is_attacking_soldier, is_moving,
-				                        is_attacking_tower};
-
-				if (std::count(flags.begin(), flags.end(), true) > 1) {
-					LogErrors(static_cast<PlayerId>(player_id),
-					          logger::ErrorType::NO_MULTIPLE_SOLDIER_TASKS,
-					          "Soldier with id " + std::to_string(soldiers.id) +
-					              " can perform only one task each turn");
-				} else {
-					if (is_attacking_tower) {
-						AttackTower(static_cast<PlayerId>(player_id),
-						            soldiers.id, soldiers.tower_target,
-						            soldier_index, razed_towers);
-					} else if (is_attacking_soldier) {
-						AttackSoldier(static_cast<PlayerId>(player_id),
-						              soldiers.id, soldiers.soldier_target,
-						              soldier_index);
-					} else if (is_moving) {
-						MoveSoldier(static_cast<PlayerId>(player_id),
-						            soldiers.id, soldiers.destination,
-						            soldier_index);
-					}
-				}
+		auto &soldier_counts = this->soldier_command_counts[player_id];
+		int64_t current_num_towers = state_towers[player_id].size();
+		for (auto const &command : this->player_commands[player_id]) {
+			if (command.type == player_state::CommandType::BUILD_TOWER) {
+				BuildTower(static_cast<PlayerId>(player_id), command.position,
+				           player_money[player_id], current_num_towers);
+				continue;
+			}
+			if (IsTowerCommand(command.type)) {
+				continue;
 			}
 
-			for (int j = 0; j < player_states[player_id]->map.size(); ++j) {
-				for (int k = 0; k < player_states[player_id]->map[j].size();
-				     ++k) {
-					if (player_states[player_id]->map[j][k].build_tower ==
-					    true) {
-						BuildTower(static_cast<PlayerId>(player_id),
-						           physics::Vector(j, k),
-						           state_money[player_id], current_num_towers);
-					}
+			// A soldier can only either move, attack tower or another soldier
+			auto const &soldier =
+			    player_states[player_id]->soldiers[command.actor_index];
+			auto &command_count = soldier_counts[command.actor_index];
+			if (command_count > 1) {
+				LogErrors(static_cast<PlayerId>(player_id),
+				          logger::ErrorType::NO_MULTIPLE_SOLDIER_TASKS,
+				          soldier.id);
+				command_count = -1;
+			} else if (command_count == 1) {
+				switch (command.type) {
+				case player_state::CommandType::ATTACK_TOWER:
+					AttackTower(static_cast<PlayerId>(player_id), soldier.id,
+					            command.target_id, command.actor_index,
+					            razed_towers);
+					break;
+				case player_state::CommandType::ATTACK_SOLDIER:
+					AttackSoldier(static_cast<PlayerId>(player_id), soldier.id,
+					              command.target_id, command.actor_index);
+					break;
+				default:
+					MoveSoldier(static_cast<PlayerId>(player_id), soldier.id,
+					            command.position, command.actor_index);
+					break;
 				}
 			}
 		}
 	}
+
+	// Leave the counts at 0 for the next turn
+	for (int player_id = 0; player_id < player_states.size(); ++player_id) {
+		for (auto const &command : this->player_commands[player_id]) {
+			if (IsTowerCommand(command.type)) {
+				this->tower_command_counts[player_id][command.actor_index] = 0;
+			} else if (command.type !=
+			           player_state::CommandType::BUILD_TOWER) {
+				this->soldier_command_counts[player_id][command.actor_index] =
+				    0;
+			}
+		}
+	}
 }
 
-void StateSyncer::UpdateMainState() { state->Update(); }
+void StateSyncer::ReadPlayerCommands(
+    PlayerId player_id, const player_state::State &player_state,
+    std::vector<player_state::Command> &commands) {
+	auto &buffer = player_state.command_buffer;
+	int64_t num_commands = std::min(
+	    std::max(buffer.num_commands, static_cast<int64_t>(0)),
+	    MAX_NUM_COMMANDS);
+
+	// Players that issued no commands have their writables read instead
+	if (num_commands == 0) {
+		AppendWritableCommands(player_id, player_state, commands);
+	} else {
+		commands.assign(buffer.commands.begin(),
+		                buffer.commands.begin() + num_commands);
+	}
+
+	if (buffer.has_dropped_commands) {
+		LogErrors(player_id, logger::ErrorType::NO_MORE_COMMANDS);
+	}
+
+	// Drop commands for actors the player doesn't have, and count the
+	// commands each actor was given
+	int64_t num_soldiers =
+	    state->GetAllSoldiers()[static_cast<int>(player_id)].size();
+	int64_t num_towers =
+	    state->GetAllTowers()[static_cast<int>(player_id)].size();
+	auto &soldier_counts =
+	    this->soldier_command_counts[static_cast<int>(player_id)];
+	auto &tower_counts =
+	    this->tower_command_counts[static_cast<int>(player_id)];
+	soldier_counts.resize(std::max<size_t>(soldier_counts.size(), num_soldiers),
+	                      0);
+	tower_counts.resize(std::max<size_t>(tower_counts.size(), num_towers), 0);
+
+	int64_t num_valid_commands = 0;
+	for (int64_t i = 0; i < commands.size(); ++i) {
+		auto const &command = commands[i];
+		bool is_valid = false;
+		switch (command.type) {
+		case player_state::CommandType::MOVE_SOLDIER:
+		case player_state::CommandType::ATTACK_SOLDIER:
+		case player_state::CommandType::ATTACK_TOWER:
+			is_valid = command.actor_index >= 0 &&
+			           command.actor_index < num_soldiers;
+			if (is_valid) {
+				++soldier_counts[command.actor_index];
+			}
+			break;
+		case player_state::CommandType::UPGRADE_TOWER:
+		case player_state::CommandType::SUICIDE_TOWER:
+			is_valid =
+			    command.actor_index >= 0 && command.actor_index < num_towers;
+			if (is_valid) {
+				++tower_counts[command.actor_index];
+			}
+			break;
+		case player_state::CommandType::BUILD_TOWER:
+			is_valid = true;
+			break;
+		}
 
-void StateSyncer::UpdatePlayerStates(
-    std::vector<player_state::State *> &player_states) {
+		if (is_valid) {
+			commands[num_valid_commands++] = command;
+		} else {
+			LogErrors(player_id, logger::ErrorType::INVALID_COMMAND, -1, i);
+		}
+	}
+	commands.resize(num_valid_commands);
+}
 
-	auto state_soldiers = state->GetAllSoldiers();
-	auto state_towers = state->GetAllTowers();
-	auto *map = state->GetMap();
-	auto state_money = state->GetMoney();
+void StateSyncer::AppendWritableCommands(
+    PlayerId player_id, const player_state::State &player_state,
+    std::vector<player_state::Command> &commands) {
+	const physics::Vector no_position(-1, -1);
+	int64_t num_towers =
+	    state->GetAllTowers()[static_cast<int>(player_id)].size();
+	int64_t num_soldiers =
+	    state->GetAllSoldiers()[static_cast<int>(player_id)].size();
+
+	for (int64_t tower_index = 0; tower_index < num_towers; ++tower_index) {
+		auto const &tower = player_state.towers[tower_index];
+		if (tower.upgrade_tower == true) {
+			commands.push_back({player_state::CommandType::UPGRADE_TOWER,
+			                    tower_index, -1, no_position});
+		}
+		if (tower.suicide == true) {
+			commands.push_back({player_state::CommandType::SUICIDE_TOWER,
+			                    tower_index, -1, no_position});
+		}
+	}
 
-	// Assigning values from map of state to map of player_state
-	std::vector<std::vector<player_state::MapElement>> player_map;
+	for (int64_t soldier_index = 0; soldier_index < num_soldiers;
+	     ++soldier_index) {
+		auto const &soldier = player_state.soldiers[soldier_index];
+		if (soldier.tower_target != -1) {
+			commands.push_back({player_state::CommandType::ATTACK_TOWER,
+			                    soldier_index, soldier.tower_target,
+			                    no_position});
+		}
+		if (soldier.soldier_target != -1) {
+			commands.push_back({player_state::CommandType::ATTACK_SOLDIER,
+			                    soldier_index, soldier.soldier_target,
+			                    no_position});
+		}
+		if (soldier.destination != no_position) {
+			commands.push_back({player_state::CommandType::MOVE_SOLDIER,
+			                    soldier_index, -1, soldier.destination});
+		}
+	}
 
-	for (int i = 0; i < map->GetSize(); ++i) {
-		std::vector<player_state::MapElement> map_element_vector;
-		for (int j = 0; j < map->GetSize(); ++j) {
-			// Init map properties from state
-			player_state::MapElement map_element;
-			state::MapElement state_map_element =
-			    map->GetElementByOffset(physics::Vector(i, j));
+	for (auto const &offset :
+	     this->build_tower_offsets[static_cast<int>(player_id)]) {
+		commands.push_back(
+		    {player_state::CommandType::BUILD_TOWER, -1, -1, offset});
+	}
+}
 
-			auto ownerships = state_map_element.GetOwnership();
-			map_element.territory = ownerships[0];
-			map_element.enemy_territory = ownerships[1];
+void StateSyncer::FindBuildTowerOffsets(
+    const player_state::State &player_state,
+    std::vector<physics::Vector> &offsets) {
+	auto &buffer = player_state.command_buffer;
+	int64_t map_size = player_state.map.size();
+	offsets.clear();
+
+	if (buffer.num_commands > 0) {
+		int64_t num_commands = std::min(buffer.num_commands, MAX_NUM_COMMANDS);
+		for (int64_t i = 0; i < num_commands; ++i) {
+			auto const &command = buffer.commands[i];
+			if (command.type != player_state::CommandType::BUILD_TOWER ||
+			    !std::isfinite(command.position.x) ||
+			    !std::isfinite(command.position.y)) {
+				continue;
+			}
 
-			// Init map writables to default value
-			map_element.build_tower = false;
+			auto offset = command.position.floor();
+			if (offset.x >= 0 && offset.x < map_size && offset.y >= 0 &&
+			    offset.y < map_size) {
+				offsets.push_back(offset);
+			}
+		}
+		return;
+	}
 
-			map_element_vector.push_back(map_element);
+	for (size_t j = 0; j < player_state.map.size(); ++j) {
+		for (size_t k = 0; k < player_state.map[j].size(); ++k) {
+			if (player_state.map[j][k].build_tower == true) {
+				offsets.emplace_back(j, k);
+			}
 		}
-		player_map.push_back(map_element_vector);
 	}
+}
 
-	for (int player_id = 0; player_id < player_states.size(); ++player_id) {
+void StateSyncer::AssignSoldierGrid(
+    const std::array<player_state::Soldier, NUM_SOLDIERS> &soldiers,
+    int64_t num_soldiers, player_state::SoldierGrid &grid) {
+	auto &cell_starts = grid.cell_starts;
+	auto &cell_counts = this->soldier_cell_counts;
+
+	// Count the soldiers in each cell, noting each soldier's place in its
+	// cell as it is counted
+	std::array<int64_t, NUM_SOLDIERS> soldier_cells;
+	std::array<int64_t, NUM_SOLDIERS> soldier_slots;
+	for (int64_t i = 0; i < num_soldiers; ++i) {
+		soldier_cells[i] =
+		    player_state::GetSoldierGridCell(soldiers[i].position);
+		soldier_slots[i] = cell_counts[soldier_cells[i]]++;
+	}
+
+	// The player may read any cell, so every start is written. This is the
+	// one pass over all the cells
+	int64_t num_cells = cell_counts.size();
+	int64_t cell_start = 0;
+	for (int64_t cell = 0; cell < num_cells; ++cell) {
+		cell_starts[cell] = cell_start;
+		cell_start += cell_counts[cell];
+	}
+	cell_starts[num_cells] = cell_start;
+
+	// Place each soldier, and clear the count of its cell for the next grid
+	for (int64_t i = 0; i < num_soldiers; ++i) {
+		auto cell = soldier_cells[i];
+		grid.soldier_indices[cell_starts[cell] + soldier_slots[i]] = i;
+		cell_counts[cell] = 0;
+	}
+}
 
-		// Flips map for the second player so they are on left bottom corner
-		if (static_cast<PlayerId>(player_id) == PlayerId::PLAYER2) {
-			FlipMap(player_map);
-		}
+void StateSyncer::UpdateMainState() { state->Update(); }
+
+void StateSyncer::UpdatePlayerStates(
+    std::vector<player_state::State *> &player_states) {
+	PROFILE_START(player_states_timer, ProfilePhase::UPDATE_PLAYER_STATES);
+
+	auto &state_soldiers = state->GetAllSoldiers();
+	auto &state_towers = state->GetAllTowers();
+	auto *map = state->GetMap();
+	auto &state_money = state->GetMoney();
+	int64_t map_size = map->GetSize();
+
+	this->tower_offsets.resize(player_states.size());
+	this->synced_player_states.resize(player_states.size(), nullptr);
+
+	for (int player_id = 0; player_id < player_states.size(); ++player_id) {
+		auto *player_state = player_states[player_id];
 
 		int64_t enemy_id =
 		    (player_id + 1) % static_cast<int>(PlayerId::PLAYER_COUNT);
 
-		AssignTowerAttributes(player_id, player_states[player_id]->towers,
-		                      false);
-		AssignTowerAttributes(enemy_id, player_states[player_id]->enemy_towers,
-		                      true);
-
-		AssignSoldierAttributes(player_id, player_states[player_id]->soldiers,
-		                        false);
-		AssignSoldierAttributes(enemy_id,
-		                        player_states[player_id]->enemy_soldiers, true);
-
-		player_states[player_id]->num_towers = state_towers[player_id].size();
-		player_states[player_id]->num_enemy_towers =
-		    state_towers[enemy_id].size();
-
-		// Checks if map element is valid for building tower and assigns
-		// bool value
-		for (auto &player_map_row : player_map) {
-			for (auto &player_map_element : player_map_row) {
-				player_map_element.valid_territory = true;
-				if (player_map_element.territory == false ||
-				    player_map_element.enemy_territory == true) {
-					player_map_element.valid_territory = false;
-					continue;
-				}
+		AssignTowerAttributes(player_id, state_towers[player_id],
+		                      player_state->towers, false);
+		AssignTowerAttributes(enemy_id, state_towers[enemy_id],
+		                      player_state->enemy_towers, true);
+
+		AssignSoldierAttributes(player_id, state_soldiers[player_id],
+		                        player_state->soldiers, false);
+		AssignSoldierAttributes(enemy_id, state_soldiers[enemy_id],
+		                        player_state->enemy_soldiers, true);
+
+		AssignSoldierGrid(player_state->soldiers,
+		                  state_soldiers[player_id].size(),
+		                  player_state->soldier_grid);
+		AssignSoldierGrid(player_state->enemy_soldiers,
+		                  state_soldiers[enemy_id].size(),
+		                  player_state->enemy_soldier_grid);
+
+		player_state->num_towers = state_towers[player_id].size();
+		player_state->num_enemy_towers = state_towers[enemy_id].size();
+
+		// Reset the build_tower writables the player set last turn
+		if (static_cast<size_t>(player_id) < this->build_tower_offsets.size()) {
+			for (auto &offset : this->build_tower_offsets[player_id]) {
+				player_state->map[offset.x][offset.y].build_tower = false;
 			}
+			this->build_tower_offsets[player_id].clear();
 		}
-		// If tower is already present, it is not valid territory
-		for (auto &player_tower : state_towers[player_id]) {
-			int64_t x, y;
-			physics::Vector position;
-			if (static_cast<PlayerId>(player_id) == PlayerId::PLAYER1) {
-				position = player_tower->GetPosition();
-			} else {
-				position = FlipPosition(map, player_tower->GetPosition());
-			}
-			physics::Vector offset_position =
-			    (position / map->GetElementSize()).floor();
-			player_map[offset_position.x][offset_position.y].valid_territory =
-			    false;
+
+		// Find the offsets of the player's towers, keeping the old ones
+		auto &player_tower_offsets = this->tower_offsets[player_id];
+		std::swap(player_tower_offsets, this->old_tower_offsets);
+		player_tower_offsets.clear();
+		for (auto *player_tower : state_towers[player_id]) {
+			player_tower_offsets.push_back(
+			    (player_tower->GetPosition() / map->GetElementSize()).floor());
 		}
 
-		// Assigns map taken from state to player state map
-		if (player_id == static_cast<int>(PlayerId::PLAYER_COUNT) - 1) {
-			for (int i = 0; i < player_map.size(); ++i) {
-				std::move(player_map[i].begin(), player_map[i].end(),
-				          player_states[player_id]->map[i].begin());
+		if (this->synced_player_states[player_id] != player_state) {
+			for (int i = 0; i < map_size; ++i) {
+				for (int j = 0; j < map_size; ++j) {
+					UpdatePlayerMapElement(player_id, physics::Vector(i, j),
+					                       player_state);
+				}
 			}
 		} else {
-			for (int i = 0; i < player_map.size(); ++i) {
-				std::copy(player_map[i].begin(), player_map[i].end(),
-				          player_states[player_id]->map[i].begin());
+			// Ownership changes affect territory of both players
+			for (auto &offset : state->GetDirtyMapOffsets()) {
+				UpdatePlayerMapElement(player_id, offset, player_state);
+			}
+
+			// Elements where towers were built or destroyed change validity
+			for (auto &offset : this->old_tower_offsets) {
+				UpdatePlayerMapElement(player_id, offset, player_state);
+			}
+			for (auto &offset : player_tower_offsets) {
+				UpdatePlayerMapElement(player_id, offset, player_state);
 			}
 		}
+
 		// Assigns money taken from state to player state's state_money
-		player_states[player_id]->money = std::move(state_money[player_id]);
+		player_state->money = state_money[player_id];
+
+		// Clear the commands the player issued last turn
+		player_state->command_buffer.num_commands = 0;
+		player_state->command_buffer.has_dropped_commands = false;
 	}
 
+	this->synced_player_states = player_states;
+	state->ClearDirtyMapOffsets();
+	PROFILE_STOP(player_states_timer);
+
 	// This turn is now over, update the logs
+	PROFILE_SCOPE(ProfilePhase::LOG_STATE);
 	logger->LogState(state.get());
 }
 
 void StateSyncer::AssignTowerAttributes(
-    int64_t id, std::array<player_state::Tower, MAX_NUM_TOWERS> &towers,
-    bool is_enemy) {
-	auto state_towers = state->GetAllTowers();
+    int64_t id, const std::vector<Tower *> &state_towers,
+    std::array<player_state::Tower, MAX_NUM_TOWERS> &towers, bool is_enemy) {
 	auto *map = state->GetMap();
 	int64_t player_id = id;
-	for (int i = 0; i < state_towers[id].size(); ++i) {
+	for (int i = 0; i < state_towers.size(); ++i) {
 		// Reassigns id to all the towers
-		towers[i].id = state_towers[id][i]->GetActorId();
+		towers[i].id = state_towers[i]->GetActorId();
 
 		// Init tower writables to default value
 		towers[i].suicide = false;
 		towers[i].upgrade_tower = false;
 
 		// Init tower properties from state
-		towers[i].hp = state_towers[id][i]->GetHp();
-		towers[i].level = state_towers[id][i]->GetTowerLevel();
+		towers[i].hp = state_towers[i]->GetHp();
+		towers[i].level = state_towers[i]->GetTowerLevel();
 		if (is_enemy) {
 			player_id = ((id + 1) % static_cast<int>(PlayerId::PLAYER_COUNT));
 		}
 
 		if (static_cast<PlayerId>(player_id) == PlayerId::PLAYER1)
-			towers[i].position = state_towers[id][i]->GetPosition();
+			towers[i].position = state_towers[i]->GetPosition();
 		else {
 			towers[i].position =
-			    FlipPosition(map, state_towers[id][i]->GetPosition());
+			    FlipPosition(map, state_towers[i]->GetPosition());
 		}
 	}
 }
 
 void StateSyncer::AssignSoldierAttributes(
-    int64_t id, std::array<player_state::Soldier, NUM_SOLDIERS> &soldiers,
-    bool is_enemy) {
-	auto state_soldiers = state->GetAllSoldiers();
+    int64_t id, const std::vector<Soldier *> &state_soldiers,
+    std::array<player_state::Soldier, NUM_SOLDIERS> &soldiers, bool is_enemy) {
 	auto *map = state->GetMap();
 	int64_t player_id = id;
 
-	for (int i = 0; i < state_soldiers[player_id].size(); ++i) {
+	for (int i = 0; i < state_soldiers.size(); ++i) {
 		// Reassigns id to all the soldiers
-		soldiers[i].id = state_soldiers[id][i]->GetActorId();
+		soldiers[i].id = state_soldiers[i]->GetActorId();
 
 		// Init targets to default value
 		soldiers[i].tower_target = -1;
@@ -252,8 +493,8 @@ void StateSyncer::AssignSoldierAttributes(
 		soldiers[i].destination = physics::Vector(-1, -1);
 
 		// Init soldier properties from state
-		soldiers[i].hp = state_soldiers[id][i]->GetHp();
-		switch (state_soldiers[id][i]->GetState()) {
+		soldiers[i].hp = state_soldiers[i]->GetHp();
+		switch (state_soldiers[i]->GetState()) {
 		case SoldierStateName::ATTACK:
 			soldiers[i].state = player_state::SoldierState::ATTACK;
 			break;
@@ -271,51 +512,53 @@ void StateSyncer::AssignSoldierAttributes(
 			break;
 		}
 
-		soldiers[i].is_immune = state_soldiers[id][i]->IsInvulnerable();
+		soldiers[i].is_immune = state_soldiers[i]->IsInvulnerable();
 
 		if (is_enemy) {
 			player_id = ((id + 1) % static_cast<int>(PlayerId::PLAYER_COUNT));
 		}
 
 		if (static_cast<PlayerId>(player_id) == PlayerId::PLAYER1)
-			soldiers[i].position = state_soldiers[id][i]->GetPosition();
+			soldiers[i].position = state_soldiers[i]->GetPosition();
 		else {
 			soldiers[i].position =
-			    FlipPosition(map, state_soldiers[id][i]->GetPosition());
+			    FlipPosition(map, state_soldiers[i]->GetPosition());
 		}
 	}
 }
 
-void StateSyncer::FlipMap(
-    std::vector<std::vector<player_state::MapElement>> &player_map) {
-	int64_t map_size = player_map.size();
-	for (int i = 0; i < map_size / 2; ++i) {
-		for (int j = 0; j < player_map[i].size(); ++j) {
-			// Swap territory for Player2
-			std::swap(player_map[i][j].territory,
-			          player_map[i][j].enemy_territory);
-			std::swap(
-			    player_map[map_size - 1 - i][map_size - 1 - j].territory,
-			    player_map[map_size - 1 - i][map_size - 1 - j].enemy_territory);
-
-			std::swap(player_map[i][j],
-			          player_map[map_size - 1 - i][map_size - 1 - j]);
-		}
-	}
-	if (map_size % 2) {
-		int64_t i = map_size / 2;
-		for (int j = 0; j < map_size / 2; ++j) {
-			// Swap territory for Player2
-			std::swap(player_map[i][j].territory,
-			          player_map[i][j].enemy_territory);
-			std::swap(
-			    player_map[map_size - 1 - i][map_size - 1 - j].territory,
-			    player_map[map_size - 1 - i][map_size - 1 - j].enemy_territory);
-
-			std::swap(player_map[i][j],
-			          player_map[map_size - 1 - i][map_size - 1 - j]);
-		}
+void StateSyncer::UpdatePlayerMapElement(int64_t player_id,
+                                         physics::Vector offset,
+                                         player_state::State *player_state) {
+	auto *map = state->GetMap();
+	auto &map_element = map->GetElementByOffset(offset);
+	int64_t enemy_id =
+	    (player_id + 1) % static_cast<int>(PlayerId::PLAYER_COUNT);
+
+	bool territory = map_element.GetOwnership(static_cast<PlayerId>(player_id));
+	bool enemy_territory =
+	    map_element.GetOwnership(static_cast<PlayerId>(enemy_id));
+
+	// If tower is already present, it is not valid territory
+	auto &player_tower_offsets = this->tower_offsets[player_id];
+	bool has_tower = std::find(player_tower_offsets.begin(),
+	                           player_tower_offsets.end(),
+	                           offset) != player_tower_offsets.end();
+
+	// Flips map for the second player so they are on left bottom corner
+	if (static_cast<PlayerId>(player_id) == PlayerId::PLAYER2) {
+		offset = physics::Vector(map->GetSize() - 1 - offset.x,
+		                         map->GetSize() - 1 - offset.y);
 	}
+
+	auto &player_map_element = player_state->map[offset.x][offset.y];
+	player_map_element.territory = territory;
+	player_map_element.enemy_territory = enemy_territory;
+	player_map_element.valid_territory =
+	    territory && !enemy_territory && !has_tower;
+
+	// Init map writables to default value
+	player_map_element.build_tower = false;
 }
 
 physics::Vector StateSyncer::FlipPosition(state::IMap *map,
@@ -326,14 +569,14 @@ physics::Vector StateSyncer::FlipPosition(state::IMap *map,
 }
 
 void StateSyncer::LogErrors(PlayerId player_id, logger::ErrorType error_type,
-                            std::string message) {
-	logger->LogError(player_id, error_type, message);
+                            int64_t actor_id, int64_t arg) {
+	logger->LogError(player_id, error_type, actor_id, arg);
 }
 
 void StateSyncer::MoveSoldier(PlayerId player_id, int64_t soldier_id,
                               physics::Vector position, int64_t soldier_index) {
 	auto *map = state->GetMap();
-	auto state_soldiers = state->GetAllSoldiers();
+	auto &state_soldiers = state->GetAllSoldiers();
 
 	// Flip position for Player2
 	if (player_id == PlayerId::PLAYER2)
@@ -343,35 +586,32 @@ void StateSyncer::MoveSoldier(PlayerId player_id, int64_t soldier_id,
 	if (soldier_id !=
 	    state_soldiers[static_cast<int>(player_id)][soldier_index]
 	        ->GetActorId()) {
-		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID,
-		          "Do not alter id of actors");
+		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID);
 		return;
 	}
 
 	// Check is soldier is alive to act
 	if (state_soldiers[static_cast<int>(player_id)][soldier_index]->GetHp() ==
 	    0) {
-		LogErrors(
-		    player_id, logger::ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
-		    "Soldier with id " +
-		        std::to_string(
-		            state_soldiers[static_cast<int>(player_id)][soldier_index]
-		                .id) +
-		        " must be alive in order to act");
+		LogErrors(player_id, logger::ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
+		          soldier_id);
 		return;
 	}
 
-	// Check if position is valid
-	if (position.x < 0 ||
+	// Check if position is valid. Positions come from the player, so they
+	// may not even be finite
+	if (!std::isfinite(position.x) || !std::isfinite(position.y) ||
+	    position.x < 0 ||
 	    position.x >= map->GetSize() * map->GetElementSize() ||
 	    position.y < 0 ||
 	    position.y >= map->GetSize() * map->GetElementSize()) {
-		LogErrors(player_id, logger::ErrorType::INVALID_POSITION,
-		          "Position (" + std::to_string(position.x) + "," +
-		              std::to_string(position.y) + ") not in map");
+		LogErrors(player_id, logger::ErrorType::INVALID_POSITION, soldier_id,
+		          logger::PackErrorPosition(position));
 		return;
 	}
 
+	logger->LogCommand(player_id, logger::CommandType::MOVE_SOLDIER,
+	                   soldier_id, -1, position);
 	state->MoveSoldier(player_id, soldier_id, position);
 }
 
@@ -381,59 +621,55 @@ void StateSyncer::AttackTower(PlayerId player_id, int64_t soldier_id,
 	bool valid_target = false;
 	int64_t enemy_id = (static_cast<int>(player_id) + 1) %
 	                   static_cast<int>(PlayerId::PLAYER_COUNT);
-	auto state_soldiers = state->GetAllSoldiers();
+	auto &state_soldiers = state->GetAllSoldiers();
 
 	// Check if id has been altered
 	if (soldier_id !=
 	    state_soldiers[static_cast<int>(player_id)][soldier_index]
 	        ->GetActorId()) {
-		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID,
-		          "Do not alter id of actors");
+		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID);
 		return;
 	}
 
 	// Check is soldier is alive to act
 	if (state_soldiers[static_cast<int>(player_id)][soldier_index]->GetHp() ==
 	    0) {
-		LogErrors(
-		    player_id, logger::ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
-		    "Soldier with id " +
-		        std::to_string(
-		            state_soldiers[static_cast<int>(player_id)][soldier_index]
-		                .id) +
-		        " must be alive in order to act");
+		LogErrors(player_id, logger::ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
+		          soldier_id);
 		return;
 	}
 
-	std::vector<Tower *> enemy_towers = state->GetAllTowers()[enemy_id];
-
-	// Check if target  is valid
-	for (int i = 0; i < enemy_towers.size(); ++i) {
-		// Check if enemy actor id is correct id
-		if (tower_id == enemy_towers[i]->GetActorId()) {
-			if (enemy_towers[i]->GetIsBase()) {
-				LogErrors(player_id, logger::ErrorType::NO_ATTACK_BASE_TOWER,
-				          "Cannot attack Base Tower of enemy");
-				return;
-			}
+	auto &enemy_towers = state->GetAllTowers()[enemy_id];
 
-			valid_target = true;
+	// Check if target is valid. Towers are kept in the order they were
+	// built in, so they are usually sorted by id
+	auto expected_tower = std::lower_bound(
+	    enemy_towers.begin(), enemy_towers.end(), tower_id,
+	    [](Tower *tower, int64_t id) { return tower->GetActorId() < id; });
+	auto *enemy_tower = FindActor(
+	    enemy_towers, expected_tower - enemy_towers.begin(), tower_id);
+	if (enemy_tower != nullptr) {
+		if (enemy_tower->GetIsBase()) {
+			LogErrors(player_id, logger::ErrorType::NO_ATTACK_BASE_TOWER);
+			return;
 		}
+
+		valid_target = true;
 	}
 	if (!valid_target) {
-		LogErrors(player_id, logger::ErrorType::NO_ATTACK_SELF_TOWER,
-		          "Attack enemy's tower only");
+		LogErrors(player_id, logger::ErrorType::NO_ATTACK_SELF_TOWER);
 		return;
 	}
 
 	if (find(razed_towers.begin(), razed_towers.end(), tower_id) !=
 	    razed_towers.end()) {
-		LogErrors(player_id, logger::ErrorType::NO_ATTACK_RAZED_TOWER,
-		          "Can't attack tower with id " + std::to_string(tower_id) +
-		              " as it has been destroyed by the opponent");
+		LogErrors(player_id, logger::ErrorType::NO_ATTACK_RAZED_TOWER, -1,
+		          tower_id);
 		return;
 	}
 
+	logger->LogCommand(player_id, logger::CommandType::ATTACK_ACTOR,
+	                   soldier_id, tower_id, physics::Vector(-1, -1));
 	state->AttackActor(player_id, soldier_id, tower_id);
 }
 
@@ -445,68 +681,59 @@ void StateSyncer::AttackSoldier(PlayerId player_id, int64_t soldier_id,
 	bool enemy_immune = false;
 	int64_t enemy_id = (static_cast<int>(player_id) + 1) %
 	                   static_cast<int>(PlayerId::PLAYER_COUNT);
-	auto state_soldiers = state->GetAllSoldiers();
-	std::vector<Soldier *> enemy_soldiers = state->GetAllSoldiers()[enemy_id];
+	auto &state_soldiers = state->GetAllSoldiers();
+	auto &enemy_soldiers = state_soldiers[enemy_id];
 
 	// Check if id has been altered
 	if (soldier_id !=
 	    state_soldiers[static_cast<int>(player_id)][soldier_index]
 	        ->GetActorId()) {
-		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID,
-		          "Do not alter id of actors");
+		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID);
 		return;
 	}
 
 	// Check if soldier is alive to act
 	if (state_soldiers[static_cast<int>(player_id)][soldier_index]->GetHp() ==
 	    0) {
-		LogErrors(
-		    player_id, logger::ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
-		    "Soldier with id " +
-		        std::to_string(
-		            state_soldiers[static_cast<int>(player_id)][soldier_index]
-		                .id) +
-		        " must be alive in order to act");
+		LogErrors(player_id, logger::ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
+		          soldier_id);
 		return;
 	}
 
-	// Check if enemy actor id is correct id
-	for (int i = 0; i < enemy_soldiers.size(); ++i) {
-		if (enemy_soldier_id == enemy_soldiers[i]->GetActorId()) {
-			valid_target = true;
-			// Check if enemy soldier is alive.
-			if (enemy_soldiers[i]->GetHp() != 0)
-				enemy_alive = true;
-			// Check if enemy soldier is invulnerable
-			if (enemy_soldiers[i]->IsInvulnerable())
-				enemy_immune = true;
-		}
+	// Check if enemy actor id is correct id. Soldiers of a player are
+	// usually given consecutive ids, so the id gives the index directly
+	int64_t expected_index =
+	    enemy_soldiers.empty()
+	        ? -1
+	        : enemy_soldier_id - enemy_soldiers.front()->GetActorId();
+	auto *enemy_soldier =
+	    FindActor(enemy_soldiers, expected_index, enemy_soldier_id);
+	if (enemy_soldier != nullptr) {
+		valid_target = true;
+		// Check if enemy soldier is alive.
+		if (enemy_soldier->GetHp() != 0)
+			enemy_alive = true;
+		// Check if enemy soldier is invulnerable
+		if (enemy_soldier->IsInvulnerable())
+			enemy_immune = true;
 	}
 
 	if (!valid_target) {
-		LogErrors(player_id, logger::ErrorType::NO_ATTACK_SELF_SOLDIER,
-		          "Attack enemy's soldier only");
+		LogErrors(player_id, logger::ErrorType::NO_ATTACK_SELF_SOLDIER);
 		return;
 	}
 	if (!enemy_alive) {
-		LogErrors(
-		    player_id, logger::ErrorType::NO_ATTACK_DEAD_SOLDIER,
-		    "Enemy soldier with id " +
-		        std::to_string(
-		            state_soldiers[static_cast<int>(player_id)][soldier_index]
-		                .id) +
-		        " must be alive to attack it");
+		LogErrors(player_id, logger::ErrorType::NO_ATTACK_DEAD_SOLDIER, -1,
+		          enemy_soldier_id);
 		return;
 	}
 	if (enemy_immune) {
-		LogErrors(
-		    player_id, logger::ErrorType::NO_ATTACK_IMMUNE_SOLDIER,
-		    "Cannot damage invulnerable soldier with id " +
-		        std::to_string(
-		            state_soldiers[static_cast<int>(player_id)][soldier_index]
-		                .id));
+		LogErrors(player_id, logger::ErrorType::NO_ATTACK_IMMUNE_SOLDIER, -1,
+		          enemy_soldier_id);
 	}
 
+	logger->LogCommand(player_id, logger::CommandType::ATTACK_ACTOR,
+	                   soldier_id, enemy_soldier_id, physics::Vector(-1, -1));
 	state->AttackActor(player_id, soldier_id, enemy_soldier_id);
 }
 
@@ -514,14 +741,26 @@ void StateSyncer::BuildTower(PlayerId player_id, physics::Vector offset,
                              int64_t &player_money, int64_t &num_towers) {
 	// Check for max limit of towers
 	if (num_towers + 1 > max_num_towers) {
-		LogErrors(player_id, logger::ErrorType::NO_MORE_TOWERS,
-		          "No more towers can be built. Max limit reached.");
+		LogErrors(player_id, logger::ErrorType::NO_MORE_TOWERS);
 		return;
 	}
 
 	bool valid_territory = true;
 	auto *map = state->GetMap();
-	auto state_towers = state->GetAllTowers();
+	auto &state_towers = state->GetAllTowers();
+
+	// Offsets off the map are never valid territory. Offsets come from the
+	// player, so they may not even be finite
+	if (!std::isfinite(offset.x) || !std::isfinite(offset.y)) {
+		LogErrors(player_id, logger::ErrorType::INVALID_TERRITORY);
+		return;
+	}
+	offset = offset.floor();
+	if (offset.x < 0 || offset.x >= map->GetSize() || offset.y < 0 ||
+	    offset.y >= map->GetSize()) {
+		LogErrors(player_id, logger::ErrorType::INVALID_TERRITORY);
+		return;
+	}
 
 	// Flip position for Player2
 	if (player_id == PlayerId::PLAYER2) {
@@ -529,12 +768,12 @@ void StateSyncer::BuildTower(PlayerId player_id, physics::Vector offset,
 		offset.y = map->GetSize() - 1 - offset.y;
 	}
 
-	auto tower_element = map->GetElementByOffset(offset);
+	auto &tower_element = map->GetElementByOffset(offset);
 
-	if (tower_element.GetOwnership()[static_cast<int>(player_id)] == false)
+	if (tower_element.GetOwnership(player_id) == false)
 		valid_territory = false;
-	for (int i = 0; i < tower_element.GetOwnership().size(); ++i) {
-		if (tower_element.GetOwnership()[i] == true &&
+	for (int i = 0; i < static_cast<int>(PlayerId::PLAYER_COUNT); ++i) {
+		if (tower_element.GetOwnership(static_cast<PlayerId>(i)) == true &&
 		    i != static_cast<int>(player_id)) {
 			valid_territory = false;
 		}
@@ -545,34 +784,41 @@ void StateSyncer::BuildTower(PlayerId player_id, physics::Vector offset,
 		    offset)
 			valid_territory = false;
 	}
+	// Nor is an element a tower was already built on this turn
+	auto &queued_offsets =
+	    this->queued_tower_offsets[static_cast<int>(player_id)];
+	if (std::find(queued_offsets.begin(), queued_offsets.end(), offset) !=
+	    queued_offsets.end()) {
+		valid_territory = false;
+	}
 
 	if (!valid_territory) {
-		LogErrors(player_id, logger::ErrorType::INVALID_TERRITORY,
-		          "Tower can be built only on valid territory.");
+		LogErrors(player_id, logger::ErrorType::INVALID_TERRITORY);
 		return;
 	}
 
 	// Check if player has sufficient balance
 	int64_t tower_cost = tower_build_costs[0];
 	if (player_money < tower_cost) {
-		LogErrors(player_id, logger::ErrorType::INSUFFICIENT_FUNDS,
-		          "Insufficient funds to build tower");
+		LogErrors(player_id, logger::ErrorType::INSUFFICIENT_FUNDS);
 		return;
 	}
 
 	player_money = player_money - tower_cost;
 	num_towers = num_towers + 1;
+	queued_offsets.push_back(offset);
+	logger->LogCommand(player_id, logger::CommandType::BUILD_TOWER, -1, -1,
+	                   offset);
 	state->BuildTower(player_id, offset);
 }
 
 void StateSyncer::UpgradeTower(PlayerId player_id, int64_t tower_id,
                                int64_t tower_index, int64_t &player_money) {
-	auto state_towers = state->GetAllTowers();
+	auto &state_towers = state->GetAllTowers();
 	// Check if id has been altered.
 	if (tower_id !=
 	    state_towers[static_cast<int>(player_id)][tower_index]->GetActorId()) {
-		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID,
-		          "Do not alter id of actors");
+		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID);
 		return;
 	}
 
@@ -581,44 +827,42 @@ void StateSyncer::UpgradeTower(PlayerId player_id, int64_t tower_id,
 	    state_towers[static_cast<int>(player_id)][tower_index]
 	        ->GetTowerLevel());
 	if (current_tower_level == tower_build_costs.size()) {
-		LogErrors(player_id, logger::ErrorType::NO_MORE_UPGRADES,
-		          "Max level reached, upgrade not allowed for tower with id " +
-		              std::to_string(tower_id));
+		LogErrors(player_id, logger::ErrorType::NO_MORE_UPGRADES, tower_id);
 		return;
 	}
 
 	// Check if player has sufficient balance
 	int64_t tower_upgrade_cost = tower_build_costs[current_tower_level];
 	if (player_money < tower_upgrade_cost) {
-		LogErrors(player_id, logger::ErrorType::INSUFFICIENT_FUNDS,
-		          "Insufficient funds to upgrade tower with id " +
-		              std::to_string(tower_id));
+		LogErrors(player_id, logger::ErrorType::INSUFFICIENT_FUNDS, tower_id);
 		return;
 	}
 
 	player_money = player_money - tower_upgrade_cost;
+	logger->LogCommand(player_id, logger::CommandType::UPGRADE_TOWER,
+	                   tower_id, -1, physics::Vector(-1, -1));
 	state->UpgradeTower(player_id, tower_id);
 }
 
 void StateSyncer::SuicideTower(PlayerId player_id, int64_t tower_id,
                                int64_t tower_index,
                                std::vector<int64_t> &razed_towers) {
-	auto state_towers = state->GetAllTowers();
+	auto &state_towers = state->GetAllTowers();
 	// Check if id has been altered.
 	if (tower_id !=
 	    state_towers[static_cast<int>(player_id)][tower_index]->GetActorId()) {
-		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID,
-		          "Do not alter id of actors");
+		LogErrors(player_id, logger::ErrorType::NO_ALTER_ACTOR_ID);
 		return;
 	}
 
 	// Check if tower is base tower
 	if (state_towers[static_cast<int>(player_id)][tower_index]->GetIsBase()) {
-		LogErrors(player_id, logger::ErrorType::NO_SUICIDE_BASE_TOWER,
-		          "Cannot destroy base tower");
+		LogErrors(player_id, logger::ErrorType::NO_SUICIDE_BASE_TOWER);
 		return;
 	}
 	razed_towers.push_back(tower_id);
+	logger->LogCommand(player_id, logger::CommandType::SUICIDE_TOWER,
+	                   tower_id, -1, physics::Vector(-1, -1));
 	state->SuicideTower(player_id, tower_id);
 }
 
@@ -17,9 +17,10 @@ TowerManager::TowerManager() {
 
 TowerManager::TowerManager(std::vector<std::unique_ptr<Tower>> towers,
                            PlayerId player_id, MoneyManager *money_manager,
-                           IMap *map)
+                           IMap *map, ActorIdAllocator *actor_id_allocator)
     : towers(std::move(towers)), player_id(player_id),
       money_manager(money_manager), map(map),
+      actor_id_allocator(actor_id_allocator),
       territory_refs(std::vector<std::vector<int64_t>>(
           map->GetSize(), std::vector<int64_t>(map->GetSize(), 0))) {
 
@@ -29,12 +30,12 @@ TowerManager::TowerManager(std::vector<std::unique_ptr<Tower>> towers,
 
 		for (int i = bounds[0].x; i <= bounds[1].x; ++i) {
 			for (int j = bounds[0].y; j <= bounds[1].y; ++j) {
-				territory_refs[i][j]++;
-				map->GetElementByOffset(physics::Vector(i, j))
-				    .SetOwnership(player_id, true);
+				AddTerritoryRef(physics::Vector(i, j));
 			}
 		}
 	}
+
+	RefreshTowerPtrs();
 }
 
 std::vector<physics::Vector> TowerManager::CalculateBounds(Tower *tower) {
@@ -57,6 +58,27 @@ std::vector<physics::Vector> TowerManager::CalculateBounds(Tower *tower) {
 	return result;
 }
 
+void TowerManager::AddTerritoryRef(physics::Vector offset) {
+	if (territory_refs[offset.x][offset.y]++ == 0) {
+		dirty_offsets.push_back(offset);
+	}
+	map->GetElementByOffset(offset).SetOwnership(player_id, true);
+}
+
+void TowerManager::RemoveTerritoryRef(physics::Vector offset) {
+	if (--territory_refs[offset.x][offset.y] == 0) {
+		map->GetElementByOffset(offset).SetOwnership(player_id, false);
+		dirty_offsets.push_back(offset);
+	}
+}
+
+void TowerManager::RefreshTowerPtrs() {
+	this->tower_ptrs.clear();
+	for (auto &tower : this->towers) {
+		this->tower_ptrs.push_back(tower.get());
+	}
+}
+
 void TowerManager::BuildTower(physics::Vector offset, bool is_base) {
 	this->towers_to_build_offsets.push(offset);
 }
@@ -83,7 +105,7 @@ void TowerManager::HandleTowerBuildUpdates() {
 		money_manager->Decrease(this->player_id, this->build_costs[0]);
 
 		// Get the next ActorId
-		auto new_actor_id = Actor::GetNextActorId();
+		auto new_actor_id = this->actor_id_allocator->GetNextActorId();
 
 		// Make the new tower
 		auto new_tower = std::make_unique<Tower>(
@@ -97,15 +119,14 @@ void TowerManager::HandleTowerBuildUpdates() {
 
 		// Add the new tower
 		this->towers.push_back(std::move(new_tower));
+		this->tower_ptrs.push_back(tower_ptr);
 
 		// Mark the new territory
 		auto bounds = CalculateBounds(tower_ptr);
 
 		for (int i = bounds[0].x; i <= bounds[1].x; ++i) {
 			for (int j = bounds[0].y; j <= bounds[1].y; ++j) {
-				territory_refs[i][j]++;
-				map->GetElementByOffset(physics::Vector(i, j))
-				    .SetOwnership(player_id, true);
+				AddTerritoryRef(physics::Vector(i, j));
 			}
 		}
 	}
@@ -159,9 +180,7 @@ void TowerManager::HandleTowerUpgradeUpdates() {
 				if (i >= old_bounds[0].x && i <= old_bounds[1].x &&
 				    j >= old_bounds[0].y && j <= old_bounds[1].y)
 					continue;
-				territory_refs[i][j]++;
-				map->GetElementByOffset(physics::Vector(i, j))
-				    .SetOwnership(player_id, true);
+				AddTerritoryRef(physics::Vector(i, j));
 			}
 		}
 	}
@@ -221,11 +240,7 @@ void TowerManager::HandleTowerDeathUpdates() {
 		// If territory references hits zero, deallocate the territory
 		for (int i = bounds[0].x; i <= bounds[1].x; ++i) {
 			for (int j = bounds[0].y; j <= bounds[1].y; ++j) {
-				territory_refs[i][j]--;
-				if (territory_refs[i][j] == 0) {
-					map->GetElementByOffset(physics::Vector(i, j))
-					    .SetOwnership(player_id, false);
-				}
+				RemoveTerritoryRef(physics::Vector(i, j));
 			}
 		}
 
@@ -236,6 +251,10 @@ void TowerManager::HandleTowerDeathUpdates() {
 		// Delete the tower from the main list
 		towers.erase(towers.begin() + tower_i);
 	}
+
+	if (!tower_indices_to_delete.empty()) {
+		RefreshTowerPtrs();
+	}
 }
 
 void TowerManager::Update() {
@@ -261,11 +280,13 @@ Tower *TowerManager::GetTowerById(ActorId tower_id) {
 	return towers[tower_index].get();
 }
 
-std::vector<Tower *> TowerManager::GetTowers() {
-	std::vector<Tower *> ret_towers;
-	for (int i = 0; i < towers.size(); ++i) {
-		ret_towers.push_back(towers[i].get());
-	}
-	return ret_towers;
+const std::vector<Tower *> &TowerManager::GetTowers() {
+	return this->tower_ptrs;
+}
+
+const std::vector<physics::Vector> &TowerManager::GetDirtyOffsets() {
+	return this->dirty_offsets;
 }
+
+void TowerManager::ClearDirtyOffsets() { this->dirty_offsets.clear(); }
 }
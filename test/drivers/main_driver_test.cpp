@@ -1,12 +1,20 @@
 #include "constants/constants.h"
+#include "drivers/in_process_player.h"
 #include "drivers/main_driver.h"
+#include "drivers/player_driver.h"
 #include "drivers/shared_memory_utils/shared_memory_player.h"
 #include "drivers/timer.h"
+#include "game.pb.h"
+#include "logger/logger.h"
 #include "logger/mocks/logger_mock.h"
+#include "state/actor/actor_id_allocator.h"
+#include "state/mocks/map_mock.h"
+#include "state/mocks/state_mock.h"
 #include "state/mocks/state_syncer_mock.h"
 #include "gtest/gtest.h"
 #include <atomic>
 #include <cmath>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <thread>
@@ -16,6 +24,23 @@ using namespace std;
 using namespace state;
 using namespace drivers;
 using namespace logger;
+using namespace player_wrapper;
+
+// Player code that reports a fixed number of instructions every turn, as the
+// LLVM pass would
+class CountingPlayerCode : public IPlayerCode {
+	uint64_t turn_instruction_count;
+
+  public:
+	CountingPlayerCode(uint64_t turn_instruction_count)
+	    : turn_instruction_count(turn_instruction_count) {}
+
+	player_state::State Update(player_state::State state) override {
+		PlayerDriver::IncrementCount(turn_instruction_count);
+		logr << "turn\n";
+		return state;
+	}
+};
 
 class MainDriverTest : public testing::Test {
   protected:
@@ -29,14 +54,19 @@ class MainDriverTest : public testing::Test {
 
 	const static int time_limit_ms;
 
+	const static int turn_time_limit_ms;
+
 	const static int turn_instruction_limit;
 
 	const static int game_instruction_limit;
 
 	// Returns a new mock main driver
-	static unique_ptr<MainDriver>
-	CreateMockMainDriver(unique_ptr<StateSyncerMock> state_syncer_mock,
-	                     unique_ptr<LoggerMock> v_logger) {
+	static unique_ptr<MainDriver> CreateMockMainDriver(
+	    unique_ptr<StateSyncerMock> state_syncer_mock,
+	    unique_ptr<LoggerMock> v_logger, int64_t max_no_turns = num_turns,
+	    Timer::Interval player_turn_duration =
+	        Timer::Interval(turn_time_limit_ms),
+	    bool are_player_turns_concurrent = false) {
 		vector<unique_ptr<SharedMemoryMain>> shm;
 		for (const auto &shm_name : shared_memory_names) {
 			// Remove shm if it already exists
@@ -48,8 +78,9 @@ class MainDriverTest : public testing::Test {
 
 		return unique_ptr<MainDriver>(new MainDriver(
 		    move(state_syncer_mock), move(shm), turn_instruction_limit,
-		    game_instruction_limit, num_turns, player_count,
-		    Timer::Interval(time_limit_ms), move(v_logger), "game.log"));
+		    game_instruction_limit, max_no_turns, player_count,
+		    Timer::Interval(time_limit_ms), player_turn_duration,
+		    are_player_turns_concurrent, move(v_logger), "game.log"));
 	}
 
   public:
@@ -61,6 +92,7 @@ const vector<string> MainDriverTest::shared_memory_names = {"ShmTest1",
 const int MainDriverTest::player_count = 2;
 const int MainDriverTest::num_turns = pow(10, 4);
 const int MainDriverTest::time_limit_ms = 1000;
+const int MainDriverTest::turn_time_limit_ms = 1000;
 const int MainDriverTest::turn_instruction_limit = 5;
 const int MainDriverTest::game_instruction_limit = 10;
 
@@ -95,6 +127,8 @@ TEST_F(MainDriverTest, CleanRun) {
 	    .Times(num_turns);
 	EXPECT_CALL(*v_logger, LogInstructionCount(PlayerId::PLAYER2, _))
 	    .Times(num_turns);
+	EXPECT_CALL(*v_logger, LogTurnTime(_, _, false)).Times(2 * num_turns);
+	EXPECT_CALL(*v_logger, StartStream(_)).Times(1);
 	EXPECT_CALL(*v_logger, LogFinalGameParams()).Times(1);
 	EXPECT_CALL(*v_logger, WriteGame(_)).Times(1);
 
@@ -153,6 +187,10 @@ TEST_F(MainDriverTest, EarlyPlayerExit) {
 	    .Times(num_turns / 2 + 1);
 	EXPECT_CALL(*v_logger, LogInstructionCount(PlayerId::PLAYER2, _))
 	    .Times(num_turns / 2 + 1);
+	// The last turn is abandoned when the game times out
+	EXPECT_CALL(*v_logger, LogTurnTime(_, _, false)).Times(num_turns);
+	EXPECT_CALL(*v_logger, LogTurnTime(_, _, true)).Times(2);
+	EXPECT_CALL(*v_logger, StartStream(_)).Times(1);
 	EXPECT_CALL(*v_logger, LogFinalGameParams()).Times(1);
 	EXPECT_CALL(*v_logger, WriteGame(_)).Times(1);
 
@@ -205,6 +243,8 @@ TEST_F(MainDriverTest, InstructionLimitReached) {
 	    .Times(num_turns / 2 + 1);
 	EXPECT_CALL(*v_logger, LogInstructionCount(PlayerId::PLAYER2, _))
 	    .Times(num_turns / 2 + 1);
+	EXPECT_CALL(*v_logger, LogTurnTime(_, _, false)).Times(num_turns + 2);
+	EXPECT_CALL(*v_logger, StartStream(_)).Times(1);
 	EXPECT_CALL(*v_logger, LogFinalGameParams()).Times(1);
 	EXPECT_CALL(*v_logger, WriteGame(_)).Times(1);
 
@@ -233,16 +273,20 @@ TEST_F(MainDriverTest, InstructionLimitReached) {
 	for (const auto &shm_name : shared_memory_names) {
 		SharedMemoryPlayer shm_player(shm_name);
 		SharedBuffer *buf = shm_player.GetBuffer();
+		while (!buf->is_player_running)
+			this_thread::yield();
 		buf->instruction_counter = game_instruction_limit;
-		buf->is_player_running = false;
+		buf->SetPlayerRunning(false);
 	}
 
 	// Simulating instruction limit exceeding on n/2 + 1 turn by all players
 	for (const auto &shm_name : shared_memory_names) {
 		SharedMemoryPlayer shm_player(shm_name);
 		SharedBuffer *buf = shm_player.GetBuffer();
+		while (!buf->is_player_running)
+			this_thread::yield();
 		buf->instruction_counter = game_instruction_limit + 1;
-		buf->is_player_running = false;
+		buf->SetPlayerRunning(false);
 	}
 
 	main_runner.join();
@@ -270,6 +314,8 @@ TEST_F(MainDriverTest, Cancellation) {
 	unique_ptr<LoggerMock> v_logger(new LoggerMock());
 	EXPECT_CALL(*v_logger, LogInstructionCount(PlayerId::PLAYER1, _)).Times(1);
 	EXPECT_CALL(*v_logger, LogInstructionCount(PlayerId::PLAYER2, _)).Times(1);
+	EXPECT_CALL(*v_logger, LogTurnTime(_, _, false)).Times(2);
+	EXPECT_CALL(*v_logger, StartStream(_)).Times(1);
 	EXPECT_CALL(*v_logger, LogFinalGameParams()).Times(1);
 	EXPECT_CALL(*v_logger, WriteGame(_)).Times(1);
 
@@ -304,3 +350,293 @@ TEST_F(MainDriverTest, Cancellation) {
 		EXPECT_EQ(result.status, PlayerResult::Status::UNDEFINED);
 	}
 }
+
+// Test for a player that runs past the turn time limit
+// The player should forfeit that turn and every turn until it finishes, and
+// get its turns back after
+TEST_F(MainDriverTest, TurnTimeLimit) {
+	const int stall_num_turns = 4;
+	const Timer::Interval stall_turn_duration(50);
+
+	unique_ptr<StateSyncerMock> state_syncer_mock(new StateSyncerMock());
+
+	// The first player is skipped while it runs late, and in the turn it
+	// finishes in as its commands are stale
+	EXPECT_CALL(*state_syncer_mock,
+	            ExecutePlayerCommands(_, vector<bool>({true, false})))
+	    .Times(3);
+	EXPECT_CALL(*state_syncer_mock,
+	            ExecutePlayerCommands(_, vector<bool>({false, false})))
+	    .Times(1);
+	EXPECT_CALL(*state_syncer_mock, UpdateMainState()).Times(stall_num_turns);
+	EXPECT_CALL(*state_syncer_mock, GetScores())
+	    .WillOnce(Return(vector<int64_t>(player_count, 10)));
+
+	// Record which state the first player's updates are written to
+	vector<player_state::State *> player1_states;
+	EXPECT_CALL(*state_syncer_mock, UpdatePlayerStates(_))
+	    .Times(stall_num_turns + 1)
+	    .WillRepeatedly(
+	        Invoke([&player1_states](vector<player_state::State *> &states) {
+		        player1_states.push_back(states[0]);
+	        }));
+
+	unique_ptr<LoggerMock> v_logger(new LoggerMock());
+	EXPECT_CALL(*v_logger, LogInstructionCount(_, _))
+	    .Times(player_count * stall_num_turns);
+	EXPECT_CALL(*v_logger, LogTurnTime(PlayerId::PLAYER1, _, true)).Times(3);
+	EXPECT_CALL(*v_logger, LogTurnTime(PlayerId::PLAYER1, _, false)).Times(1);
+	EXPECT_CALL(*v_logger, LogTurnTime(PlayerId::PLAYER2, _, false))
+	    .Times(stall_num_turns);
+	EXPECT_CALL(*v_logger, StartStream(_)).Times(1);
+	EXPECT_CALL(*v_logger, LogFinalGameParams()).Times(1);
+	EXPECT_CALL(*v_logger, WriteGame(_)).Times(1);
+
+	driver = CreateMockMainDriver(move(state_syncer_mock), move(v_logger),
+	                              stall_num_turns, stall_turn_duration);
+
+	vector<PlayerResult> player_results;
+	thread main_runner(
+	    [this, &player_results] { player_results = driver->Start(); });
+
+	SharedMemoryPlayer shm_player1(shared_memory_names[0]);
+	SharedMemoryPlayer shm_player2(shared_memory_names[1]);
+	SharedBuffer *buf1 = shm_player1.GetBuffer();
+	SharedBuffer *buf2 = shm_player2.GetBuffer();
+
+	// First turn, the first player doesn't finish in time
+	while (!buf1->is_player_running)
+		this_thread::yield();
+	while (!buf2->is_player_running)
+		this_thread::yield();
+	buf2->SetPlayerRunning(false);
+
+	// Second turn, the first player is still running, then finishes
+	while (!buf2->is_player_running)
+		this_thread::yield();
+	buf1->SetPlayerRunning(false);
+	buf2->SetPlayerRunning(false);
+
+	// Third and fourth turns, the first player gets its turns back in the
+	// fourth
+	while (!buf2->is_player_running)
+		this_thread::yield();
+	buf2->SetPlayerRunning(false);
+	for (auto *buf : {buf1, buf2}) {
+		while (!buf->is_player_running)
+			this_thread::yield();
+		buf->SetPlayerRunning(false);
+	}
+
+	main_runner.join();
+
+	for (auto result : player_results) {
+		EXPECT_EQ(result.score, 10);
+		EXPECT_EQ(result.status, PlayerResult::Status::NORMAL);
+	}
+
+	// The player's own state is left alone while it runs late
+	ASSERT_EQ(player1_states.size(), stall_num_turns + 1);
+	EXPECT_NE(player1_states[1], player1_states[0]);
+	EXPECT_EQ(player1_states[2], player1_states[1]);
+	EXPECT_EQ(player1_states[3], player1_states[0]);
+	EXPECT_EQ(player1_states[4], player1_states[0]);
+}
+
+// Test for players that run their turns at the same time
+// Both players should be let run before either finishes, and finish in any
+// order
+TEST_F(MainDriverTest, ConcurrentTurns) {
+	const int concurrent_num_turns = 2;
+
+	unique_ptr<StateSyncerMock> state_syncer_mock(new StateSyncerMock());
+	EXPECT_CALL(*state_syncer_mock,
+	            ExecutePlayerCommands(_, vector<bool>(player_count, false)))
+	    .Times(concurrent_num_turns);
+	EXPECT_CALL(*state_syncer_mock, UpdateMainState())
+	    .Times(concurrent_num_turns);
+	EXPECT_CALL(*state_syncer_mock, UpdatePlayerStates(_))
+	    .Times(concurrent_num_turns + 1);
+	EXPECT_CALL(*state_syncer_mock, GetScores())
+	    .WillOnce(Return(vector<int64_t>(player_count, 10)));
+
+	unique_ptr<LoggerMock> v_logger(new LoggerMock());
+	EXPECT_CALL(*v_logger, LogInstructionCount(_, 1))
+	    .Times(player_count * concurrent_num_turns);
+	EXPECT_CALL(*v_logger, LogTurnTime(_, _, false))
+	    .Times(player_count * concurrent_num_turns);
+	EXPECT_CALL(*v_logger, StartStream(_)).Times(1);
+	EXPECT_CALL(*v_logger, LogFinalGameParams()).Times(1);
+	EXPECT_CALL(*v_logger, WriteGame(_)).Times(1);
+
+	driver = CreateMockMainDriver(move(state_syncer_mock), move(v_logger),
+	                              concurrent_num_turns,
+	                              Timer::Interval(turn_time_limit_ms), true);
+
+	vector<PlayerResult> player_results;
+	thread main_runner(
+	    [this, &player_results] { player_results = driver->Start(); });
+
+	SharedMemoryPlayer shm_player1(shared_memory_names[0]);
+	SharedMemoryPlayer shm_player2(shared_memory_names[1]);
+	SharedBuffer *buf1 = shm_player1.GetBuffer();
+	SharedBuffer *buf2 = shm_player2.GetBuffer();
+
+	// Every turn, both players are running before either is done, and the
+	// second player finishes first
+	for (int i = 0; i < concurrent_num_turns; ++i) {
+		while (!buf1->is_player_running || !buf2->is_player_running)
+			this_thread::yield();
+		for (auto *buf : {buf2, buf1}) {
+			buf->instruction_counter = 1;
+			buf->SetPlayerRunning(false);
+		}
+	}
+
+	main_runner.join();
+
+	EXPECT_EQ(player_results.size(), player_count);
+	for (auto result : player_results) {
+		EXPECT_EQ(result.score, 10);
+		EXPECT_EQ(result.status, PlayerResult::Status::NORMAL);
+	}
+}
+
+// Test for players running in process, without shared memory or player
+// processes. The first player exceeds the turn instruction limit every turn
+TEST_F(MainDriverTest, InProcessPlayers) {
+	const int in_process_num_turns = 100;
+	const vector<uint64_t> turn_instruction_counts = {
+	    turn_instruction_limit + 1, 1};
+	const vector<string> debug_log_files = {"in_process_player_1.dlog",
+	                                        "in_process_player_2.dlog"};
+
+	unique_ptr<StateSyncerMock> state_syncer_mock(new StateSyncerMock());
+	EXPECT_CALL(*state_syncer_mock,
+	            ExecutePlayerCommands(_, vector<bool>({true, false})))
+	    .Times(in_process_num_turns);
+	EXPECT_CALL(*state_syncer_mock, UpdateMainState())
+	    .Times(in_process_num_turns);
+	EXPECT_CALL(*state_syncer_mock, UpdatePlayerStates(_))
+	    .Times(in_process_num_turns + 1);
+	EXPECT_CALL(*state_syncer_mock, GetScores())
+	    .WillOnce(Return(vector<int64_t>(player_count, 10)));
+
+	unique_ptr<LoggerMock> v_logger(new LoggerMock());
+	EXPECT_CALL(*v_logger, LogInstructionCount(PlayerId::PLAYER1,
+	                                           turn_instruction_limit + 1))
+	    .Times(in_process_num_turns);
+	EXPECT_CALL(*v_logger, LogInstructionCount(PlayerId::PLAYER2, 1))
+	    .Times(in_process_num_turns);
+	EXPECT_CALL(*v_logger, LogTurnTime(_, _, false))
+	    .Times(2 * in_process_num_turns);
+	EXPECT_CALL(*v_logger, StartStream(_)).Times(1);
+	EXPECT_CALL(*v_logger, LogFinalGameParams()).Times(1);
+	EXPECT_CALL(*v_logger, WriteGame(_)).Times(1);
+
+	vector<unique_ptr<InProcessPlayer>> players;
+	for (int i = 0; i < player_count; ++i) {
+		players.push_back(make_unique<InProcessPlayer>(
+		    make_unique<PlayerCodeWrapper>(
+		        make_unique<CountingPlayerCode>(turn_instruction_counts[i])),
+		    debug_log_files[i], "prefix\n", "truncated\n", 2));
+	}
+
+	driver = make_unique<MainDriver>(
+	    move(state_syncer_mock), move(players), turn_instruction_limit,
+	    game_instruction_limit, in_process_num_turns, player_count,
+	    Timer::Interval(time_limit_ms), Timer::Interval(turn_time_limit_ms),
+	    move(v_logger), "game.log");
+
+	auto player_results = driver->Start();
+	driver.reset();
+
+	EXPECT_EQ(player_results.size(), player_count);
+	for (auto result : player_results) {
+		EXPECT_EQ(result.score, 10);
+		EXPECT_EQ(result.status, PlayerResult::Status::NORMAL);
+	}
+
+	// Debug logs are cut down to 2 characters a turn
+	ifstream debug_logs(debug_log_files[0]);
+	string line;
+	getline(debug_logs, line);
+	EXPECT_EQ(line, "prefix");
+	getline(debug_logs, line);
+	EXPECT_EQ(line, "tutruncated");
+}
+
+// Test for a game streamed to its log file. The first state is logged by the
+// first sync, before any turn, so the stream must already have been started
+TEST_F(MainDriverTest, StreamedLog) {
+	const int streamed_num_turns = 10;
+
+	ActorIdAllocator actor_id_allocator;
+	auto soldier = make_unique<Soldier>(
+	    actor_id_allocator.GetNextActorId(), PlayerId::PLAYER1,
+	    ActorType::SOLDIER, 100, 100, physics::Vector(20, 20), 5, 5, 40,
+	    nullptr, nullptr);
+	auto soldier2 = make_unique<Soldier>(
+	    actor_id_allocator.GetNextActorId(), PlayerId::PLAYER2,
+	    ActorType::SOLDIER, 100, 100, physics::Vector(20, 20), 5, 5, 40,
+	    nullptr, nullptr);
+	auto tower = make_unique<Tower>(actor_id_allocator.GetNextActorId(),
+	                                PlayerId::PLAYER1, ActorType::TOWER, 500,
+	                                500, physics::Vector(20, 10), false, 1);
+	auto tower2 = make_unique<Tower>(actor_id_allocator.GetNextActorId(),
+	                                 PlayerId::PLAYER2, ActorType::TOWER, 500,
+	                                 500, physics::Vector(10, 20), false, 1);
+	vector<vector<Soldier *>> soldiers = {{soldier.get()}, {soldier2.get()}};
+	vector<vector<Tower *>> towers = {{tower.get()}, {tower2.get()}};
+	vector<int64_t> money = {400, 500};
+
+	auto map = make_unique<MapMock>();
+	auto state = make_unique<StateMock>();
+	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
+	EXPECT_CALL(*map, GetSize()).WillRepeatedly(Return(30));
+	EXPECT_CALL(*map, GetElementSize()).WillRepeatedly(Return(50));
+	EXPECT_CALL(*state, GetMoney()).WillRepeatedly(ReturnRef(money));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
+	EXPECT_CALL(*state, GetHash()).WillRepeatedly(Return(0));
+
+	auto game_logger =
+	    make_unique<Logger>(turn_instruction_limit, game_instruction_limit,
+	                        LogWriteMode::STREAM);
+	auto *game_logger_ptr = game_logger.get();
+
+	// Like the state syncer, log the state on every sync
+	unique_ptr<StateSyncerMock> state_syncer_mock(new StateSyncerMock());
+	EXPECT_CALL(*state_syncer_mock, ExecutePlayerCommands(_, _))
+	    .Times(streamed_num_turns);
+	EXPECT_CALL(*state_syncer_mock, UpdateMainState())
+	    .Times(streamed_num_turns);
+	EXPECT_CALL(*state_syncer_mock, UpdatePlayerStates(_))
+	    .Times(streamed_num_turns + 1)
+	    .WillRepeatedly(
+	        InvokeWithoutArgs([&] { game_logger_ptr->LogState(state.get()); }));
+	EXPECT_CALL(*state_syncer_mock, GetScores())
+	    .WillOnce(Return(vector<int64_t>(player_count, 10)));
+
+	vector<unique_ptr<InProcessPlayer>> players;
+	for (int i = 0; i < player_count; ++i) {
+		players.push_back(make_unique<InProcessPlayer>(
+		    make_unique<PlayerCodeWrapper>(make_unique<CountingPlayerCode>(1)),
+		    "streamed_log_player_" + to_string(i + 1) + ".dlog", "", "", 0));
+	}
+
+	driver = make_unique<MainDriver>(
+	    move(state_syncer_mock), move(players), turn_instruction_limit,
+	    game_instruction_limit, streamed_num_turns, player_count,
+	    Timer::Interval(time_limit_ms), Timer::Interval(turn_time_limit_ms),
+	    move(game_logger), "streamed_game.log");
+	driver->Start();
+	driver.reset();
+
+	// The log has the static fields and every state, the first one included
+	ifstream log_file("streamed_game.log", ios::in | ios::binary);
+	auto game = make_unique<proto::Game>();
+	ASSERT_TRUE(game->ParseFromIstream(&log_file));
+	EXPECT_EQ(game->terrain_size(), 30);
+	EXPECT_EQ(game->states_size(), streamed_num_turns + 1);
+}
@@ -32,19 +32,25 @@ int main(int argc, char *argv[]) {
 	// Set time limit on player side
 	Timer timer;
 	atomic_bool is_time_over(false);
-	timer.Start((Timer::Interval(time_limit_ms)),
-	            [&is_time_over]() { is_time_over = true; });
+
+	timer.Start((Timer::Interval(time_limit_ms)), [&is_time_over, buf]() {
+		is_time_over = true;
+		buf->Notify();
+	});
+	const SharedBuffer::StopCondition stop_condition = [&is_time_over]() {
+		return static_cast<bool>(is_time_over);
+	};
+	int64_t spin_count = SharedBuffer::default_spin_count;
 
 	// Run player updates for num_turns
 	for (int i = 0; i < num_turns && !is_time_over; ++i) {
 		// cout << i << endl;
-		while (!buf->is_player_running && !is_time_over)
-			;
+		buf->WaitForPlayerRunning(true, stop_condition, spin_count);
 		if (i < num_turns / 2)
 			buf->instruction_counter = turn_instruction_limit;
 		else
 			buf->instruction_counter = turn_instruction_limit + 1;
-		buf->is_player_running = false;
+		buf->SetPlayerRunning(false);
 	}
 
 	return 0;
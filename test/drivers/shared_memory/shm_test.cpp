@@ -3,8 +3,11 @@
 #include "drivers/shared_memory_utils/shared_memory_player.h"
 #include "state/player_state.h"
 #include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <stdexcept>
+#include <thread>
 
 using namespace std;
 using namespace drivers;
@@ -50,3 +53,38 @@ TEST(SharedMemoryUtilsTest, InvalidCreate) {
 	EXPECT_THROW((SharedMemoryMain(shm_name, false, 0, player_state::State())),
 	             std::exception);
 }
+
+TEST(SharedMemoryUtilsTest, WaitForPlayerRunning) {
+	RemoveShm();
+	SharedMemoryMain shm_main(shm_name, false, 0, player_state::State());
+	SharedBuffer *buf = shm_main.GetBuffer();
+	const SharedBuffer::StopCondition never_stop = []() { return false; };
+
+	// Value already set, returns right away without sleeping
+	int64_t spin_count = 0;
+	EXPECT_TRUE(buf->WaitForPlayerRunning(false, never_stop, spin_count));
+
+	// Flag set from another thread wakes up a sleeping waiter
+	std::thread setter([buf]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		buf->SetPlayerRunning(true);
+	});
+	EXPECT_TRUE(buf->WaitForPlayerRunning(true, never_stop, spin_count));
+	setter.join();
+	EXPECT_TRUE(buf->is_player_running);
+
+	// Stop condition abandons the wait once notified
+	std::atomic_bool stop(false);
+	const SharedBuffer::StopCondition stop_condition = [&stop]() {
+		return static_cast<bool>(stop);
+	};
+	std::thread stopper([buf, &stop]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		stop = true;
+		buf->Notify();
+	});
+	spin_count = SharedBuffer::default_spin_count;
+	EXPECT_FALSE(buf->WaitForPlayerRunning(false, stop_condition, spin_count));
+	stopper.join();
+	EXPECT_TRUE(buf->is_player_running);
+}
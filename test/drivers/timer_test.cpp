@@ -1,6 +1,10 @@
 #include "drivers/timer.h"
 #include "gtest/gtest.h"
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 using namespace drivers;
 using namespace std;
@@ -63,3 +67,53 @@ TEST(TimerTest, Cancellation) {
 	// Flag should have remain unset as timer was cancelled
 	EXPECT_FALSE(flag);
 }
+
+// Timers don't get a thread each, so a process can run many of them. They
+// expire in deadline order, and cancelling one doesn't wait for it
+TEST(TimerTest, ManyTimers) {
+	const int num_timers = 1000;
+	vector<unique_ptr<Timer>> timers;
+	atomic<int> count(0);
+	atomic<int> last_expired(-1);
+	atomic<bool> is_in_order(true);
+
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < num_timers; ++i) {
+		timers.push_back(make_unique<Timer>());
+		// Later timers expire later, odd ones are cancelled below
+		timers.back()->Start(Timer::Interval(timer_duration + i / 10),
+		                     [&count, &last_expired, &is_in_order, i] {
+			                     if (last_expired / 10 > i / 10) {
+				                     is_in_order = false;
+			                     }
+			                     last_expired = i;
+			                     count++;
+		                     });
+	}
+	for (int i = 1; i < num_timers; i += 2) {
+		timers[i]->Cancel();
+	}
+	EXPECT_LT(chrono::steady_clock::now() - start,
+	          chrono::milliseconds(timer_duration));
+
+	this_thread::sleep_for(
+	    chrono::milliseconds(timer_duration + num_timers / 10 + grace_period));
+	EXPECT_EQ(count, num_timers / 2);
+	EXPECT_TRUE(is_in_order);
+}
+
+// A timer can be cancelled and restarted from its own callback
+TEST(TimerTest, RestartFromCallback) {
+	Timer t;
+	atomic<int> count(0);
+	Timer::Callback callback = [&] {
+		t.Cancel();
+		if (++count < 3) {
+			t.Start(Timer::Interval(1), callback);
+		}
+	};
+
+	EXPECT_TRUE(t.Start(Timer::Interval(1), callback));
+	this_thread::sleep_for(chrono::milliseconds(grace_period));
+	EXPECT_EQ(count, 3);
+}
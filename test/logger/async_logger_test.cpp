@@ -0,0 +1,131 @@
+#include "logger/async_logger.h"
+#include "logger/mocks/logger_mock.h"
+#include "state/mocks/state_mock.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+using namespace ::testing;
+using namespace state;
+using namespace logger;
+
+class AsyncLoggerTest : public testing::Test {
+  protected:
+	// Outlives the logger, which may still be logging it
+	StateMock state;
+
+	// Owned by async_logger
+	LoggerMock *logger_mock;
+	unique_ptr<AsyncLogger> async_logger;
+
+	AsyncLoggerTest()
+	    : logger_mock(new LoggerMock()),
+	      async_logger(
+	          make_unique<AsyncLogger>(unique_ptr<LoggerMock>(logger_mock))) {}
+};
+
+// Every call reaches the wrapped logger in order, states on another thread
+TEST_F(AsyncLoggerTest, ForwardsInOrder) {
+	auto caller_id = this_thread::get_id();
+	thread::id log_state_id;
+	ostringstream stream;
+
+	{
+		InSequence sequence;
+		EXPECT_CALL(*logger_mock, StartStream(Ref(stream)));
+		EXPECT_CALL(*logger_mock, LogState(&state))
+		    .WillOnce(Invoke([&log_state_id](IState *) {
+			    log_state_id = this_thread::get_id();
+		    }));
+		EXPECT_CALL(*logger_mock, LogTurnTime(PlayerId::PLAYER1, 10, false));
+		EXPECT_CALL(*logger_mock, LogInstructionCount(PlayerId::PLAYER1, 5));
+		EXPECT_CALL(*logger_mock,
+		            LogError(PlayerId::PLAYER2,
+		                     ErrorType::NO_ACTION_BY_DEAD_SOLDIER, 1, -1));
+		EXPECT_CALL(*logger_mock,
+		            LogCommand(PlayerId::PLAYER2, CommandType::BUILD_TOWER, -1,
+		                       -1, physics::Vector(4, 1)));
+		EXPECT_CALL(*logger_mock, LogState(&state));
+		EXPECT_CALL(*logger_mock, LogFinalGameParams());
+		EXPECT_CALL(*logger_mock, WriteGame(Ref(stream)));
+	}
+
+	async_logger->StartStream(stream);
+	async_logger->LogState(&state);
+	async_logger->LogTurnTime(PlayerId::PLAYER1, 10, false);
+	async_logger->LogInstructionCount(PlayerId::PLAYER1, 5);
+	async_logger->LogError(PlayerId::PLAYER2,
+	                       ErrorType::NO_ACTION_BY_DEAD_SOLDIER, 1, -1);
+	async_logger->LogCommand(PlayerId::PLAYER2, CommandType::BUILD_TOWER, -1,
+	                         -1, physics::Vector(4, 1));
+	async_logger->LogState(&state);
+	async_logger->LogFinalGameParams();
+	async_logger->WriteGame(stream);
+
+	EXPECT_NE(log_state_id, caller_id);
+}
+
+// LogState returns while the state is being logged, and the next call waits
+// for it
+TEST_F(AsyncLoggerTest, OverlapsLogState) {
+	atomic_bool is_log_state_released(false);
+	atomic_bool is_state_logged(false);
+
+	EXPECT_CALL(*logger_mock, LogState(&state))
+	    .WillOnce(Invoke([&](IState *) {
+		    while (!is_log_state_released) {
+			    this_thread::yield();
+		    }
+		    is_state_logged = true;
+	    }));
+	EXPECT_CALL(*logger_mock, LogInstructionCount(PlayerId::PLAYER1, 5))
+	    .WillOnce(Invoke([&](PlayerId, int64_t) {
+		    EXPECT_TRUE(is_state_logged);
+	    }));
+
+	async_logger->LogState(&state);
+	EXPECT_FALSE(is_state_logged);
+
+	thread releaser([&is_log_state_released] {
+		this_thread::sleep_for(chrono::milliseconds(10));
+		is_log_state_released = true;
+	});
+	async_logger->LogInstructionCount(PlayerId::PLAYER1, 5);
+	releaser.join();
+}
+
+// The last state is logged before the logger is destroyed
+TEST_F(AsyncLoggerTest, DestructionLogsPendingState) {
+	EXPECT_CALL(*logger_mock, LogState(&state)).Times(1);
+
+	async_logger->LogState(&state);
+	async_logger.reset();
+}
+
+// An exception thrown logging a state is rethrown by the next call, once
+TEST_F(AsyncLoggerTest, RethrowsLogStateError) {
+	EXPECT_CALL(*logger_mock, LogState(&state))
+	    .WillOnce(Throw(logic_error("There are no soldiers. Cannot log.")))
+	    .WillOnce(Return());
+	EXPECT_CALL(*logger_mock, LogInstructionCount(PlayerId::PLAYER1, 5));
+
+	async_logger->LogState(&state);
+	EXPECT_THROW(async_logger->LogInstructionCount(PlayerId::PLAYER1, 5),
+	             logic_error);
+
+	async_logger->LogInstructionCount(PlayerId::PLAYER1, 5);
+	async_logger->LogState(&state);
+}
+
+// LogState rethrows an exception thrown logging the previous state, without
+// handing the new state over
+TEST_F(AsyncLoggerTest, LogStateRethrowsPreviousError) {
+	EXPECT_CALL(*logger_mock, LogState(&state))
+	    .WillOnce(Throw(logic_error("There are no soldiers. Cannot log.")));
+
+	async_logger->LogState(&state);
+	EXPECT_THROW(async_logger->LogState(&state), logic_error);
+}
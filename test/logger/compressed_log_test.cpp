@@ -0,0 +1,125 @@
+#include "game.pb.h"
+#include "logger/compressed_log.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace ::testing;
+using namespace logger;
+
+class CompressedLogTest : public testing::Test {
+  protected:
+	ostringstream log_stream;
+
+	// Writes a game of num_turns turns, where turn i's player 1 has money i
+	void WriteGame(int64_t num_turns, int64_t turns_per_block) {
+		CompressedLogWriter writer(log_stream, turns_per_block);
+
+		proto::Game static_frame;
+		static_frame.set_terrain_size(30);
+		writer.WriteStaticFrame(static_frame.SerializeAsString());
+
+		for (int64_t i = 0; i < num_turns; ++i) {
+			proto::Game turn_frame;
+			turn_frame.add_states()->add_money(i);
+			writer.WriteTurnFrame(turn_frame.SerializeAsString());
+		}
+
+		proto::Game final_frame;
+		(*final_frame.mutable_error_map())[0] = "Error";
+		writer.Finish(final_frame.SerializeAsString());
+	}
+};
+
+TEST_F(CompressedLogTest, ReadsWholeGame) {
+	WriteGame(25, 10);
+
+	istringstream read_stream(log_stream.str());
+	CompressedLogReader reader;
+	ASSERT_TRUE(reader.Open(read_stream));
+	ASSERT_EQ(reader.GetNumTurns(), 25);
+
+	proto::Game game;
+	ASSERT_TRUE(reader.ReadGame(game));
+	ASSERT_EQ(game.terrain_size(), 30);
+	ASSERT_EQ(game.error_map().at(0), "Error");
+	ASSERT_EQ(game.states_size(), 25);
+	for (int i = 0; i < 25; ++i) {
+		ASSERT_EQ(game.states(i).money(0), i);
+	}
+}
+
+TEST_F(CompressedLogTest, SeeksToTurn) {
+	WriteGame(25, 10);
+
+	istringstream read_stream(log_stream.str());
+	CompressedLogReader reader;
+	ASSERT_TRUE(reader.Open(read_stream));
+
+	// Each turn is found in its own block, the last of which is short
+	for (int turn = 0; turn < 25; ++turn) {
+		proto::Game game;
+		int64_t first_turn;
+		ASSERT_TRUE(reader.ReadTurns(turn, game, first_turn));
+		ASSERT_EQ(first_turn, turn - turn % 10);
+		ASSERT_EQ(game.states_size(), turn < 20 ? 10 : 5);
+		ASSERT_EQ(game.states(turn - first_turn).money(0), turn);
+	}
+
+	proto::Game game;
+	int64_t first_turn;
+	ASSERT_THROW(reader.ReadTurns(25, game, first_turn), std::out_of_range);
+}
+
+TEST_F(CompressedLogTest, RejectsOtherFiles) {
+	CompressedLogReader reader;
+
+	// A plain protobuf log
+	proto::Game game;
+	game.set_terrain_size(30);
+	istringstream plain_stream(game.SerializeAsString());
+	ASSERT_FALSE(reader.Open(plain_stream));
+
+	// A log cut short
+	WriteGame(25, 10);
+	auto log = log_stream.str();
+	istringstream truncated_stream(log.substr(0, log.size() - 1));
+	ASSERT_FALSE(reader.Open(truncated_stream));
+
+	ASSERT_THROW(CompressedLogWriter(log_stream, 0), std::out_of_range);
+}
+
+TEST_F(CompressedLogTest, RejectsCorruptIndex) {
+	WriteGame(25, 10);
+	auto log = log_stream.str();
+
+	compressed_log::Footer footer;
+	memcpy(&footer, &log[log.size() - sizeof(footer)], sizeof(footer));
+	auto entry_offset = footer.index_offset;
+	compressed_log::BlockEntry entry;
+	memcpy(&entry, &log[entry_offset], sizeof(entry));
+
+	// A block that runs past the index
+	auto corrupt_entry = entry;
+	corrupt_entry.compressed_size = footer.index_offset;
+	auto corrupt_log = log;
+	memcpy(&corrupt_log[entry_offset], &corrupt_entry, sizeof(corrupt_entry));
+	istringstream overlapping_stream(corrupt_log);
+	CompressedLogReader reader;
+	ASSERT_FALSE(reader.Open(overlapping_stream));
+
+	// A block that claims to decompress to far more than it could
+	corrupt_entry = entry;
+	corrupt_entry.uncompressed_size = uint64_t(1) << 60;
+	corrupt_log = log;
+	memcpy(&corrupt_log[entry_offset], &corrupt_entry, sizeof(corrupt_entry));
+	istringstream oversized_stream(corrupt_log);
+	ASSERT_TRUE(reader.Open(oversized_stream));
+	string frames;
+	ASSERT_FALSE(reader.ReadBlock(0, frames));
+	proto::Game game;
+	ASSERT_FALSE(reader.ReadGame(game));
+}
@@ -1,9 +1,14 @@
 #include "constants/constants.h"
 #include "game.pb.h"
 #include "logger/logger.h"
+#include "state/actor/actor_id_allocator.h"
 #include "state/mocks/map_mock.h"
 #include "state/mocks/state_mock.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/util/message_differencer.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "gtest/gtest.h"
+#include <limits>
 #include <sstream>
 
 using namespace std;
@@ -24,7 +29,7 @@ class LoggerTest : public testing::Test {
 };
 
 TEST_F(LoggerTest, WriteReadTest) {
-	Actor::SetActorIdIncrement(0);
+	ActorIdAllocator actor_id_allocator;
 
 	// Attempts to log all state entities, with towers being a focus
 	// Each towersn object serves as the return object for GetAllTowers on
@@ -32,14 +37,16 @@ TEST_F(LoggerTest, WriteReadTest) {
 	// a scenario
 
 	// Initialize one soldier for each team
-	auto *soldier =
-	    new Soldier(Actor::GetNextActorId(), state::PlayerId::PLAYER1,
-	                state::ActorType::SOLDIER, 100, 100,
-	                physics::Vector(20, 20), 5, 5, 40, nullptr, nullptr);
-	auto *soldier2 =
-	    new Soldier(Actor::GetNextActorId(), state::PlayerId::PLAYER2,
-	                state::ActorType::SOLDIER, 100, 100,
-	                physics::Vector(20, 20), 5, 5, 40, nullptr, nullptr);
+	auto *soldier = new Soldier(actor_id_allocator.GetNextActorId(),
+	                            state::PlayerId::PLAYER1,
+	                            state::ActorType::SOLDIER, 100, 100,
+	                            physics::Vector(20, 20), 5, 5, 40, nullptr,
+	                            nullptr);
+	auto *soldier2 = new Soldier(actor_id_allocator.GetNextActorId(),
+	                             state::PlayerId::PLAYER2,
+	                             state::ActorType::SOLDIER, 100, 100,
+	                             physics::Vector(20, 20), 5, 5, 40, nullptr,
+	                             nullptr);
 	vector<vector<Soldier *>> soldiers;
 	vector<Soldier *> player_soldiers;
 	vector<Soldier *> player_soldiers2;
@@ -50,12 +57,12 @@ TEST_F(LoggerTest, WriteReadTest) {
 
 	// BASE TOWERS CASE
 	// Make a tower per team
-	auto *tower =
-	    new Tower(Actor::GetNextActorId(), PlayerId::PLAYER1, ActorType::TOWER,
-	              500, 500, physics::Vector(20, 10), false, 1);
-	auto *tower2 =
-	    new Tower(Actor::GetNextActorId(), PlayerId::PLAYER2, ActorType::TOWER,
-	              500, 500, physics::Vector(5, 5), false, 1);
+	auto *tower = new Tower(actor_id_allocator.GetNextActorId(),
+	                        PlayerId::PLAYER1, ActorType::TOWER, 500, 500,
+	                        physics::Vector(20, 10), false, 1);
+	auto *tower2 = new Tower(actor_id_allocator.GetNextActorId(),
+	                         PlayerId::PLAYER2, ActorType::TOWER, 500, 500,
+	                         physics::Vector(5, 5), false, 1);
 	vector<vector<Tower *>> towers;
 	vector<Tower *> player_towers;
 	vector<Tower *> player_towers2;
@@ -66,12 +73,12 @@ TEST_F(LoggerTest, WriteReadTest) {
 
 	// TOWER BUILD CASE
 	// Make a copy and add two towers (to be built on the second turn)
-	auto *tower3 =
-	    new Tower(Actor::GetNextActorId(), PlayerId::PLAYER1, ActorType::TOWER,
-	              500, 500, physics::Vector(15, 15), false, 1);
-	auto *tower4 =
-	    new Tower(Actor::GetNextActorId(), PlayerId::PLAYER1, ActorType::TOWER,
-	              500, 500, physics::Vector(3, 25), false, 1);
+	auto *tower3 = new Tower(actor_id_allocator.GetNextActorId(),
+	                         PlayerId::PLAYER1, ActorType::TOWER, 500, 500,
+	                         physics::Vector(15, 15), false, 1);
+	auto *tower4 = new Tower(actor_id_allocator.GetNextActorId(),
+	                         PlayerId::PLAYER1, ActorType::TOWER, 500, 500,
+	                         physics::Vector(3, 25), false, 1);
 	vector<vector<Tower *>> towers2 = towers;
 	towers2[0].push_back(tower3);
 	towers2[0].push_back(tower4);
@@ -88,9 +95,9 @@ TEST_F(LoggerTest, WriteReadTest) {
 
 	// SIMULTANEOUS TOWERS BUILD AND DESTROY CASE
 	// Make another copy, destroy both player1 towers and add a new tower
-	auto *tower5 =
-	    new Tower(Actor::GetNextActorId(), PlayerId::PLAYER1, ActorType::TOWER,
-	              500, 500, physics::Vector(25, 3), false, 1);
+	auto *tower5 = new Tower(actor_id_allocator.GetNextActorId(),
+	                         PlayerId::PLAYER1, ActorType::TOWER, 500, 500,
+	                         physics::Vector(25, 3), false, 1);
 	vector<vector<Tower *>> towers5 = towers4;
 	towers5[0].erase(towers5[0].begin(), towers5[0].begin() + 2);
 	towers5[0].push_back(tower5);
@@ -106,36 +113,47 @@ TEST_F(LoggerTest, WriteReadTest) {
 	vector<int64_t> money1 = {400, 500};
 	vector<int64_t> money2 = {300, 600};
 	EXPECT_CALL(*state, GetMoney())
-	    .WillOnce(Return(money1))
-	    .WillRepeatedly(Return(money2));
+	    .WillOnce(ReturnRef(money1))
+	    .WillRepeatedly(ReturnRef(money2));
 
 	// Set state expectations
-	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(Return(soldiers));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
 
 	EXPECT_CALL(*state, GetAllTowers())
-	    .WillOnce(Return(towers))
-	    .WillOnce(Return(towers2))
-	    .WillOnce(Return(towers3))
-	    .WillOnce(Return(towers4))
-	    .WillRepeatedly(Return(towers5));
+	    .WillOnce(ReturnRef(towers))
+	    .WillOnce(ReturnRef(towers2))
+	    .WillOnce(ReturnRef(towers3))
+	    .WillOnce(ReturnRef(towers4))
+	    .WillRepeatedly(ReturnRef(towers5));
+
+	EXPECT_CALL(*state, GetHash())
+	    .WillOnce(Return(1))
+	    .WillRepeatedly(Return(2));
 
 	// Log some instruction counts for the first turn
 	vector<int64_t> inst_counts = {123456, 654321};
 	logger->LogInstructionCount(PlayerId::PLAYER1, inst_counts[0]);
 	logger->LogInstructionCount(PlayerId::PLAYER2, inst_counts[1]);
 
+	// The second player runs past the turn time limit in the first turn
+	logger->LogTurnTime(PlayerId::PLAYER1, 250, false);
+	logger->LogTurnTime(PlayerId::PLAYER2, 5000, true);
+
 	// Log some errors for the first turn
-	logger->LogError(PlayerId::PLAYER1, ErrorType::INVALID_TERRITORY,
-	                 "Error 1");
-	logger->LogError(PlayerId::PLAYER1, ErrorType::INVALID_TERRITORY,
-	                 "Error 2");
-	logger->LogError(PlayerId::PLAYER2, ErrorType::INVALID_TERRITORY,
-	                 "Error 3");
-	logger->LogError(PlayerId::PLAYER2, ErrorType::INVALID_TERRITORY,
-	                 "Error 4");
-
-	// Run 3 turns, update HP, run the remaining turns
+	logger->LogError(PlayerId::PLAYER1, ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
+	                 1, -1);
+	logger->LogError(PlayerId::PLAYER1, ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
+	                 2, -1);
+	logger->LogError(PlayerId::PLAYER2, ErrorType::NO_ATTACK_RAZED_TOWER, -1,
+	                 3);
+	logger->LogError(PlayerId::PLAYER2, ErrorType::NO_ACTION_BY_DEAD_SOLDIER,
+	                 1, -1);
+
+	// Run 3 turns, with a command in the second, update HP, run the
+	// remaining turns
 	logger->LogState(state.get());
+	logger->LogCommand(PlayerId::PLAYER2, CommandType::BUILD_TOWER, -1, -1,
+	                   physics::Vector(4, 1));
 	logger->LogState(state.get());
 	logger->LogState(state.get());
 	tower2->SetHp(1);
@@ -164,6 +182,22 @@ TEST_F(LoggerTest, WriteReadTest) {
 	ASSERT_EQ(game->states(0).soldiers_size(), 2);
 	ASSERT_EQ(game->states(1).soldiers_size(), 2);
 
+	// Check if the state hashes are there
+	ASSERT_EQ(game->states(0).state_hash(), 1);
+	ASSERT_EQ(game->states(1).state_hash(), 2);
+
+	// Check if the command is logged with the state that follows it
+	ASSERT_EQ(game->states(0).commands_size(), 0);
+	ASSERT_EQ(game->states(1).commands_size(), 1);
+	ASSERT_EQ(game->states(2).commands_size(), 0);
+	auto &command = game->states(1).commands(0);
+	ASSERT_EQ(command.player_id(), (int)PlayerId::PLAYER2);
+	ASSERT_EQ(command.type(), proto::BUILD_TOWER);
+	ASSERT_EQ(command.actor_id(), -1);
+	ASSERT_EQ(command.target_id(), -1);
+	ASSERT_EQ(command.x(), 4);
+	ASSERT_EQ(command.y(), 1);
+
 	// Check if instruction count is there
 	ASSERT_EQ(game->states(0).instruction_counts_size(), 2);
 	ASSERT_EQ(game->states(0).instruction_counts(0), inst_counts[0]);
@@ -174,8 +208,17 @@ TEST_F(LoggerTest, WriteReadTest) {
 	ASSERT_EQ(game->states(1).instruction_counts(1), 0);
 	ASSERT_EQ(game->states(1).instruction_counts(0), 0);
 
+	// Check the turn times, which are also cleared on the next turn
+	ASSERT_EQ(game->states(0).turn_times_us_size(), 2);
+	ASSERT_EQ(game->states(0).turn_times_us(0), 250);
+	ASSERT_EQ(game->states(0).turn_times_us(1), 5000);
+	ASSERT_FALSE(game->states(0).turns_timed_out(0));
+	ASSERT_TRUE(game->states(0).turns_timed_out(1));
+	ASSERT_EQ(game->states(1).turn_times_us(1), 0);
+	ASSERT_FALSE(game->states(1).turns_timed_out(1));
+
 	// Check if the errors got logged on the first turn
-	// Error codes should increment from 0
+	// Error codes should increment from 0, a repeated error reuses its code
 	// Player 1 errors
 	ASSERT_EQ(game->states(0).player_errors(0).errors_size(), 2);
 	ASSERT_EQ(game->states(0).player_errors(0).errors(0), 0);
@@ -183,18 +226,20 @@ TEST_F(LoggerTest, WriteReadTest) {
 	// Player 2 errors
 	ASSERT_EQ(game->states(0).player_errors(1).errors_size(), 2);
 	ASSERT_EQ(game->states(0).player_errors(1).errors(0), 2);
-	ASSERT_EQ(game->states(0).player_errors(1).errors(1), 3);
+	ASSERT_EQ(game->states(0).player_errors(1).errors(1), 0);
 
 	// Check if the mapping got set and the message string matches
 	auto error_map = *game->mutable_error_map();
+	ASSERT_EQ(error_map.size(), 3);
 	ASSERT_EQ(error_map[game->states(0).player_errors(0).errors(0)],
-	          "INVALID_TERRITORY: Error 1");
+	          "NO_ACTION_BY_DEAD_SOLDIER: Soldier with id 1 must be alive in "
+	          "order to act");
 	ASSERT_EQ(error_map[game->states(0).player_errors(0).errors(1)],
-	          "INVALID_TERRITORY: Error 2");
+	          "NO_ACTION_BY_DEAD_SOLDIER: Soldier with id 2 must be alive in "
+	          "order to act");
 	ASSERT_EQ(error_map[game->states(0).player_errors(1).errors(0)],
-	          "INVALID_TERRITORY: Error 3");
-	ASSERT_EQ(error_map[game->states(0).player_errors(1).errors(1)],
-	          "INVALID_TERRITORY: Error 4");
+	          "NO_ATTACK_RAZED_TOWER: Can't attack tower with id 3 as it has "
+	          "been destroyed by the opponent");
 
 	// BASE TOWERS CASE
 	// Check if both towers are there in the first turn
@@ -236,3 +281,281 @@ TEST_F(LoggerTest, WriteReadTest) {
 	delete tower4;
 	delete tower5;
 }
+
+TEST_F(LoggerTest, StreamedLogMatchesWholeGame) {
+	ActorIdAllocator actor_id_allocator;
+
+	auto *soldier = new Soldier(actor_id_allocator.GetNextActorId(),
+	                            state::PlayerId::PLAYER1,
+	                            state::ActorType::SOLDIER, 100, 100,
+	                            physics::Vector(20, 20), 5, 5, 40, nullptr,
+	                            nullptr);
+	auto *soldier2 = new Soldier(actor_id_allocator.GetNextActorId(),
+	                             state::PlayerId::PLAYER2,
+	                             state::ActorType::SOLDIER, 100, 100,
+	                             physics::Vector(20, 20), 5, 5, 40, nullptr,
+	                             nullptr);
+	auto *tower = new Tower(actor_id_allocator.GetNextActorId(),
+	                        PlayerId::PLAYER1, ActorType::TOWER, 500, 500,
+	                        physics::Vector(20, 10), false, 1);
+	auto *tower2 = new Tower(actor_id_allocator.GetNextActorId(),
+	                         PlayerId::PLAYER2, ActorType::TOWER, 500, 500,
+	                         physics::Vector(10, 20), false, 1);
+	vector<vector<Soldier *>> soldiers = {{soldier}, {soldier2}};
+	vector<vector<Tower *>> towers = {{tower}, {tower2}};
+	vector<int64_t> money = {400, 500};
+
+	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
+	EXPECT_CALL(*map, GetSize()).WillRepeatedly(Return(30));
+	EXPECT_CALL(*map, GetElementSize()).WillRepeatedly(Return(50));
+	EXPECT_CALL(*state, GetMoney()).WillRepeatedly(ReturnRef(money));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
+	EXPECT_CALL(*state, GetHash()).WillRepeatedly(Return(0));
+
+	// Plays the same three turns on a logger, returning what it wrote
+	auto run_game = [&](LogWriteMode write_mode, int64_t turns_per_block,
+	                    int64_t turns_per_keyframe, bool is_arena_allocated) {
+		Logger game_logger(PLAYER_INSTRUCTION_LIMIT_TURN,
+		                   PLAYER_INSTRUCTION_LIMIT_GAME, write_mode,
+		                   turns_per_block, turns_per_keyframe,
+		                   is_arena_allocated);
+		ostringstream str_stream;
+		game_logger.StartStream(str_stream);
+
+		tower->SetHp(500);
+		for (int turn = 0; turn < 3; ++turn) {
+			game_logger.LogInstructionCount(PlayerId::PLAYER1, turn);
+			game_logger.LogError(PlayerId::PLAYER2,
+			                     ErrorType::NO_MULTIPLE_TOWER_TASKS, turn % 2,
+			                     -1);
+			game_logger.LogState(state.get());
+			tower->SetHp(tower->GetHp() - 100);
+
+			// Without a writer thread, each turn is out as soon as it is
+			// logged
+			if (write_mode == LogWriteMode::STREAM && turns_per_block == 0) {
+				auto game = make_unique<proto::Game>();
+				game->ParseFromString(str_stream.str());
+				EXPECT_EQ(game->states_size(), turn + 1);
+				EXPECT_EQ(game->terrain_size(), 30);
+			}
+		}
+
+		game_logger.LogFinalGameParams();
+		game_logger.WriteGame(str_stream);
+		return str_stream.str();
+	};
+
+	auto whole_game = make_unique<proto::Game>();
+	auto whole_game_log = run_game(LogWriteMode::WHOLE_GAME, 0, 0, false);
+	ASSERT_TRUE(whole_game->ParseFromString(whole_game_log));
+	ASSERT_EQ(whole_game->states_size(), 3);
+	ASSERT_EQ(whole_game->error_map_size(), 2);
+
+	// Allocating the logs on an arena changes nothing in them
+	auto arena_game = make_unique<proto::Game>();
+	ASSERT_TRUE(arena_game->ParseFromString(
+	    run_game(LogWriteMode::WHOLE_GAME, 0, 0, true)));
+	ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(
+	    *whole_game, *arena_game));
+
+	for (auto write_mode :
+	     {LogWriteMode::STREAM, LogWriteMode::STREAM_ON_THREAD}) {
+		auto streamed_log = run_game(write_mode, 0, 0, false);
+
+		// The log parses as the same game
+		auto streamed_game = make_unique<proto::Game>();
+		ASSERT_TRUE(streamed_game->ParseFromString(streamed_log));
+		ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(
+		    *whole_game, *streamed_game));
+
+		// Frame by frame, the static fields come first, then the states in
+		// order, then the error map
+		google::protobuf::io::CodedInputStream input(
+		    reinterpret_cast<const uint8_t *>(streamed_log.data()),
+		    streamed_log.size());
+		vector<int> field_numbers;
+		while (auto tag = input.ReadTag()) {
+			auto field_number =
+			    google::protobuf::internal::WireFormatLite::GetTagFieldNumber(
+			        tag);
+			if (field_numbers.empty() || field_numbers.back() != field_number) {
+				field_numbers.push_back(field_number);
+			}
+			ASSERT_TRUE(google::protobuf::internal::WireFormatLite::SkipField(
+			    &input, tag));
+		}
+		ASSERT_EQ(field_numbers,
+		          vector<int>({proto::Game::kTowerRangesFieldNumber,
+		                       proto::Game::kTowerMaxHpsFieldNumber,
+		                       proto::Game::kSoldierMaxHpFieldNumber,
+		                       proto::Game::kInstLimitTurnFieldNumber,
+		                       proto::Game::kInstLimitGameFieldNumber,
+		                       proto::Game::kTerrainSizeFieldNumber,
+		                       proto::Game::kTerrainElementSizeFieldNumber,
+		                       proto::Game::kStatesFieldNumber,
+		                       proto::Game::kErrorMapFieldNumber}));
+
+		// Compressed in blocks of two turns, each starting on a keyframe, it
+		// reads back the same as a game with keyframes every two turns
+		auto keyframed_game = make_unique<proto::Game>();
+		ASSERT_TRUE(keyframed_game->ParseFromString(
+		    run_game(LogWriteMode::WHOLE_GAME, 0, 2, false)));
+		istringstream compressed_log(run_game(write_mode, 2, 2, true));
+		CompressedLogReader reader;
+		ASSERT_TRUE(reader.Open(compressed_log));
+		ASSERT_EQ(reader.GetNumTurns(), 3);
+		auto compressed_game = make_unique<proto::Game>();
+		ASSERT_TRUE(reader.ReadGame(*compressed_game));
+		ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(
+		    *keyframed_game, *compressed_game));
+	}
+
+	delete soldier;
+	delete soldier2;
+	delete tower;
+	delete tower2;
+}
+
+TEST_F(LoggerTest, SoldierDeltasBetweenKeyframes) {
+	ActorIdAllocator actor_id_allocator;
+
+	vector<vector<Soldier *>> soldiers(2);
+	for (int i = 0; i < 4; ++i) {
+		soldiers[i % 2].push_back(new Soldier(
+		    actor_id_allocator.GetNextActorId(),
+		    static_cast<PlayerId>(i % 2), state::ActorType::SOLDIER, 100, 100,
+		    physics::Vector(20, 20), 5, 5, 40, nullptr, nullptr));
+	}
+	auto *tower = new Tower(actor_id_allocator.GetNextActorId(),
+	                        PlayerId::PLAYER1, ActorType::TOWER, 500, 500,
+	                        physics::Vector(20, 10), false, 1);
+	auto *tower2 = new Tower(actor_id_allocator.GetNextActorId(),
+	                         PlayerId::PLAYER2, ActorType::TOWER, 500, 500,
+	                         physics::Vector(10, 20), false, 1);
+	vector<vector<Tower *>> towers = {{tower}, {tower2}};
+	vector<int64_t> money = {400, 500};
+
+	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
+	EXPECT_CALL(*map, GetSize()).WillRepeatedly(Return(30));
+	EXPECT_CALL(*map, GetElementSize()).WillRepeatedly(Return(50));
+	EXPECT_CALL(*state, GetMoney()).WillRepeatedly(ReturnRef(money));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
+	EXPECT_CALL(*state, GetHash()).WillRepeatedly(Return(0));
+
+	// Plays the same seven turns on a logger, in which the first soldier
+	// walks and the last loses hp every other turn
+	auto run_game = [&](int64_t turns_per_keyframe) {
+		Logger game_logger(PLAYER_INSTRUCTION_LIMIT_TURN,
+		                   PLAYER_INSTRUCTION_LIMIT_GAME,
+		                   LogWriteMode::WHOLE_GAME, 0, turns_per_keyframe);
+		soldiers[0][0]->SetPosition(physics::Vector(20, 20));
+		soldiers[1][1]->SetHp(100);
+		for (int turn = 0; turn < 7; ++turn) {
+			game_logger.LogState(state.get());
+			soldiers[0][0]->SetPosition(physics::Vector(21 + turn, 20));
+			if (turn % 2 == 0) {
+				soldiers[1][1]->SetHp(soldiers[1][1]->GetHp() - 10);
+			}
+		}
+
+		ostringstream str_stream;
+		game_logger.WriteGame(str_stream);
+		auto game = make_unique<proto::Game>();
+		game->ParseFromString(str_stream.str());
+		return game;
+	};
+
+	auto full_game = run_game(0);
+	auto delta_game = run_game(3);
+
+	// Keyframes fall every three turns, and hold everything
+	ASSERT_EQ(delta_game->states_size(), 7);
+	for (int turn = 0; turn < 7; ++turn) {
+		auto &game_state = delta_game->states(turn);
+		ASSERT_EQ(game_state.is_keyframe(), turn % 3 == 0);
+		ASSERT_EQ(game_state.is_soldier_delta(), turn % 3 != 0);
+		if (game_state.is_keyframe()) {
+			ASSERT_EQ(game_state.soldiers_size(), 4);
+			ASSERT_EQ(game_state.towers_size(), 2);
+		}
+	}
+	ASSERT_FALSE(full_game->states(3).is_keyframe());
+	ASSERT_EQ(full_game->states(3).towers_size(), 0);
+
+	// Between them only the fields that changed are logged. Soldiers are
+	// indexed across both players, so the last soldier is index 3
+	auto &delta_state = delta_game->states(1);
+	ASSERT_EQ(delta_state.soldiers_size(), 2);
+	ASSERT_EQ(delta_state.soldiers(0).index(), 0);
+	ASSERT_EQ(delta_state.soldiers(0).changed_fields(),
+	          proto::POSITION_CHANGED);
+	ASSERT_EQ(delta_state.soldiers(1).index(), 3);
+	ASSERT_EQ(delta_state.soldiers(1).changed_fields(), proto::HP_CHANGED);
+	ASSERT_EQ(delta_state.soldiers(1).hp(), 90);
+	ASSERT_EQ(delta_game->states(2).soldiers_size(), 1);
+
+	// Applying the deltas gives back every soldier of every turn
+	vector<proto::Soldier> replayed_soldiers;
+	for (int turn = 0; turn < 7; ++turn) {
+		auto &game_state = delta_game->states(turn);
+		if (!game_state.is_soldier_delta()) {
+			replayed_soldiers.assign(game_state.soldiers().begin(),
+			                         game_state.soldiers().end());
+		}
+		for (auto &soldier : game_state.soldiers()) {
+			if (!game_state.is_soldier_delta()) {
+				break;
+			}
+			auto &replayed_soldier = replayed_soldiers[soldier.index()];
+			if (soldier.changed_fields() & proto::HP_CHANGED) {
+				replayed_soldier.set_hp(soldier.hp());
+			}
+			if (soldier.changed_fields() & proto::POSITION_CHANGED) {
+				replayed_soldier.set_x(soldier.x());
+				replayed_soldier.set_y(soldier.y());
+			}
+		}
+
+		auto &full_soldiers = full_game->states(turn).soldiers();
+		ASSERT_EQ(replayed_soldiers.size(), full_soldiers.size());
+		for (int i = 0; i < full_soldiers.size(); ++i) {
+			ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(
+			    replayed_soldiers[i], full_soldiers.Get(i)));
+		}
+	}
+
+	for (auto &player_soldiers : soldiers) {
+		for (auto *soldier : player_soldiers) {
+			delete soldier;
+		}
+	}
+	delete tower;
+	delete tower2;
+}
+
+// Errors for soldiers sent off the map say where they were sent, even when
+// it isn't a finite position
+TEST_F(LoggerTest, InvalidPositionMessage) {
+	logger->LogError(PlayerId::PLAYER1, ErrorType::INVALID_POSITION, 4,
+	                 PackErrorPosition(physics::Vector(-10.5, 2500)));
+	const double inf = numeric_limits<double>::infinity();
+	logger->LogError(PlayerId::PLAYER2, ErrorType::INVALID_POSITION, 7,
+	                 PackErrorPosition(physics::Vector(1e300, -inf)));
+	logger->LogFinalGameParams();
+
+	ostringstream str_stream;
+	logger->WriteGame(str_stream);
+	auto game = make_unique<proto::Game>();
+	game->ParseFromString(str_stream.str());
+
+	auto error_map = *game->mutable_error_map();
+	ASSERT_EQ(error_map.size(), 2);
+	EXPECT_EQ(error_map[0], "INVALID_POSITION: Soldier with id 4 cannot move "
+	                        "to position (-10.500000,2500.000000) outside the "
+	                        "map");
+	EXPECT_EQ(error_map[1], "INVALID_POSITION: Soldier with id 7 cannot move "
+	                        "to position (inf,-inf) outside the map");
+}
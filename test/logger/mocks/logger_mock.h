@@ -2,6 +2,7 @@
 #define TEST_LOGGER_MOCKS_LOGGER_H
 
 #include "gmock/gmock.h"
+#include "logger/command_type.h"
 #include "logger/error_type.h"
 #include "logger/interfaces/i_logger.h"
 #include "state/interfaces/i_state.h"
@@ -16,9 +17,13 @@ using namespace state;
 
 class LoggerMock : public ILogger {
   public:
+	MOCK_METHOD1(StartStream, void(std::ostream &));
 	MOCK_METHOD1(LogState, void(IState *));
 	MOCK_METHOD2(LogInstructionCount, void(PlayerId, int64_t));
-	MOCK_METHOD3(LogError, void(PlayerId, ErrorType, string));
+	MOCK_METHOD3(LogTurnTime, void(PlayerId, int64_t, bool));
+	MOCK_METHOD4(LogError, void(PlayerId, ErrorType, int64_t, int64_t));
+	MOCK_METHOD5(LogCommand, void(PlayerId, CommandType, int64_t, int64_t,
+	                              physics::Vector));
 	MOCK_METHOD0(LogFinalGameParams, void());
 	MOCK_METHOD1(WriteGame, void(std::ostream &));
 };
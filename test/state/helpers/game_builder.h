@@ -0,0 +1,120 @@
+/**
+ * @file game_builder.h
+ * Builds whole games on an all land map, for tests and benchmarks to play
+ */
+
+#ifndef STATE_HELPERS_GAME_BUILDER_H
+#define STATE_HELPERS_GAME_BUILDER_H
+
+#include "constants/constants.h"
+#include "physics/vector.h"
+#include "state/actor/actor_id_allocator.h"
+#include "state/map/map.h"
+#include "state/path_planner/simple_path_planner.h"
+#include "state/state.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Settings of a game made by BuildGame, the game's constants by default
+ */
+struct GameSettings {
+	int64_t map_size = MAP_SIZE;
+
+	int64_t element_size = MAP_ELEMENT_SIZE;
+
+	/**
+	 * Soldiers per player
+	 */
+	int64_t num_soldiers = NUM_SOLDIERS;
+
+	/**
+	 * Positions of the base towers, where the soldiers start too, indexed by
+	 * PlayerId
+	 */
+	std::vector<physics::Vector> base_positions = BASE_TOWER_POSITIONS;
+
+	int64_t soldier_hp = SOLDIER_MAX_HP;
+
+	int64_t soldier_speed = SOLDIER_SPEED;
+
+	int64_t soldier_attack_range = SOLDIER_ATTACK_RANGE;
+
+	int64_t soldier_attack_damage = SOLDIER_ATTACK_DAMAGE;
+
+	int64_t base_tower_hp = state::Tower::max_hp_levels[0];
+
+	int64_t money_start = MONEY_START;
+
+	int64_t money_max = MONEY_MAX;
+
+	std::vector<int64_t> tower_kill_rewards = TOWER_KILL_REWARD_AMOUNTS;
+
+	int64_t soldier_kill_reward = SOLDIER_KILL_REWARD_AMOUNT;
+
+	std::vector<int64_t> tower_suicide_rewards = TOWER_SUICIDE_REWARD_AMOUNT;
+};
+
+/**
+ * Returns a new game with a base tower and a set of soldiers for each player
+ *
+ * @param[in]  settings  Settings of the game
+ */
+inline std::unique_ptr<state::State>
+BuildGame(const GameSettings &settings = GameSettings()) {
+	using namespace state;
+
+	auto actor_id_allocator = std::make_unique<ActorIdAllocator>();
+
+	std::vector<std::vector<MapElement>> grid;
+	for (int i = 0; i < settings.map_size; ++i) {
+		std::vector<MapElement> row;
+		for (int j = 0; j < settings.map_size; ++j) {
+			row.push_back(MapElement(physics::Vector(i * settings.element_size,
+			                                         j * settings.element_size),
+			                         TerrainType::LAND));
+		}
+		grid.push_back(row);
+	}
+	auto map = std::make_unique<Map>(grid, settings.element_size);
+	auto path_planner = std::make_unique<SimplePathPlanner>(map.get());
+	auto money_manager = std::make_unique<MoneyManager>(
+	    std::vector<int64_t>(2, settings.money_start), settings.money_max,
+	    settings.tower_kill_rewards, settings.soldier_kill_reward,
+	    settings.tower_suicide_rewards);
+
+	// State tells soldiers from towers by id, so soldiers get the first ids
+	std::vector<std::vector<std::unique_ptr<Soldier>>> soldiers(2);
+	for (int player_id = 0; player_id < 2; ++player_id) {
+		for (int i = 0; i < settings.num_soldiers; ++i) {
+			soldiers[player_id].push_back(std::make_unique<Soldier>(
+			    actor_id_allocator->GetNextActorId(),
+			    static_cast<PlayerId>(player_id), ActorType::SOLDIER,
+			    settings.soldier_hp, settings.soldier_hp,
+			    settings.base_positions[player_id], settings.soldier_speed,
+			    settings.soldier_attack_range, settings.soldier_attack_damage,
+			    path_planner.get(), money_manager.get()));
+		}
+	}
+
+	std::vector<std::unique_ptr<TowerManager>> tower_managers;
+	for (int player_id = 0; player_id < 2; ++player_id) {
+		std::vector<std::unique_ptr<Tower>> towers;
+		towers.push_back(std::make_unique<Tower>(
+		    actor_id_allocator->GetNextActorId(),
+		    static_cast<PlayerId>(player_id), ActorType::TOWER,
+		    settings.base_tower_hp, settings.base_tower_hp,
+		    settings.base_positions[player_id], true, 1));
+		tower_managers.push_back(std::make_unique<TowerManager>(
+		    std::move(towers), static_cast<PlayerId>(player_id),
+		    money_manager.get(), map.get(), actor_id_allocator.get()));
+	}
+
+	return std::make_unique<State>(
+	    std::move(soldiers), std::move(map), std::move(money_manager),
+	    std::move(tower_managers), std::move(path_planner),
+	    std::move(actor_id_allocator));
+}
+
+#endif
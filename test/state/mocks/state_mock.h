@@ -14,11 +14,18 @@ using namespace physics;
 
 class StateMock : public IState {
   public:
-	MOCK_METHOD0(GetAllSoldiers, const vector<vector<Soldier *>>());
-	MOCK_METHOD0(GetAllTowers, const vector<vector<Tower *>>());
-	MOCK_METHOD0(GetMoney, vector<int64_t>());
+	MOCK_METHOD0(GetAllSoldiers, const vector<vector<Soldier *>> &());
+	MOCK_METHOD0(GetAllTowers, const vector<vector<Tower *>> &());
+	MOCK_METHOD0(GetMoney, const vector<int64_t> &());
 	MOCK_METHOD0(GetMap, IMap *());
+	MOCK_METHOD0(GetDirtyMapOffsets, const vector<Vector> &());
+	MOCK_METHOD0(ClearDirtyMapOffsets, void());
+	MOCK_METHOD4(GetSoldiersInRange,
+	             void(PlayerId, Vector, double, vector<Soldier *> &));
+	MOCK_METHOD4(GetNearestSoldiers,
+	             void(PlayerId, Vector, int64_t, vector<Soldier *> &));
 	MOCK_METHOD0(GetScores, vector<int64_t>());
+	MOCK_METHOD0(GetHash, uint64_t());
 	MOCK_METHOD3(MoveSoldier, void(PlayerId, int64_t, Vector));
 	MOCK_METHOD3(AttackActor, void(PlayerId, int64_t, int64_t));
 	MOCK_METHOD2(BuildTower, void(PlayerId, Vector));
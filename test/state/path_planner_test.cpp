@@ -148,3 +148,53 @@ TEST_F(PathPlannerTest, InvalidPathsTests) {
 	                                       ),
 	             std::out_of_range);
 }
+
+TEST_F(PathPlannerTest, EvictedPathsAreFoundAgain) {
+	// A planner that keeps a single destination has to find paths again on
+	// almost every call, and should give the same answers
+	auto small_path_planner = make_unique<PathPlanner>(map.get(), 1);
+
+	for (int i = 0; i < map_size * map_size; ++i) {
+		for (int j = 0; j < map_size * map_size; ++j) {
+			Vector source(i / map_size, i % map_size);
+			Vector destination(j / map_size, j % map_size);
+			if (map->GetElementByOffset(source).GetTerrainType() !=
+			        TerrainType::LAND ||
+			    map->GetElementByOffset(destination).GetTerrainType() !=
+			        TerrainType::LAND) {
+				continue;
+			}
+
+			ASSERT_EQ(small_path_planner->GetNextNode(source, destination),
+			          path_planner->GetNextNode(source, destination));
+		}
+	}
+
+	EXPECT_THROW(PathPlanner(map.get(), 0), std::out_of_range);
+}
+
+TEST_F(PathPlannerTest, PrecomputedPathsMatchLazyPaths) {
+	auto precomputed_path_planner = make_unique<PathPlanner>(map.get());
+
+	vector<Vector> destinations;
+	for (int i = 0; i < map_size * map_size; ++i) {
+		Vector destination(i / map_size, i % map_size);
+		if (map->GetElementByOffset(destination).GetTerrainType() ==
+		    TerrainType::LAND) {
+			destinations.push_back(destination);
+		}
+	}
+	precomputed_path_planner->PrecomputePaths(destinations, 4);
+
+	for (auto &source : destinations) {
+		for (auto &destination : destinations) {
+			ASSERT_EQ(
+			    precomputed_path_planner->GetNextNode(source, destination),
+			    path_planner->GetNextNode(source, destination));
+		}
+	}
+
+	// Water is not a valid destination
+	EXPECT_THROW(precomputed_path_planner->PrecomputePaths({Vector(1, 1)}, 2),
+	             std::out_of_range);
+}
@@ -0,0 +1,116 @@
+#include "state/map/map.h"
+#include "state/path_planner/path_planner.h"
+#include "state/path_planner/path_table.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <unistd.h>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+using namespace testing;
+
+class PathTableTest : public Test {
+  protected:
+	unique_ptr<Map> map;
+
+	int map_size;
+
+	string path_table_path;
+
+	PathTableTest()
+	    : map(BuildMap(1)), map_size(7),
+	      path_table_path(TempDir() + "path_table_test_" +
+	                      to_string(getpid()) + ".bin") {}
+
+	~PathTableTest() { remove(path_table_path.c_str()); }
+
+	// Map of land with a wall of water down column wall_x, open at the top
+	unique_ptr<Map> BuildMap(int wall_x) {
+		vector<vector<MapElement>> grid;
+		for (int i = 0; i < 7; ++i) {
+			vector<MapElement> row;
+			for (int j = 0; j < 7; ++j) {
+				row.push_back(MapElement(Vector(i * 5, j * 5),
+				                         (i == wall_x && j > 0)
+				                             ? TerrainType::WATER
+				                             : TerrainType::LAND));
+			}
+			grid.push_back(row);
+		}
+		return make_unique<Map>(grid, 5);
+	}
+
+	// Checks that a planner agrees with one that finds paths lazily
+	void ExpectSamePaths(PathPlanner *path_planner, Map *map) {
+		PathPlanner lazy_path_planner(map);
+		for (int i = 0; i < map_size * map_size; ++i) {
+			for (int j = 0; j < map_size * map_size; ++j) {
+				Vector source(i / map_size, i % map_size);
+				Vector destination(j / map_size, j % map_size);
+				if (map->GetElementByOffset(source).GetTerrainType() !=
+				        TerrainType::LAND ||
+				    map->GetElementByOffset(destination).GetTerrainType() !=
+				        TerrainType::LAND) {
+					continue;
+				}
+				ASSERT_EQ(path_planner->GetNextNode(source, destination),
+				          lazy_path_planner.GetNextNode(source, destination));
+			}
+		}
+	}
+};
+
+TEST_F(PathTableTest, MissingTableIsWrittenAndShared) {
+	PathTable path_table;
+	ASSERT_FALSE(path_table.Open(path_table_path, map.get()));
+
+	// The first planner writes the table, the second maps it
+	PathPlanner first_path_planner(map.get(), path_table_path, 2);
+	ASSERT_TRUE(path_table.Open(path_table_path, map.get()));
+	ExpectSamePaths(&first_path_planner, map.get());
+
+	PathPlanner second_path_planner(map.get(), path_table_path, 2);
+	ExpectSamePaths(&second_path_planner, map.get());
+}
+
+TEST_F(PathTableTest, StaleTableIsRebuilt) {
+	// A table for a different terrain must not be used
+	auto other_map = BuildMap(3);
+	ASSERT_NE(PathTable::HashTerrain(map.get()),
+	          PathTable::HashTerrain(other_map.get()));
+
+	{ PathPlanner path_planner(other_map.get(), path_table_path, 1); }
+	PathTable path_table;
+	ASSERT_FALSE(path_table.Open(path_table_path, map.get()));
+
+	PathPlanner path_planner(map.get(), path_table_path, 1);
+	ExpectSamePaths(&path_planner, map.get());
+	ASSERT_TRUE(path_table.Open(path_table_path, map.get()));
+
+	// Nor a truncated one
+	ofstream(path_table_path, ios::binary) << "CCPATHS";
+	ASSERT_FALSE(path_table.Open(path_table_path, map.get()));
+}
+
+TEST_F(PathTableTest, CorruptTableIsRebuilt) {
+	// A table of the right size and header, with one element off the map
+	int num_elements = map_size * map_size;
+	vector<uint16_t> next_nodes(num_elements * num_elements, 0);
+	next_nodes.back() = num_elements;
+	ASSERT_TRUE(PathTable::Write(path_table_path, map.get(), next_nodes));
+
+	PathTable path_table;
+	ASSERT_FALSE(path_table.Open(path_table_path, map.get()));
+
+	PathPlanner path_planner(map.get(), path_table_path, 1);
+	ExpectSamePaths(&path_planner, map.get());
+	ASSERT_TRUE(path_table.Open(path_table_path, map.get()));
+}
+
+TEST_F(PathTableTest, UnwritableTableFallsBackToMemory) {
+	PathPlanner path_planner(map.get(), "/nonexistent/dir/paths.bin", 1);
+	ExpectSamePaths(&path_planner, map.get());
+}
@@ -0,0 +1,77 @@
+#include "state/profiler/profiler.h"
+#include "gtest/gtest.h"
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace state;
+
+TEST(ProfilerTest, HistogramAndQuantiles) {
+	Profiler profiler;
+
+	// 90 short runs, 10 long ones
+	for (int i = 0; i < 90; ++i) {
+		profiler.Record(ProfilePhase::LOG_STATE, 100);
+	}
+	for (int i = 0; i < 10; ++i) {
+		profiler.Record(ProfilePhase::LOG_STATE, 5000);
+	}
+
+	auto &stats = profiler.GetPhaseStats(ProfilePhase::LOG_STATE);
+	ASSERT_EQ(stats.count, 100);
+	ASSERT_EQ(stats.total_ns, 90 * 100 + 10 * 5000);
+	ASSERT_EQ(stats.min_ns, 100);
+	ASSERT_EQ(stats.max_ns, 5000);
+
+	// 100 is in [64, 128), 5000 in [4096, 8192)
+	ASSERT_EQ(stats.buckets[7], 90);
+	ASSERT_EQ(stats.buckets[13], 10);
+
+	ASSERT_EQ(profiler.GetQuantile(ProfilePhase::LOG_STATE, 0.5), 128);
+	ASSERT_EQ(profiler.GetQuantile(ProfilePhase::LOG_STATE, 0.99), 5000);
+	ASSERT_EQ(profiler.GetQuantile(ProfilePhase::TURN, 0.5), 0);
+}
+
+TEST(ProfilerTest, TimersRecordIntoActiveProfiler) {
+	Profiler profiler;
+
+	// Nothing is recorded without an active profiler
+	{ PhaseTimer timer(ProfilePhase::TURN); }
+
+	Profiler::SetActive(&profiler);
+	{
+		PhaseTimer timer(ProfilePhase::TURN);
+		timer.Stop();
+		// Stopping a second time, and destruction, record nothing more
+		timer.Stop();
+	}
+
+	// Other threads have no active profiler
+	thread other_thread([] {
+		ASSERT_EQ(Profiler::GetActive(), nullptr);
+		PhaseTimer timer(ProfilePhase::TURN);
+	});
+	other_thread.join();
+	Profiler::SetActive(nullptr);
+
+	ASSERT_EQ(profiler.GetPhaseStats(ProfilePhase::TURN).count, 1);
+}
+
+TEST(ProfilerTest, WriteJson) {
+	Profiler profiler;
+	profiler.Record(ProfilePhase::UPDATE_SOLDIERS, 1000);
+	profiler.Record(ProfilePhase::UPDATE_SOLDIERS, 3000);
+
+	ostringstream json_stream;
+	profiler.WriteJson(json_stream);
+	auto json = json_stream.str();
+
+	ASSERT_NE(json.find("\"update_soldiers\": {\"count\": 2, \"total_ns\": "
+	                    "4000, \"mean_ns\": 2000, \"min_ns\": 1000, "
+	                    "\"max_ns\": 3000"),
+	          string::npos);
+	ASSERT_NE(json.find("\"histogram\": [[1024, 1], [4096, 1]]"),
+	          string::npos);
+	ASSERT_NE(json.find("\"log_state\": {\"count\": 0"), string::npos);
+}
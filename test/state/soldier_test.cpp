@@ -130,7 +130,7 @@ TEST_F(SoldierTest, Movement) {
 
 TEST_F(SoldierTest, Attack) {
 	auto *target_tower = new Tower(2, PlayerId::PLAYER2, ActorType::TOWER, 500,
-	                               500, physics::Vector(20, 30), false, 0);
+	                               500, physics::Vector(20, 30), false, 1);
 	soldier->Attack(target_tower);
 	soldier->Update();
 	soldier->LateUpdate();
@@ -210,7 +210,7 @@ TEST_F(SoldierTest, MovingEnemyPursuit) {
 
 TEST_F(SoldierTest, MoveThenAttack) {
 	auto *target_tower = new Tower(2, PlayerId::PLAYER2, ActorType::TOWER, 500,
-	                               500, physics::Vector(20, 30), false, 0);
+	                               500, physics::Vector(20, 30), false, 1);
 
 	// Let the soldier move for a few turns, and then switch it to attack
 	soldier->Move(Vector(0, 40));
@@ -249,7 +249,7 @@ TEST_F(SoldierTest, MoveThenAttack) {
 
 TEST_F(SoldierTest, AttackThenMove) {
 	auto *target_tower = new Tower(2, PlayerId::PLAYER2, ActorType::TOWER, 500,
-	                               500, physics::Vector(20, 30), false, 0);
+	                               500, physics::Vector(20, 30), false, 1);
 
 	// Let the soldier attack for a few turns, then switch it to move
 	soldier->Attack(target_tower);
@@ -0,0 +1,120 @@
+#include "physics/vector.h"
+#include "state/actor/soldier.h"
+#include "state/map/spatial_grid.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+
+class SpatialGridTest : public testing::Test {
+  protected:
+	int64_t map_size;
+
+	int64_t elt_size;
+
+	SpatialGrid grid;
+
+	vector<unique_ptr<Soldier>> soldiers;
+
+	SpatialGridTest() : map_size(10), elt_size(20), grid(10, 20) {
+		// Scatter soldiers over the map with a fixed pseudo random sequence
+		uint64_t seed = 42;
+		for (int i = 0; i < 60; ++i) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			auto x = (seed >> 33) % (map_size * elt_size);
+			auto y = (seed >> 13) % (map_size * elt_size);
+			soldiers.push_back(make_unique<Soldier>(
+			    i, PlayerId::PLAYER1, ActorType::SOLDIER, 100, 100,
+			    Vector(x, y), 5, 5, 40, nullptr, nullptr));
+			grid.Insert(soldiers.back().get());
+		}
+	}
+
+	// Soldiers within range of position, found by checking every soldier
+	vector<Soldier *> BruteForceInRange(Vector position, double range) {
+		vector<Soldier *> result;
+		for (auto &soldier : soldiers) {
+			if (position.distance(soldier->GetPosition()) <= range) {
+				result.push_back(soldier.get());
+			}
+		}
+		return result;
+	}
+
+	// The count soldiers nearest to position, found by sorting every soldier
+	vector<Soldier *> BruteForceNearest(Vector position, int64_t count) {
+		vector<Soldier *> result;
+		for (auto &soldier : soldiers) {
+			result.push_back(soldier.get());
+		}
+		stable_sort(result.begin(), result.end(), [&](Soldier *a, Soldier *b) {
+			return position.distance(a->GetPosition()) <
+			       position.distance(b->GetPosition());
+		});
+		result.resize(min(count, (int64_t)result.size()));
+		return result;
+	}
+
+	static vector<Soldier *> Sorted(vector<Soldier *> soldiers) {
+		sort(soldiers.begin(), soldiers.end());
+		return soldiers;
+	}
+};
+
+TEST_F(SpatialGridTest, RangeQueryMatchesBruteForce) {
+	vector<Soldier *> found;
+	for (auto position : {Vector(0, 0), Vector(100, 100), Vector(199, 5),
+	                      Vector(37.5, 160.2)}) {
+		for (double range : {0.0, 5.0, 20.0, 55.0, 300.0}) {
+			grid.GetSoldiersInRange(position, range, found);
+			ASSERT_EQ(Sorted(found),
+			          Sorted(BruteForceInRange(position, range)));
+		}
+	}
+}
+
+TEST_F(SpatialGridTest, NearestQueryMatchesBruteForce) {
+	vector<Soldier *> found;
+	for (auto position : {Vector(0, 0), Vector(100, 100), Vector(199, 5),
+	                      Vector(37.5, 160.2)}) {
+		for (int64_t count : {1, 3, 10, 60, 100}) {
+			grid.GetNearestSoldiers(position, count, found);
+			ASSERT_EQ(found, BruteForceNearest(position, count));
+		}
+	}
+
+	grid.GetNearestSoldiers(Vector(0, 0), 0, found);
+	ASSERT_TRUE(found.empty());
+}
+
+TEST_F(SpatialGridTest, UpdateFollowsMovedSoldiers) {
+	vector<Soldier *> found;
+
+	// Send every soldier to the opposite corner of the map
+	for (auto &soldier : soldiers) {
+		auto position = soldier->GetPosition();
+		soldier->SetPosition(Vector(map_size * elt_size - 1, 0) +
+		                     Vector(-position.x, position.y) / 100);
+		grid.UpdateSoldier(soldier.get());
+	}
+
+	grid.GetSoldiersInRange(Vector(map_size * elt_size - 1, 0), 3, found);
+	ASSERT_EQ(found.size(), soldiers.size());
+	grid.GetSoldiersInRange(Vector(0, 0), 100, found);
+	ASSERT_TRUE(found.empty());
+
+	// Removed soldiers are no longer found
+	grid.Remove(soldiers[0].get());
+	grid.GetNearestSoldiers(Vector(0, 0), 100, found);
+	ASSERT_EQ(found.size(), soldiers.size() - 1);
+	ASSERT_EQ(find(found.begin(), found.end(), soldiers[0].get()),
+	          found.end());
+
+	EXPECT_THROW(grid.UpdateSoldier(soldiers[0].get()), out_of_range);
+	EXPECT_THROW(grid.Remove(soldiers[0].get()), out_of_range);
+	EXPECT_THROW(grid.Insert(soldiers[1].get()), out_of_range);
+}
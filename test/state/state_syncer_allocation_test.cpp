@@ -0,0 +1,201 @@
+#include "constants/constants.h"
+#include "logger/interfaces/i_logger.h"
+#include "state/helpers/game_builder.h"
+#include "state/player_state.h"
+#include "state/state.h"
+#include "state/state_syncer/state_syncer.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+
+// This file replaces the global allocation functions, so it is built as a
+// test binary of its own rather than into the main tests binary
+
+namespace {
+// Number of calls made to the allocation functions by this test binary
+atomic<int64_t> num_allocations(0);
+
+void *CountedAllocate(size_t size) {
+	++num_allocations;
+	// malloc may return nullptr for a zero size, operator new may not
+	if (void *ptr = malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void *CountedAllocateNoThrow(size_t size) noexcept {
+	try {
+		return CountedAllocate(size);
+	} catch (const bad_alloc &) {
+		return nullptr;
+	}
+}
+
+#ifdef __cpp_aligned_new
+void *CountedAllocateAligned(size_t size, align_val_t alignment) {
+	++num_allocations;
+	// posix_memalign needs at least pointer alignment
+	auto min_alignment = max(static_cast<size_t>(alignment), sizeof(void *));
+	void *ptr = nullptr;
+	if (posix_memalign(&ptr, min_alignment, size == 0 ? 1 : size) == 0) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void *CountedAllocateAlignedNoThrow(size_t size,
+                                    align_val_t alignment) noexcept {
+	try {
+		return CountedAllocateAligned(size, alignment);
+	} catch (const bad_alloc &) {
+		return nullptr;
+	}
+}
+#endif
+}
+
+void *operator new(size_t size) { return CountedAllocate(size); }
+
+void *operator new[](size_t size) { return CountedAllocate(size); }
+
+void *operator new(size_t size, const nothrow_t &) noexcept {
+	return CountedAllocateNoThrow(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept {
+	return CountedAllocateNoThrow(size);
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete[](void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, const nothrow_t &) noexcept { free(ptr); }
+
+void operator delete[](void *ptr, const nothrow_t &) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+#ifdef __cpp_aligned_new
+void *operator new(size_t size, align_val_t alignment) {
+	return CountedAllocateAligned(size, alignment);
+}
+
+void *operator new[](size_t size, align_val_t alignment) {
+	return CountedAllocateAligned(size, alignment);
+}
+
+void *operator new(size_t size, align_val_t alignment,
+                   const nothrow_t &) noexcept {
+	return CountedAllocateAlignedNoThrow(size, alignment);
+}
+
+void *operator new[](size_t size, align_val_t alignment,
+                     const nothrow_t &) noexcept {
+	return CountedAllocateAlignedNoThrow(size, alignment);
+}
+
+void operator delete(void *ptr, align_val_t) noexcept { free(ptr); }
+
+void operator delete[](void *ptr, align_val_t) noexcept { free(ptr); }
+
+void operator delete(void *ptr, align_val_t, const nothrow_t &) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr, align_val_t, const nothrow_t &) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t, align_val_t) noexcept { free(ptr); }
+
+void operator delete[](void *ptr, size_t, align_val_t) noexcept { free(ptr); }
+#endif
+
+class StateSyncerAllocationTest : public testing::Test {
+  protected:
+	// Logger that keeps nothing, LogState is part of the turn but the logs
+	// are not what is being tested here
+	class NullLogger : public logger::ILogger {
+	  public:
+		void StartStream(std::ostream &) override {}
+		void LogState(IState *) override {}
+		void LogInstructionCount(PlayerId, int64_t) override {}
+		void LogTurnTime(PlayerId, int64_t, bool) override {}
+		void LogError(PlayerId, logger::ErrorType, int64_t, int64_t) override {}
+		void LogCommand(PlayerId, logger::CommandType, int64_t, int64_t,
+		                physics::Vector) override {}
+		void LogFinalGameParams() override {}
+		void WriteGame(std::ostream &) override {}
+	};
+
+	NullLogger logger;
+
+	unique_ptr<StateSyncer> state_syncer;
+
+	unique_ptr<player_state::State[]> player_states_storage;
+
+	vector<player_state::State *> player_states;
+
+	StateSyncerAllocationTest()
+	    : player_states_storage(make_unique<player_state::State[]>(2)) {
+		this->state_syncer =
+		    make_unique<StateSyncer>(BuildGame(), &logger,
+		                             TowerManager::build_costs, MAX_NUM_TOWERS);
+
+		player_states = {&player_states_storage[0], &player_states_storage[1]};
+	}
+
+	// Every player marches all their soldiers towards the middle of the map
+	void IssueCommands() {
+		auto middle = Vector(MAP_SIZE * MAP_ELEMENT_SIZE / 2,
+		                     MAP_SIZE * MAP_ELEMENT_SIZE / 2);
+		for (auto *player_state : player_states) {
+			for (auto &soldier : player_state->soldiers) {
+				soldier.destination = middle;
+			}
+		}
+	}
+};
+
+// Once the game is running, executing commands and refreshing the player
+// states should not touch the heap
+TEST_F(StateSyncerAllocationTest, SteadyStateTurnDoesNotAllocate) {
+	const vector<bool> skip_player_commands_flags(2, false);
+	state_syncer->UpdatePlayerStates(player_states);
+
+	// Let the syncer's scratch lists grow to their working size
+	for (int turn = 0; turn < 5; ++turn) {
+		IssueCommands();
+		state_syncer->ExecutePlayerCommands(player_states,
+		                                    skip_player_commands_flags);
+		state_syncer->UpdateMainState();
+		state_syncer->UpdatePlayerStates(player_states);
+	}
+
+	for (int turn = 0; turn < 5; ++turn) {
+		IssueCommands();
+		auto allocations_before = num_allocations.load();
+		state_syncer->ExecutePlayerCommands(player_states,
+		                                    skip_player_commands_flags);
+		auto execute_allocations = num_allocations.load() - allocations_before;
+
+		state_syncer->UpdateMainState();
+
+		allocations_before = num_allocations.load();
+		state_syncer->UpdatePlayerStates(player_states);
+		auto update_allocations = num_allocations.load() - allocations_before;
+
+		ASSERT_EQ(execute_allocations, 0);
+		ASSERT_EQ(update_allocations, 0);
+	}
+}
@@ -9,6 +9,7 @@
 #include "state/utilities.h"
 #include "gtest/gtest.h"
 #include <cstdint>
+#include <limits>
 
 using namespace std;
 using namespace state;
@@ -29,6 +30,8 @@ class StateSyncerTest : public Test {
 
 	std::vector<int64_t> player_money;
 
+	vector<Vector> dirty_map_offsets;
+
 	StateMock *state;
 
 	std::vector<player_state::State *> player_states;
@@ -41,13 +44,15 @@ class StateSyncerTest : public Test {
 
 	int64_t max_num_towers;
 
+	std::unique_ptr<ActorIdAllocator> actor_id_allocator;
+
 	StateSyncerTest()
 	    : logger(make_unique<LoggerMock>()), tower_build_costs({500, 700, 900}),
-	      max_num_towers(3) {
+	      max_num_towers(3),
+	      actor_id_allocator(make_unique<ActorIdAllocator>()) {
 
 		auto state = make_unique<StateMock>();
 
-		Actor::SetActorIdIncrement(0);
 		// Init PlayerStates
 		auto *player_state1 = new player_state::State();
 		auto *player_state2 = new player_state::State();
@@ -79,8 +84,9 @@ class StateSyncerTest : public Test {
 		std::vector<Soldier *> player1_soldiers;
 		for (int i = 0; i < player_state1->soldiers.size(); ++i) {
 			auto *soldier = new Soldier(
-			    Actor::GetNextActorId(), PlayerId::PLAYER1, ActorType::SOLDIER,
-			    100, 100, Vector(0, 0), 5, 5, 40, nullptr, nullptr);
+			    actor_id_allocator->GetNextActorId(), PlayerId::PLAYER1,
+			    ActorType::SOLDIER, 100, 100, Vector(0, 0), 5, 5, 40, nullptr,
+			    nullptr);
 			player1_soldiers.push_back(soldier);
 		}
 
@@ -91,8 +97,8 @@ class StateSyncerTest : public Test {
 		std::vector<Soldier *> player2_soldiers;
 		for (int i = 0; i < player_state2->soldiers.size(); ++i) {
 			auto *soldier = new Soldier(
-			    Actor::GetNextActorId(), PlayerId::PLAYER2, ActorType::SOLDIER,
-			    100, 100,
+			    actor_id_allocator->GetNextActorId(), PlayerId::PLAYER2,
+			    ActorType::SOLDIER, 100, 100,
 			    Vector(map_size * elt_size - 1, map_size * elt_size - 1), 5, 5,
 			    40, nullptr, nullptr);
 			// Last 7 soldiers of player2 are dead.
@@ -113,14 +119,14 @@ class StateSyncerTest : public Test {
 		}
 
 		// Init towers for state
-		auto *tower = new Tower(Actor::GetNextActorId(), PlayerId::PLAYER1,
-		                        ActorType::TOWER, 500, 500,
+		auto *tower = new Tower(actor_id_allocator->GetNextActorId(),
+		                        PlayerId::PLAYER1, ActorType::TOWER, 500, 500,
 		                        Vector(elt_size, elt_size), false, 1);
 		// Base Tower of player2
 		auto *tower2 = new Tower(
-		    Actor::GetNextActorId(), PlayerId::PLAYER2, ActorType::TOWER, 500,
-		    500, Vector(map_size * elt_size - 1, map_size * elt_size - 1), true,
-		    1);
+		    actor_id_allocator->GetNextActorId(), PlayerId::PLAYER2,
+		    ActorType::TOWER, 500, 500,
+		    Vector(map_size * elt_size - 1, map_size * elt_size - 1), true, 1);
 		vector<Tower *> player_towers;
 		vector<Tower *> player_towers2;
 		player_towers.push_back(tower);
@@ -166,6 +172,11 @@ class StateSyncerTest : public Test {
 
 		this->state = state.get();
 
+		EXPECT_CALL(*this->state, GetDirtyMapOffsets())
+		    .WillRepeatedly(ReturnRef(dirty_map_offsets));
+		EXPECT_CALL(*this->state, ClearDirtyMapOffsets())
+		    .Times(AnyNumber());
+
 		this->state_syncer = make_unique<StateSyncer>(
 		    std::move(state), logger.get(), tower_build_costs, max_num_towers);
 	}
@@ -178,9 +189,9 @@ TEST_F(StateSyncerTest, UpdationTest) {
 	// Adding another tower to second player to check addition of tower
 	auto towers2 = towers;
 
-	auto tower3 =
-	    new Tower(Actor::GetNextActorId(), PlayerId::PLAYER2, ActorType::TOWER,
-	              500, 500, Vector(4 * elt_size, 2 * elt_size), false, 1);
+	auto tower3 = new Tower(actor_id_allocator->GetNextActorId(),
+	                        PlayerId::PLAYER2, ActorType::TOWER, 500, 500,
+	                        Vector(4 * elt_size, 2 * elt_size), false, 1);
 	towers2[1].push_back(tower3);
 
 	// towers2
@@ -203,24 +214,24 @@ TEST_F(StateSyncerTest, UpdationTest) {
 	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
 
 	EXPECT_CALL(*state, GetMoney())
-	    .WillOnce(Return(player_money))
-	    .WillRepeatedly(Return(player_money2));
+	    .WillOnce(ReturnRef(player_money))
+	    .WillRepeatedly(ReturnRef(player_money2));
 
-	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(Return(soldiers));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
 
 	EXPECT_CALL(*state, GetAllTowers())
-	    .Times(5)
-	    .WillRepeatedly(Return(towers3))
+	    .Times(1)
+	    .WillRepeatedly(ReturnRef(towers3))
 	    .RetiresOnSaturation();
 
 	EXPECT_CALL(*state, GetAllTowers())
-	    .Times(5)
-	    .WillRepeatedly(Return(towers2))
+	    .Times(1)
+	    .WillRepeatedly(ReturnRef(towers2))
 	    .RetiresOnSaturation();
 
 	EXPECT_CALL(*state, GetAllTowers())
-	    .Times(5)
-	    .WillRepeatedly(Return(towers))
+	    .Times(1)
+	    .WillRepeatedly(ReturnRef(towers))
 	    .RetiresOnSaturation();
 
 	this->state_syncer->UpdatePlayerStates(player_states);
@@ -253,6 +264,29 @@ TEST_F(StateSyncerTest, UpdationTest) {
 	ASSERT_EQ(player_states[0]->soldiers[9].is_immune, true);
 	ASSERT_EQ(player_states[1]->enemy_soldiers[9].is_immune, true);
 
+	// Check for soldier grids, built from the flipped positions
+	auto &player_state2 = *player_states[1];
+	auto corner = Vector(map_size * elt_size - 1, map_size * elt_size - 1);
+	ASSERT_EQ(player_state::GetSoldiersInRange(player_state2.soldiers,
+	                                           player_state2.soldier_grid,
+	                                           Vector(0, 0), 1)
+	              .size(),
+	          NUM_SOLDIERS);
+	ASSERT_EQ(player_state::GetSoldiersInRange(
+	              player_state2.enemy_soldiers,
+	              player_state2.enemy_soldier_grid, Vector(0, 0), 1)
+	              .size(),
+	          0);
+	ASSERT_EQ(player_state::GetSoldiersInRange(
+	              player_state2.enemy_soldiers,
+	              player_state2.enemy_soldier_grid, corner, 1)
+	              .size(),
+	          NUM_SOLDIERS);
+	ASSERT_EQ(player_state::GetNearestSoldiers(player_state2.enemy_soldiers,
+	                                           player_state2.enemy_soldier_grid,
+	                                           Vector(0, 0), 3),
+	          vector<int64_t>({0, 1, 2}));
+
 	// Check for valid territory assignment for playerstates map
 
 	// For player1 this is the map (only tower position)
@@ -433,9 +467,9 @@ TEST_F(StateSyncerTest, ExecutionTest) {
 	auto player_money2 = player_money;
 	player_money2[1] = 900;
 
-	auto *tower3 =
-	    new Tower(Actor::GetNextActorId(), PlayerId::PLAYER2, ActorType::TOWER,
-	              500, 500, Vector(4 * elt_size, 2 * elt_size), false, 1);
+	auto *tower3 = new Tower(actor_id_allocator->GetNextActorId(),
+	                         PlayerId::PLAYER2, ActorType::TOWER, 500, 500,
+	                         Vector(4 * elt_size, 2 * elt_size), false, 1);
 	towers[1].push_back(tower3);
 
 	this->map->GetElementByXY(tower3->GetPosition())
@@ -464,17 +498,17 @@ TEST_F(StateSyncerTest, ExecutionTest) {
 	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
 
 	EXPECT_CALL(*state, GetMoney())
-	    .WillOnce(Return(player_money2))
+	    .WillOnce(ReturnRef(player_money2))
 	    .RetiresOnSaturation();
 
 	EXPECT_CALL(*state, GetMoney())
 	    .Times(3)
-	    .WillRepeatedly(Return(player_money))
+	    .WillRepeatedly(ReturnRef(player_money))
 	    .RetiresOnSaturation();
 
-	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(Return(soldiers));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
 
-	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(Return(towers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
 
 	this->state_syncer->UpdatePlayerStates(player_states);
 
@@ -485,57 +519,60 @@ TEST_F(StateSyncerTest, ExecutionTest) {
 	skip_player_command_flags.push_back(false);
 
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
-	                              ErrorType::NO_MULTIPLE_SOLDIER_TASKS, _))
+	                              ErrorType::NO_MULTIPLE_SOLDIER_TASKS, _, _))
 	    .Times(2);
 
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER2,
-	                              ErrorType::NO_MULTIPLE_SOLDIER_TASKS, _))
+	                              ErrorType::NO_MULTIPLE_SOLDIER_TASKS, _, _))
 	    .Times(1);
 
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
-	                              ErrorType::NO_MULTIPLE_TOWER_TASKS, _))
+	                              ErrorType::NO_MULTIPLE_TOWER_TASKS, _, _))
 	    .Times(1);
 
 	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER1, ErrorType::NO_ALTER_ACTOR_ID, _))
+	            LogError(PlayerId::PLAYER1, ErrorType::NO_ALTER_ACTOR_ID, _, _))
 	    .Times(3);
 
 	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER2, ErrorType::NO_ALTER_ACTOR_ID, _))
+	            LogError(PlayerId::PLAYER2, ErrorType::NO_ALTER_ACTOR_ID, _, _))
 	    .Times(1);
 
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER2,
-	                              ErrorType::NO_ACTION_BY_DEAD_SOLDIER, _))
+	                              ErrorType::NO_ACTION_BY_DEAD_SOLDIER, _, _))
 	    .Times(1);
 
 	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER1, ErrorType::INVALID_POSITION, _))
+	            LogError(PlayerId::PLAYER1, ErrorType::INVALID_POSITION, _, _))
 	    .Times(1);
 
-	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER1, ErrorType::NO_ATTACK_SELF_TOWER, _))
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
+	                              ErrorType::NO_ATTACK_SELF_TOWER, _, _))
 	    .Times(1);
 
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER2,
-	                              ErrorType::NO_ATTACK_SELF_SOLDIER, _))
+	                              ErrorType::NO_ATTACK_SELF_SOLDIER, _, _))
 	    .Times(1);
 
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
-	                              ErrorType::NO_ATTACK_DEAD_SOLDIER, _))
+	                              ErrorType::NO_ATTACK_DEAD_SOLDIER, _, _))
 	    .Times(1);
 
 	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER1, ErrorType::INVALID_TERRITORY, _))
+	            LogError(PlayerId::PLAYER1, ErrorType::INVALID_TERRITORY, _, _))
 	    .Times(2);
 
-	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER2, ErrorType::INSUFFICIENT_FUNDS, _))
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER2,
+	                              ErrorType::INSUFFICIENT_FUNDS, _, _))
 	    .Times(2);
 
-	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER1, ErrorType::NO_ATTACK_BASE_TOWER, _))
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
+	                              ErrorType::NO_ATTACK_BASE_TOWER, _, _))
 	    .Times(1);
 
+	// None of the commands are valid, so none are run or logged
+	EXPECT_CALL(*logger, LogCommand(_, _, _, _, _)).Times(0);
+
 	// Single soldier targeting soldier and tower
 	player_states[0]->soldiers[0].tower_target =
 	    player_states[0]->enemy_towers[0].id;
@@ -614,6 +651,9 @@ TEST_F(StateSyncerTest, ExecutionTest) {
 
 	// Resetting to default values
 	this->state_syncer->UpdatePlayerStates(player_states);
+	EXPECT_FALSE(player_states[0]->map[3][3].build_tower);
+	EXPECT_FALSE(player_states[0]->map[0][4].build_tower);
+	EXPECT_FALSE(player_states[1]->map[2][0].build_tower);
 
 	// Different soldiers given different valid jobs
 	player_states[1]->soldiers[0].tower_target =
@@ -675,24 +715,296 @@ TEST_F(StateSyncerTest, ExecutionTest) {
 	                        player_states[1]->soldiers[2].id,
 	                        player_states[1]->soldiers[2].soldier_target));
 
-	// Error call expectations in second round of execution.
+	// Each command run is logged, for replays
+	EXPECT_CALL(*logger, LogCommand(PlayerId::PLAYER2,
+	                                CommandType::ATTACK_ACTOR,
+	                                player_states[1]->soldiers[0].id,
+	                                player_states[1]->soldiers[0].tower_target,
+	                                _))
+	    .Times(1);
 	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER1, ErrorType::INSUFFICIENT_FUNDS, _))
+	            LogCommand(PlayerId::PLAYER1, CommandType::ATTACK_ACTOR,
+	                       player_states[0]->soldiers[1].id,
+	                       player_states[0]->soldiers[1].soldier_target, _))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogCommand(PlayerId::PLAYER2,
+	                                CommandType::MOVE_SOLDIER,
+	                                player_states[1]->soldiers[1].id, -1,
+	                                Vector(map_size * elt_size - 1 - 4,
+	                                       map_size * elt_size - 1 - 3)))
+	    .Times(1);
+	EXPECT_CALL(*logger,
+	            LogCommand(PlayerId::PLAYER1, CommandType::UPGRADE_TOWER,
+	                       player_states[0]->towers[0].id, -1, _))
+	    .Times(1);
+	EXPECT_CALL(*logger,
+	            LogCommand(PlayerId::PLAYER2, CommandType::SUICIDE_TOWER,
+	                       player_states[1]->towers[1].id, -1, _))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogCommand(PlayerId::PLAYER1,
+	                                CommandType::BUILD_TOWER, -1, -1,
+	                                Vector(0, 0)))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogCommand(PlayerId::PLAYER2,
+	                                CommandType::BUILD_TOWER, -1, -1,
+	                                Vector(4, 1)))
+	    .Times(1);
+	EXPECT_CALL(*logger,
+	            LogCommand(PlayerId::PLAYER2, CommandType::ATTACK_ACTOR,
+	                       player_states[1]->soldiers[2].id,
+	                       player_states[1]->soldiers[2].soldier_target, _))
+	    .Times(1);
+
+	// Error call expectations in second round of execution.
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
+	                              ErrorType::INSUFFICIENT_FUNDS, _, _))
 	    .Times(1);
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER2,
-	                              ErrorType::NO_SUICIDE_BASE_TOWER, _))
+	                              ErrorType::NO_SUICIDE_BASE_TOWER, _, _))
 	    .Times(1);
 	EXPECT_CALL(*logger,
-	            LogError(PlayerId::PLAYER2, ErrorType::NO_MORE_TOWERS, _))
+	            LogError(PlayerId::PLAYER2, ErrorType::NO_MORE_TOWERS, _, _))
 	    .Times(1);
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
-	                              ErrorType::NO_ATTACK_RAZED_TOWER, _))
+	                              ErrorType::NO_ATTACK_RAZED_TOWER, _, _))
 	    .Times(1);
 	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER2,
-	                              ErrorType::NO_ATTACK_IMMUNE_SOLDIER, _))
+	                              ErrorType::NO_ATTACK_IMMUNE_SOLDIER, _, _))
 	    .Times(1);
 
 	// Execute the commands
 	this->state_syncer->ExecutePlayerCommands(player_states,
 	                                          skip_player_command_flags);
 }
+
+// Commands issued through the command buffer are run in place of the
+// writables, while a player that issued none still has its writables read
+TEST_F(StateSyncerTest, CommandBufferTest) {
+	EXPECT_CALL(*logger, LogState(_)).WillRepeatedly(Return());
+	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
+	EXPECT_CALL(*state, GetMoney()).WillRepeatedly(ReturnRef(player_money));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
+
+	this->state_syncer->UpdatePlayerStates(player_states);
+
+	auto &player_state1 = *player_states[0];
+	auto &player_state2 = *player_states[1];
+	auto enemy_soldier_id = player_state1.enemy_soldiers[0].id;
+
+	EXPECT_TRUE(player_state::UpgradeTower(player_state1, 0));
+	EXPECT_TRUE(
+	    player_state::AttackSoldier(player_state1, 0, enemy_soldier_id));
+	EXPECT_TRUE(player_state::MoveSoldier(player_state1, 1, Vector(4, 3)));
+	// Soldier given two commands
+	EXPECT_TRUE(player_state::MoveSoldier(player_state1, 2, Vector(1, 1)));
+	EXPECT_TRUE(
+	    player_state::AttackSoldier(player_state1, 2, enemy_soldier_id));
+	// Commands for actors the player doesn't have
+	EXPECT_TRUE(
+	    player_state::MoveSoldier(player_state1, NUM_SOLDIERS, Vector(1, 1)));
+	EXPECT_TRUE(player_state::SuicideTower(player_state1, 1));
+	EXPECT_TRUE(player_state::BuildTower(player_state1, Vector(1, 2)));
+	EXPECT_EQ(player_state1.command_buffer.num_commands, 8);
+
+	// Writables are ignored once commands have been issued...
+	player_state1.soldiers[3].destination = Vector(2, 2);
+	player_state1.map[1][2].build_tower = true;
+	// ...but read for a player that issued none
+	player_state2.soldiers[1].destination = Vector(4, 3);
+
+	EXPECT_CALL(*logger, LogError(_, _, _, _)).Times(0);
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
+	                              ErrorType::NO_MULTIPLE_SOLDIER_TASKS,
+	                              player_state1.soldiers[2].id, _))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
+	                              ErrorType::INVALID_COMMAND, -1, 5))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
+	                              ErrorType::INVALID_COMMAND, -1, 6))
+	    .Times(1);
+
+	EXPECT_CALL(*state, MoveSoldier(_, _, _)).Times(0);
+	EXPECT_CALL(*state, AttackActor(_, _, _)).Times(0);
+	EXPECT_CALL(*state, UpgradeTower(PlayerId::PLAYER1,
+	                                 player_state1.towers[0].id))
+	    .Times(1);
+	EXPECT_CALL(*state, AttackActor(PlayerId::PLAYER1,
+	                                player_state1.soldiers[0].id,
+	                                enemy_soldier_id))
+	    .Times(1);
+	EXPECT_CALL(*state, MoveSoldier(PlayerId::PLAYER1,
+	                                player_state1.soldiers[1].id,
+	                                Vector(4, 3)))
+	    .Times(1);
+	EXPECT_CALL(*state, BuildTower(PlayerId::PLAYER1, Vector(1, 2)))
+	    .Times(1);
+	EXPECT_CALL(*state, MoveSoldier(PlayerId::PLAYER2,
+	                                player_state2.soldiers[1].id,
+	                                Vector(map_size * elt_size - 1 - 4,
+	                                       map_size * elt_size - 1 - 3)))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogCommand(_, _, _, _, _)).Times(5);
+
+	this->state_syncer->ExecutePlayerCommands(player_states, {false, false});
+
+	// The next turn starts with empty command buffers, and the writables of
+	// the elements built on reset
+	this->state_syncer->UpdatePlayerStates(player_states);
+	EXPECT_EQ(player_state1.command_buffer.num_commands, 0);
+	EXPECT_EQ(player_state2.command_buffer.num_commands, 0);
+	EXPECT_FALSE(player_state1.map[1][2].build_tower);
+}
+
+// Commands issued while the command buffer is full are dropped and reported
+TEST_F(StateSyncerTest, CommandBufferFullTest) {
+	EXPECT_CALL(*logger, LogState(_)).WillRepeatedly(Return());
+	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
+	EXPECT_CALL(*state, GetMoney()).WillRepeatedly(ReturnRef(player_money));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
+
+	this->state_syncer->UpdatePlayerStates(player_states);
+
+	auto &player_state1 = *player_states[0];
+	for (int i = 0; i < MAX_NUM_COMMANDS; ++i) {
+		EXPECT_TRUE(player_state::UpgradeTower(player_state1, 0));
+	}
+	EXPECT_FALSE(player_state::UpgradeTower(player_state1, 0));
+	EXPECT_EQ(player_state1.command_buffer.num_commands, MAX_NUM_COMMANDS);
+	EXPECT_TRUE(player_state1.command_buffer.has_dropped_commands);
+
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
+	                              ErrorType::NO_MORE_COMMANDS, _, _))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogError(PlayerId::PLAYER1,
+	                              ErrorType::NO_MULTIPLE_TOWER_TASKS,
+	                              player_state1.towers[0].id, _))
+	    .Times(1);
+	EXPECT_CALL(*state, UpgradeTower(_, _)).Times(0);
+
+	this->state_syncer->ExecutePlayerCommands(player_states, {false, true});
+
+	this->state_syncer->UpdatePlayerStates(player_states);
+	EXPECT_EQ(player_state1.command_buffer.num_commands, 0);
+	EXPECT_FALSE(player_state1.command_buffer.has_dropped_commands);
+}
+
+// Positions and offsets in commands that aren't finite are rejected, rather
+// than used to index the map
+TEST_F(StateSyncerTest, NonFiniteCommandTest) {
+	EXPECT_CALL(*logger, LogState(_)).WillRepeatedly(Return());
+	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
+	EXPECT_CALL(*state, GetMoney()).WillRepeatedly(ReturnRef(player_money));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
+
+	this->state_syncer->UpdatePlayerStates(player_states);
+
+	const double nan = numeric_limits<double>::quiet_NaN();
+	const double inf = numeric_limits<double>::infinity();
+	auto &player_state1 = *player_states[0];
+	auto &player_state2 = *player_states[1];
+
+	player_state::MoveSoldier(player_state1, 0, Vector(nan, 0));
+	player_state::MoveSoldier(player_state1, 1, Vector(0, inf));
+	player_state::MoveSoldier(player_state1, 2, Vector(-inf, -inf));
+	player_state::BuildTower(player_state1, Vector(nan, 1));
+	player_state::BuildTower(player_state1, Vector(1, inf));
+	player_state::BuildTower(player_state1, Vector(-inf, 0));
+	player_state::MoveSoldier(player_state2, 0, Vector(nan, nan));
+	player_state::BuildTower(player_state2, Vector(inf, -inf));
+
+	EXPECT_CALL(*logger, LogError(_, _, _, _)).Times(0);
+	EXPECT_CALL(*logger,
+	            LogError(PlayerId::PLAYER1, ErrorType::INVALID_POSITION, _, _))
+	    .Times(3);
+	EXPECT_CALL(*logger,
+	            LogError(PlayerId::PLAYER1, ErrorType::INVALID_TERRITORY, _, _))
+	    .Times(3);
+	EXPECT_CALL(*logger,
+	            LogError(PlayerId::PLAYER2, ErrorType::INVALID_POSITION, _, _))
+	    .Times(1);
+	EXPECT_CALL(*logger,
+	            LogError(PlayerId::PLAYER2, ErrorType::INVALID_TERRITORY, _, _))
+	    .Times(1);
+	EXPECT_CALL(*state, MoveSoldier(_, _, _)).Times(0);
+	EXPECT_CALL(*state, BuildTower(_, _)).Times(0);
+	EXPECT_CALL(*logger, LogCommand(_, _, _, _, _)).Times(0);
+
+	this->state_syncer->ExecutePlayerCommands(player_states, {false, false});
+}
+
+// A tower is built only once on an element the player asked for twice in a
+// turn, and paid for once
+TEST_F(StateSyncerTest, RepeatedBuildTowerTest) {
+	EXPECT_CALL(*logger, LogState(_)).WillRepeatedly(Return());
+	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
+	EXPECT_CALL(*state, GetMoney()).WillRepeatedly(ReturnRef(player_money));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
+
+	this->state_syncer->UpdatePlayerStates(player_states);
+
+	auto &player_state1 = *player_states[0];
+	EXPECT_TRUE(player_state::BuildTower(player_state1, Vector(1, 2)));
+	EXPECT_TRUE(player_state::BuildTower(player_state1, Vector(1, 2)));
+
+	EXPECT_CALL(*logger, LogError(_, _, _, _)).Times(0);
+	EXPECT_CALL(*logger,
+	            LogError(PlayerId::PLAYER1, ErrorType::INVALID_TERRITORY, _, _))
+	    .Times(1);
+	EXPECT_CALL(*state, BuildTower(_, _)).Times(0);
+	EXPECT_CALL(*state, BuildTower(PlayerId::PLAYER1, Vector(1, 2)))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogCommand(_, _, _, _, _)).Times(1);
+
+	this->state_syncer->ExecutePlayerCommands(player_states, {false, false});
+
+	// The element can be asked for again the next turn
+	this->state_syncer->UpdatePlayerStates(player_states);
+	EXPECT_TRUE(player_state::BuildTower(player_state1, Vector(1, 2)));
+	EXPECT_CALL(*state, BuildTower(PlayerId::PLAYER1, Vector(1, 2)))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogCommand(_, _, _, _, _)).Times(1);
+
+	this->state_syncer->ExecutePlayerCommands(player_states, {false, false});
+}
+
+// Enemy actors are found by id even when they aren't kept in the order of
+// their ids
+TEST_F(StateSyncerTest, UnorderedTargetTest) {
+	auto *tower = new Tower(actor_id_allocator->GetNextActorId(),
+	                        PlayerId::PLAYER2, ActorType::TOWER, 500, 500,
+	                        Vector(2 * elt_size, 4 * elt_size), false, 1);
+	towers[1].insert(towers[1].begin(), tower);
+	swap(soldiers[1][0], soldiers[1][1]);
+
+	EXPECT_CALL(*logger, LogState(_)).WillRepeatedly(Return());
+	EXPECT_CALL(*state, GetMap()).WillRepeatedly(Return(map.get()));
+	EXPECT_CALL(*state, GetMoney()).WillRepeatedly(ReturnRef(player_money));
+	EXPECT_CALL(*state, GetAllSoldiers()).WillRepeatedly(ReturnRef(soldiers));
+	EXPECT_CALL(*state, GetAllTowers()).WillRepeatedly(ReturnRef(towers));
+
+	this->state_syncer->UpdatePlayerStates(player_states);
+
+	auto &player_state1 = *player_states[0];
+	EXPECT_TRUE(
+	    player_state::AttackTower(player_state1, 0, tower->GetActorId()));
+	EXPECT_TRUE(player_state::AttackSoldier(player_state1, 1,
+	                                        soldiers[1][0]->GetActorId()));
+
+	EXPECT_CALL(*logger, LogError(_, _, _, _)).Times(0);
+	EXPECT_CALL(*state, AttackActor(PlayerId::PLAYER1,
+	                                player_state1.soldiers[0].id,
+	                                tower->GetActorId()))
+	    .Times(1);
+	EXPECT_CALL(*state, AttackActor(PlayerId::PLAYER1,
+	                                player_state1.soldiers[1].id,
+	                                soldiers[1][0]->GetActorId()))
+	    .Times(1);
+	EXPECT_CALL(*logger, LogCommand(_, _, _, _, _)).Times(2);
+
+	this->state_syncer->ExecutePlayerCommands(player_states, {false, false});
+}
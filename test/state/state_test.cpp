@@ -0,0 +1,220 @@
+#include "state/helpers/game_builder.h"
+#include "state/state.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace state;
+using namespace physics;
+
+class StateTest : public testing::Test {
+  protected:
+	const static int map_size;
+	const static int elt_size;
+	const static int num_soldiers;
+	const static int num_turns;
+	const static vector<Vector> base_positions;
+
+	// Settings of a game with a few soldiers per player
+	static GameSettings GetGameSettings() {
+		GameSettings settings;
+		settings.map_size = map_size;
+		settings.element_size = elt_size;
+		settings.num_soldiers = num_soldiers;
+		settings.base_positions = base_positions;
+		settings.soldier_hp = 100;
+		settings.soldier_speed = 5;
+		settings.soldier_attack_range = 20;
+		settings.soldier_attack_damage = 10;
+		settings.base_tower_hp = 500;
+		settings.money_start = 5000;
+		settings.money_max = 100000;
+		settings.tower_kill_rewards = {100, 300, 1000};
+		settings.soldier_kill_reward = 100;
+		settings.tower_suicide_rewards = {200, 250, 300};
+		return settings;
+	}
+
+	// Plays a game where soldiers march on the enemy base and towers are
+	// built and destroyed along the way. Returns a trace of every turn
+	static string RunGame() {
+		auto state = BuildGame(GetGameSettings());
+		ostringstream trace;
+
+		for (int turn = 0; turn < num_turns; ++turn) {
+			for (int player_id = 0; player_id < 2; ++player_id) {
+				auto player = static_cast<PlayerId>(player_id);
+				auto enemy_base = base_positions[(player_id + 1) % 2];
+
+				for (int i = 0; i < num_soldiers; ++i) {
+					state->MoveSoldier(player, player_id * num_soldiers + i,
+					                   enemy_base);
+				}
+
+				// New towers get their ids while the game is running
+				if (turn % 20 == 5) {
+					auto base_offset =
+					    (base_positions[player_id] / elt_size).floor();
+					auto step = 1 - 2 * player_id;
+					state->BuildTower(player, base_offset + Vector(step, step));
+				} else if (turn % 20 == 15) {
+					auto towers = state->GetAllTowers()[player_id];
+					state->SuicideTower(player, towers.back()->GetActorId());
+				}
+			}
+
+			state->Update();
+
+			trace << "turn " << turn << "\n";
+			for (const auto &player_soldiers : state->GetAllSoldiers()) {
+				for (auto *soldier : player_soldiers) {
+					trace << soldier->GetActorId() << " " << soldier->GetHp()
+					      << " " << soldier->GetPosition() << "\n";
+				}
+			}
+			for (const auto &player_towers : state->GetAllTowers()) {
+				for (auto *tower : player_towers) {
+					trace << tower->GetActorId() << " " << tower->GetHp()
+					      << "\n";
+				}
+			}
+			for (auto money : state->GetMoney()) {
+				trace << money << "\n";
+			}
+		}
+
+		return trace.str();
+	}
+
+	// Plays a game where soldiers keep switching between moving, chasing and
+	// attacking enemy soldiers and towers, so they go through every soldier
+	// state, die and respawn. Returns a trace of every turn
+	static string RunBattle() {
+		auto state = BuildGame(GetGameSettings());
+		ostringstream trace;
+
+		for (int turn = 0; turn < num_turns; ++turn) {
+			for (int player_id = 0; player_id < 2; ++player_id) {
+				auto player = static_cast<PlayerId>(player_id);
+				auto enemy_id = (player_id + 1) % 2;
+
+				for (int i = 0; i < num_soldiers; ++i) {
+					// Soldiers only get new orders every few turns
+					if ((turn + i) % 5 != 0) {
+						continue;
+					}
+
+					auto soldier_id = player_id * num_soldiers + i;
+					auto &enemy_towers = state->GetAllTowers()[enemy_id];
+					if ((turn + i) % 25 < 8) {
+						state->MoveSoldier(player, soldier_id,
+						                   base_positions[enemy_id]);
+					} else if (i % 3 == 0 && !enemy_towers.empty()) {
+						state->AttackActor(player, soldier_id,
+						                   enemy_towers.front()->GetActorId());
+					} else {
+						auto target_id = enemy_id * num_soldiers +
+						                 (i + turn / 7) % num_soldiers;
+						state->AttackActor(player, soldier_id, target_id);
+					}
+				}
+			}
+
+			state->Update();
+
+			trace << "turn " << turn << "\n";
+			for (const auto &player_soldiers : state->GetAllSoldiers()) {
+				for (auto *soldier : player_soldiers) {
+					trace << soldier->GetActorId() << " " << soldier->GetHp()
+					      << " " << soldier->GetPosition() << " "
+					      << static_cast<int>(soldier->GetState()) << " "
+					      << soldier->IsInvulnerable() << "\n";
+				}
+			}
+			for (const auto &player_towers : state->GetAllTowers()) {
+				for (auto *tower : player_towers) {
+					trace << tower->GetActorId() << " " << tower->GetHp()
+					      << "\n";
+				}
+			}
+			for (auto money : state->GetMoney()) {
+				trace << money << "\n";
+			}
+		}
+
+		return trace.str();
+	}
+
+	// 64 bit FNV-1a hash, stable across platforms unlike std::hash
+	static uint64_t Hash(const string &data) {
+		uint64_t hash = 14695981039346656037ULL;
+		for (auto byte : data) {
+			hash ^= static_cast<uint8_t>(byte);
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+};
+
+const int StateTest::map_size = 10;
+const int StateTest::elt_size = 10;
+const int StateTest::num_soldiers = 5;
+const int StateTest::num_turns = 200;
+const vector<Vector> StateTest::base_positions = {Vector(15, 15),
+                                                  Vector(85, 85)};
+
+// Games running at the same time on different threads must not affect each
+// other, so every run should give the same trace
+TEST_F(StateTest, ConcurrentGamesDeterministic) {
+	const auto expected_trace = RunGame();
+
+	// Rerun the game in the same thread with a fresh state
+	EXPECT_EQ(RunGame(), expected_trace);
+
+	for (int run = 0; run < 5; ++run) {
+		vector<string> traces(2);
+		vector<thread> game_runners;
+		for (auto &trace : traces) {
+			game_runners.emplace_back([&trace] { trace = RunGame(); });
+		}
+		for (auto &game_runner : game_runners) {
+			game_runner.join();
+		}
+
+		for (const auto &trace : traces) {
+			ASSERT_EQ(trace, expected_trace);
+		}
+	}
+}
+
+// Soldier behaviour must not change while the soldier code is reworked. The
+// expected hash is of a trace recorded before any such rework
+TEST_F(StateTest, BattleReplayMatchesRecording) {
+	auto trace = RunBattle();
+	EXPECT_EQ(Hash(trace), 9563888977030483514ULL);
+}
+
+// Games that played out the same hash the same, and the hash changes with
+// the state
+TEST_F(StateTest, HashTracksState) {
+	auto state = BuildGame(GetGameSettings());
+	auto other_state = BuildGame(GetGameSettings());
+	EXPECT_EQ(state->GetHash(), other_state->GetHash());
+
+	state->MoveSoldier(PlayerId::PLAYER1, 0, base_positions[1]);
+	state->Update();
+	EXPECT_NE(state->GetHash(), other_state->GetHash());
+
+	other_state->MoveSoldier(PlayerId::PLAYER1, 0, base_positions[1]);
+	other_state->Update();
+	EXPECT_EQ(state->GetHash(), other_state->GetHash());
+
+	// Building a tower changes the money and the territory
+	state->BuildTower(PlayerId::PLAYER1, Vector(2, 2));
+	state->Update();
+	other_state->Update();
+	EXPECT_NE(state->GetHash(), other_state->GetHash());
+}
@@ -23,6 +23,7 @@ class TowerManagerTest : public testing::Test {
 
 	unique_ptr<IMap> map;
 	vector<vector<MapElement>> grid;
+	unique_ptr<ActorIdAllocator> actor_id_allocator;
 	int map_size;
 	int elt_size;
 
@@ -64,9 +65,12 @@ class TowerManagerTest : public testing::Test {
 
 		this->map = make_unique<Map>(grid, elt_size);
 
+		this->actor_id_allocator = make_unique<ActorIdAllocator>();
+
 		// Init Tower Manager
 		this->tower_manager = make_unique<TowerManager>(
-		    std::move(towers), player_id, money_manager.get(), map.get());
+		    std::move(towers), player_id, money_manager.get(), map.get(),
+		    actor_id_allocator.get());
 	}
 };
 
@@ -123,7 +127,7 @@ TEST_F(TowerManagerTest, ValidBuildTowerTest) {
 }
 
 TEST_F(TowerManagerTest, ValidUpgradeTower) {
-	Actor::SetActorIdIncrement(0);
+	actor_id_allocator->SetNextActorId(0);
 	// Build a Valid Tower
 	map->GetElementByOffset(Vector(1, 1)).SetOwnership(PlayerId::PLAYER1, true);
 	tower_manager->BuildTower(Vector(1, 1));
@@ -159,7 +163,7 @@ TEST_F(TowerManagerTest, ValidUpgradeTower) {
 }
 
 TEST_F(TowerManagerTest, SuicideTower) {
-	Actor::SetActorIdIncrement(0);
+	actor_id_allocator->SetNextActorId(0);
 	// Build a Valid Tower
 	map->GetElementByOffset(Vector(1, 1)).SetOwnership(PlayerId::PLAYER1, true);
 	tower_manager->BuildTower(Vector(1, 1)); // actor_id -> 0
@@ -180,7 +184,7 @@ TEST_F(TowerManagerTest, SuicideTower) {
 }
 
 TEST_F(TowerManagerTest, TerritoryTest) {
-	Actor::SetActorIdIncrement(1);
+	actor_id_allocator->SetNextActorId(1);
 	tower_manager->BuildTower(Vector(1, 1)); // actor_id -> 1
 	tower_manager->BuildTower(Vector(1, 0)); // actor_id -> 2
 	tower_manager->BuildTower(Vector(0, 1)); // actor_id -> 3
@@ -246,17 +250,18 @@ TEST_F(TowerManagerTest, TerritoryTest) {
 }
 
 TEST_F(TowerManagerTest, AdjacentBuildTower) {
-	Actor::SetActorIdIncrement(0);
+	actor_id_allocator->SetNextActorId(0);
 
 	// Make a tower via tower manager constructor at offset (0, 1) for player 2
 	vector<unique_ptr<Tower>> towers_enemy;
 	towers_enemy.push_back(make_unique<Tower>(
-	    Actor::GetNextActorId(), PlayerId::PLAYER2, ActorType::TOWER,
-	    Tower::max_hp_levels[0], Tower::max_hp_levels[0],
+	    actor_id_allocator->GetNextActorId(), PlayerId::PLAYER2,
+	    ActorType::TOWER, Tower::max_hp_levels[0], Tower::max_hp_levels[0],
 	    Vector(0, map->GetElementSize()), true, 1));
 
 	auto tower_manager_2 = make_unique<TowerManager>(
-	    move(towers_enemy), PlayerId::PLAYER2, money_manager.get(), map.get());
+	    move(towers_enemy), PlayerId::PLAYER2, money_manager.get(), map.get(),
+	    actor_id_allocator.get());
 
 	// Build player 1 tower adjacent to player 2's tower
 	tower_manager->BuildTower(Vector(0, 0));
@@ -291,3 +296,38 @@ TEST_F(TowerManagerTest, AdjacentBuildTower) {
 		}
 	}
 }
+
+TEST_F(TowerManagerTest, DirtyOffsetsTest) {
+	actor_id_allocator->SetNextActorId(0);
+	auto range = TowerManager::tower_ranges[0];
+	auto territory_size = (range + 1) * (range + 1);
+
+	// Every newly owned offset is reported once
+	tower_manager->BuildTower(Vector(0, 0)); // actor_id -> 0
+	tower_manager->Update();
+	auto dirty_offsets = tower_manager->GetDirtyOffsets();
+	ASSERT_EQ(dirty_offsets.size(), territory_size);
+	for (auto &offset : dirty_offsets) {
+		EXPECT_TRUE(map->GetElementByOffset(offset).GetOwnership()[0]);
+	}
+
+	// Nothing is reported after the offsets have been cleared
+	tower_manager->ClearDirtyOffsets();
+	tower_manager->Update();
+	ASSERT_EQ(tower_manager->GetDirtyOffsets().size(), 0);
+
+	// Overlapping territory does not change ownership, so only the offsets
+	// past the first tower's range are reported
+	tower_manager->BuildTower(Vector(1, 0)); // actor_id -> 1
+	tower_manager->Update();
+	ASSERT_EQ(tower_manager->GetDirtyOffsets().size(), range + 1);
+	tower_manager->ClearDirtyOffsets();
+
+	// Offsets are reported again once they are no longer owned
+	tower_manager->SuicideTower(1);
+	tower_manager->Update();
+	ASSERT_EQ(tower_manager->GetDirtyOffsets().size(), range + 1);
+	for (auto &offset : tower_manager->GetDirtyOffsets()) {
+		EXPECT_FALSE(map->GetElementByOffset(offset).GetOwnership()[0]);
+	}
+}